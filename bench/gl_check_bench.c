@@ -0,0 +1,254 @@
+/*
+ * CPU cost per frame of GL error checking (make bench-gl-checks)
+ *
+ * Replays the GL calls of a Shadertoy frame (program, uniforms, four iChannel
+ * bindings, quad) into a small offscreen target on a surfaceless EGL context,
+ * checking each call with GL_CHECK() as render_shader_pass does. The target
+ * is kept small so the measurement is the submission cost, not shading.
+ * The frame loop runs with the debug layer off (release builds) and on
+ * (--gl-debug, the old always-on glGetError behaviour) and reports
+ * render-thread CPU time and wall time per frame for both. Wall time shows
+ * stalls: with a threaded GL front end (mesa_glthread=true, most desktop
+ * drivers) every glGetError waits for the driver thread to catch up.
+ *
+ * Needs a driver with EGL_MESA_platform_surfaceless (Mesa, including
+ * llvmpipe) or a pbuffer-capable default display.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "gl_debug.h"
+
+#define BENCH_WIDTH 64
+#define BENCH_HEIGHT 64
+#define BENCH_FRAMES 20000
+#define BENCH_CHANNELS 4
+
+static const char *vertex_src =
+    "attribute vec2 position;\n"
+    "void main() { gl_Position = vec4(position, 0.0, 1.0); }\n";
+
+/* Cheap on the GPU so the CPU side of the frame dominates */
+static const char *fragment_src =
+    "precision mediump float;\n"
+    "uniform float iTime;\n"
+    "uniform vec3 iResolution;\n"
+    "uniform vec4 iMouse;\n"
+    "uniform float iTimeDelta;\n"
+    "uniform int iFrame;\n"
+    "uniform sampler2D iChannel0;\n"
+    "uniform sampler2D iChannel1;\n"
+    "uniform sampler2D iChannel2;\n"
+    "uniform sampler2D iChannel3;\n"
+    "void main() {\n"
+    "    vec2 uv = gl_FragCoord.xy / iResolution.xy;\n"
+    "    gl_FragColor = texture2D(iChannel0, uv) * 0.25 + texture2D(iChannel1, uv) * 0.25 +\n"
+    "                   texture2D(iChannel2, uv) * 0.25 + texture2D(iChannel3, uv) * 0.25 +\n"
+    "                   vec4(sin(iTime), iMouse.x, iTimeDelta, float(iFrame)) * 0.001;\n"
+    "}\n";
+
+static const float quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool make_context(void) {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "No EGL display\n");
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT, EGL_NONE };
+    EGLConfig config = NULL;
+    EGLint count = 0;
+    eglChooseConfig(display, config_attribs, &config, 1, &count);
+
+    const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    EGLContext context = eglCreateContext(display, count > 0 ? config : NULL, EGL_NO_CONTEXT,
+                                          context_attribs);
+    if (context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        fprintf(stderr, "Failed to create a surfaceless GLES2 context\n");
+        return false;
+    }
+    return true;
+}
+
+static GLuint compile(GLenum type, const char *src) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char info[1024];
+        glGetShaderInfoLog(shader, sizeof(info), NULL, info);
+        fprintf(stderr, "Shader compile failed: %s\n", info);
+        exit(1);
+    }
+    return shader;
+}
+
+struct frame_state {
+    GLuint program;
+    GLint time, resolution, mouse, time_delta, frame;
+    GLint channels[BENCH_CHANNELS];
+    GLuint textures[BENCH_CHANNELS];
+};
+
+/* One frame's worth of render_shader_pass calls */
+static bool draw_frame(const struct frame_state *s, int frame) {
+    GL_CLEAR_ERRORS();
+    glUseProgram(s->program);
+    if (!GL_CHECK("after glUseProgram")) {
+        return false;
+    }
+    glUniform1f(s->time, (float)frame / 60.0f);
+    if (!GL_CHECK("after iTime")) {
+        return false;
+    }
+    glUniform3f(s->resolution, BENCH_WIDTH, BENCH_HEIGHT, 1.0f);
+    if (!GL_CHECK("after iResolution")) {
+        return false;
+    }
+    glUniform4f(s->mouse, 0.0f, 0.0f, 0.0f, 0.0f);
+    if (!GL_CHECK("after iMouse")) {
+        return false;
+    }
+    glUniform1f(s->time_delta, 1.0f / 60.0f);
+    if (!GL_CHECK("after iTimeDelta")) {
+        return false;
+    }
+    glUniform1i(s->frame, frame);
+    if (!GL_CHECK("after iFrame")) {
+        return false;
+    }
+    for (int i = 0; i < BENCH_CHANNELS; i++) {
+        glActiveTexture(GL_TEXTURE0 + (GLenum)i);
+        if (!GL_CHECK("after glActiveTexture(%d)", i)) {
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, s->textures[i]);
+        if (!GL_CHECK("after glBindTexture(iChannel%d)", i)) {
+            return false;
+        }
+    }
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+    if (!GL_CHECK("after glVertexAttribPointer")) {
+        return false;
+    }
+    glEnableVertexAttribArray(0);
+    if (!GL_CHECK("after glEnableVertexAttribArray")) {
+        return false;
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    if (!GL_CHECK("after glDrawArrays")) {
+        return false;
+    }
+    glDisableVertexAttribArray(0);
+    if (!GL_CHECK("after glDisableVertexAttribArray")) {
+        return false;
+    }
+    glFlush();
+    return true;
+}
+
+struct frame_cost {
+    double cpu_ms;
+    double wall_ms;
+};
+
+static struct frame_cost run(const struct frame_state *s, bool checks) {
+    gl_debug_active = checks;
+    for (int i = 0; i < 100; i++) {
+        draw_frame(s, i);
+    }
+    glFinish();
+
+    uint64_t cpu_start = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t wall_start = clock_ns(CLOCK_MONOTONIC);
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        if (!draw_frame(s, i)) {
+            fprintf(stderr, "GL error in frame %d\n", i);
+            break;
+        }
+    }
+    glFinish();
+    struct frame_cost cost = {
+        .cpu_ms = (double)(clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e6 / BENCH_FRAMES,
+        .wall_ms = (double)(clock_ns(CLOCK_MONOTONIC) - wall_start) / 1e6 / BENCH_FRAMES,
+    };
+    return cost;
+}
+
+int main(void) {
+    if (!make_context()) {
+        return 1;
+    }
+    printf("GL: %s / %s\n", (const char *)glGetString(GL_RENDERER),
+           (const char *)glGetString(GL_VERSION));
+
+    struct frame_state s;
+    s.program = glCreateProgram();
+    glAttachShader(s.program, compile(GL_VERTEX_SHADER, vertex_src));
+    glAttachShader(s.program, compile(GL_FRAGMENT_SHADER, fragment_src));
+    glBindAttribLocation(s.program, 0, "position");
+    glLinkProgram(s.program);
+    s.time = glGetUniformLocation(s.program, "iTime");
+    s.resolution = glGetUniformLocation(s.program, "iResolution");
+    s.mouse = glGetUniformLocation(s.program, "iMouse");
+    s.time_delta = glGetUniformLocation(s.program, "iTimeDelta");
+    s.frame = glGetUniformLocation(s.program, "iFrame");
+
+    glUseProgram(s.program);
+    static uint8_t texels[256 * 256 * 4];
+    for (size_t i = 0; i < sizeof(texels); i++) {
+        texels[i] = (uint8_t)(i * 131u);
+    }
+    glGenTextures(BENCH_CHANNELS, s.textures);
+    for (int i = 0; i < BENCH_CHANNELS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "iChannel%d", i);
+        s.channels[i] = glGetUniformLocation(s.program, name);
+        glUniform1i(s.channels[i], i);
+        glBindTexture(GL_TEXTURE_2D, s.textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+
+    GLuint target, fbo;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BENCH_WIDTH, BENCH_HEIGHT, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, NULL);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+
+    struct frame_cost off = run(&s, false);
+    struct frame_cost on = run(&s, true);
+    printf("%d frames at %dx%d, per frame:\n", BENCH_FRAMES, BENCH_WIDTH, BENCH_HEIGHT);
+    printf("  checks off (release):       cpu %.4f ms  wall %.4f ms\n", off.cpu_ms, off.wall_ms);
+    printf("  checks on (--gl-debug/old): cpu %.4f ms  wall %.4f ms\n", on.cpu_ms, on.wall_ms);
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * PNG streaming decode: peak memory and output check
+ *
+ * Writes synthetic PNGs and loads them for a 3840x2160 display with
+ * image_load(). A non-interlaced file streams its rows through the
+ * resampler; the same pixels saved interlaced take the decode-then-scale
+ * path, so the pair compares both paths through the public API.
+ *
+ * Peak RSS of each path is measured in its own forked child on a
+ * 10000x10000 image. The streamed result must match the batch result byte
+ * for byte in every display mode, and must peak well below it.
+ *
+ * Build and run: make bench-png-stream
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <png.h>
+#include "neowall.h"
+
+#define BIG_SIZE 10000
+#define DISPLAY_WIDTH 3840
+#define DISPLAY_HEIGHT 2160
+
+static bool write_png(const char *path, uint32_t width, uint32_t height, bool interlaced) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info = png ? png_create_info_struct(png) : NULL;
+    uint8_t *row = malloc((size_t)width * 3);
+    if (!png || !info || !row || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        free(row);
+        fclose(fp);
+        return false;
+    }
+
+    png_init_io(png, fp);
+    png_set_compression_level(png, 1);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB,
+                 interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+
+    /* Detail at every scale so each filter tap matters */
+    int passes = png_set_interlace_handling(png);
+    for (int pass = 0; pass < passes; pass++) {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                row[x * 3] = (uint8_t)(x * 7 + y);
+                row[x * 3 + 1] = (uint8_t)((x * x + y * 3) >> 5);
+                row[x * 3 + 2] = (uint8_t)((y * 13) ^ x);
+            }
+            png_write_row(png, row);
+        }
+    }
+
+    png_write_end(png, info);
+    png_destroy_write_struct(&png, &info);
+    free(row);
+    return fclose(fp) == 0;
+}
+
+/* Peak RSS in MB of loading path in a fresh child, -1 on failure */
+static long child_peak_mb(const char *path) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        long peak = -1;
+        struct image_data *img = image_load(path, DISPLAY_WIDTH, DISPLAY_HEIGHT, MODE_FILL);
+        if (img) {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            peak = usage.ru_maxrss / 1024;
+            image_free(img);
+        }
+        ssize_t written = write(fds[1], &peak, sizeof(peak));
+        _exit(written == (ssize_t)sizeof(peak) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    long peak = -1;
+    if (read(fds[0], &peak, sizeof(peak)) != (ssize_t)sizeof(peak)) {
+        peak = -1;
+    }
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return peak;
+}
+
+static bool same_output(const char *streamed_path, const char *batch_path,
+                        int32_t width, int32_t height, enum wallpaper_mode mode) {
+    struct image_data *streamed = image_load(streamed_path, width, height, mode);
+    struct image_data *batch = image_load(batch_path, width, height, mode);
+    bool same = streamed && batch && streamed->pixels && batch->pixels &&
+                streamed->width == batch->width && streamed->height == batch->height &&
+                memcmp(streamed->pixels, batch->pixels,
+                       (size_t)streamed->width * streamed->height * 4) == 0;
+    image_free(streamed);
+    image_free(batch);
+    return same;
+}
+
+int main(void) {
+    /* No wallpaper disk cache: every load must decode */
+    unsetenv("XDG_CACHE_HOME");
+    unsetenv("HOME");
+
+    char dir[] = "/tmp/neowall-png-bench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char big[64], big_interlaced[64], odd[64], odd_interlaced[64];
+    snprintf(big, sizeof(big), "%s/big.png", dir);
+    snprintf(big_interlaced, sizeof(big_interlaced), "%s/big-i.png", dir);
+    snprintf(odd, sizeof(odd), "%s/odd.png", dir);
+    snprintf(odd_interlaced, sizeof(odd_interlaced), "%s/odd-i.png", dir);
+
+    int failed = 0;
+    if (!write_png(big, BIG_SIZE, BIG_SIZE, false) ||
+        !write_png(big_interlaced, BIG_SIZE, BIG_SIZE, true) ||
+        !write_png(odd, 3001, 1999, false) ||
+        !write_png(odd_interlaced, 3001, 1999, true)) {
+        fprintf(stderr, "failed to write test images to %s\n", dir);
+        failed = 1;
+        goto out;
+    }
+
+    long streamed_mb = child_peak_mb(big);
+    long batch_mb = child_peak_mb(big_interlaced);
+    printf("%dx%d PNG -> %dx%d FILL: peak RSS streamed %ld MB, decode-then-scale %ld MB\n",
+           BIG_SIZE, BIG_SIZE, DISPLAY_WIDTH, DISPLAY_HEIGHT, streamed_mb, batch_mb);
+    if (streamed_mb <= 0 || batch_mb <= 0 || streamed_mb * 4 > batch_mb) {
+        printf("FAIL: streaming should peak well below the full decode\n");
+        failed = 1;
+    }
+
+    static const struct {
+        enum wallpaper_mode mode;
+        const char *name;
+    } modes[] = {
+        { MODE_FILL, "fill" }, { MODE_FIT, "fit" }, { MODE_STRETCH, "stretch" },
+        { MODE_TILE, "tile" }, { MODE_CENTER, "center" },
+    };
+    static const int32_t displays[][2] = { { 1920, 1080 }, { 1280, 1024 }, { 4000, 2500 } };
+    for (size_t d = 0; d < sizeof(displays) / sizeof(displays[0]); d++) {
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            bool same = same_output(odd, odd_interlaced, displays[d][0], displays[d][1], modes[m].mode);
+            printf("3001x1999 -> %dx%d %-7s %s\n", displays[d][0], displays[d][1], modes[m].name,
+                   same ? "identical" : "DIFFERENT");
+            failed |= !same;
+        }
+    }
+
+out:
+    unlink(big);
+    unlink(big_interlaced);
+    unlink(odd);
+    unlink(odd_interlaced);
+    rmdir(dir);
+    printf(failed ? "FAIL\n" : "PASS\n");
+    return failed;
+}
@@ -0,0 +1,139 @@
+/*
+ * Image scaler microbenchmark
+ *
+ * Times image_scale_rgba() against the float bilinear loop it replaced
+ * (image_scale_bilinear() in the original src/image.c, kept here verbatim
+ * as the reference) on 1080p, 4K and 8K resizes. Reports the best of several
+ * runs and the SIMD backend in use.
+ *
+ * Build and run: make bench-scale
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "image_scale.h"
+
+#define BENCH_RUNS 5
+
+struct bench_case {
+    uint32_t src_width;
+    uint32_t src_height;
+    uint32_t dst_width;
+    uint32_t dst_height;
+};
+
+static const struct bench_case cases[] = {
+    { 1920, 1080, 2560, 1440 },   /* 1080p enlarged */
+    { 3840, 2160, 1920, 1080 },   /* 4K to 1080p */
+    { 5000, 3000, 3840, 2160 },   /* Photo to 4K */
+    { 7680, 4320, 3840, 2160 },   /* 8K to 4K */
+};
+
+static const char *filter_names[] = { "bilinear", "area", "lanczos3" };
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* The original scaler: four float multiply-adds per channel per pixel */
+static void scale_float_bilinear(const uint8_t *src, uint32_t width, uint32_t height,
+                                 uint8_t *dst, uint32_t new_width, uint32_t new_height) {
+    float x_ratio = (float)(width - 1) / (float)new_width;
+    float y_ratio = (float)(height - 1) / (float)new_height;
+
+    for (uint32_t y = 0; y < new_height; y++) {
+        for (uint32_t x = 0; x < new_width; x++) {
+            float src_x = x * x_ratio;
+            float src_y = y * y_ratio;
+
+            uint32_t x1 = (uint32_t)src_x;
+            uint32_t y1 = (uint32_t)src_y;
+            uint32_t x2 = (x1 < width - 1) ? x1 + 1 : x1;
+            uint32_t y2 = (y1 < height - 1) ? y1 + 1 : y1;
+
+            float x_diff = src_x - x1;
+            float y_diff = src_y - y1;
+
+            size_t idx_tl = ((size_t)y1 * width + x1) * 4;
+            size_t idx_tr = ((size_t)y1 * width + x2) * 4;
+            size_t idx_bl = ((size_t)y2 * width + x1) * 4;
+            size_t idx_br = ((size_t)y2 * width + x2) * 4;
+
+            size_t dst_idx = ((size_t)y * new_width + x) * 4;
+
+            for (int c = 0; c < 4; c++) {
+                float tl = src[idx_tl + c];
+                float tr = src[idx_tr + c];
+                float bl = src[idx_bl + c];
+                float br = src[idx_br + c];
+
+                float top = tl * (1.0f - x_diff) + tr * x_diff;
+                float bottom = bl * (1.0f - x_diff) + br * x_diff;
+                float value = top * (1.0f - y_diff) + bottom * y_diff;
+
+                dst[dst_idx + c] = (uint8_t)(value + 0.5f);
+            }
+        }
+    }
+}
+
+int main(void) {
+    printf("backend: %s, best of %d runs\n", image_scale_backend(), BENCH_RUNS);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const struct bench_case *c = &cases[i];
+        size_t src_size = (size_t)c->src_width * c->src_height * 4;
+        size_t dst_size = (size_t)c->dst_width * c->dst_height * 4;
+        uint8_t *src = malloc(src_size);
+        uint8_t *dst = malloc(dst_size);
+        if (!src || !dst) {
+            fprintf(stderr, "out of memory\n");
+            free(src);
+            free(dst);
+            return 1;
+        }
+
+        /* Noise defeats any shortcut on flat input */
+        uint32_t seed = 12345;
+        for (size_t j = 0; j < src_size; j++) {
+            seed = seed * 1103515245u + 12345u;
+            src[j] = (uint8_t)(seed >> 24);
+        }
+
+        enum image_scale_filter filter = image_scale_pick_filter(c->src_width, c->src_height,
+                                                                 c->dst_width, c->dst_height);
+        double old_ms = 0.0, new_ms = 0.0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            double start = now_ms();
+            scale_float_bilinear(src, c->src_width, c->src_height, dst, c->dst_width, c->dst_height);
+            double elapsed = now_ms() - start;
+            if (run == 0 || elapsed < old_ms) {
+                old_ms = elapsed;
+            }
+
+            start = now_ms();
+            if (!image_scale_rgba(src, c->src_width, c->src_height, dst, c->dst_width,
+                                  c->dst_height, filter)) {
+                fprintf(stderr, "image_scale_rgba failed\n");
+                free(src);
+                free(dst);
+                return 1;
+            }
+            elapsed = now_ms() - start;
+            if (run == 0 || elapsed < new_ms) {
+                new_ms = elapsed;
+            }
+        }
+
+        printf("%5ux%-5u -> %5ux%-5u  old %7.1f ms  new %7.1f ms  %5.2fx  (%s)\n",
+               c->src_width, c->src_height, c->dst_width, c->dst_height,
+               old_ms, new_ms, old_ms / new_ms, filter_names[filter]);
+        free(src);
+        free(dst);
+    }
+    return 0;
+}
@@ -20,11 +20,47 @@
 #define DEFAULT_TRANSITION_MS   300
 #define SHADER_FADE_IN_MS       600
 #define SHADER_FADE_OUT_MS      400
+#define SHADER_SHARE_SYNC_MS    100       /* Max time base skew for outputs to share one shader frame */
+
+/* Frame pacing (wl_surface.frame callbacks) */
+#define FRAME_CALLBACK_TIMEOUT_MS 1000    /* Give up on a frame callback the compositor never answered */
+#define DEFAULT_REFRESH_MHZ     60000     /* Assumed refresh rate until wl_output reports a mode */
+
+/* Adaptive render resolution (render_scale, upscaled by wp_viewporter) */
+#define RENDER_SCALE_FLOOR      0.25f     /* Lowest render_scale accepted in config */
+#define RENDER_SCALE_STEP       0.05f     /* Scale change per controller adjustment */
+#define RENDER_SCALE_ADJUST_MS  500       /* Minimum time between adjustments */
+#define RENDER_SCALE_HIGH_LOAD  0.90      /* Drop scale above this fraction of the frame budget */
+#define RENDER_SCALE_LOW_LOAD   0.70      /* Raise scale if the next step stays below this */
+
+/* Streaming texture uploads (PBO bands spread over frames) */
+#define TEXTURE_UPLOAD_BAND_BYTES   (1024 * 1024)  /* Pixel bytes per glTexSubImage2D band */
+#define DEFAULT_UPLOAD_BUDGET_MB    8              /* Default per-frame upload budget (upload_budget) */
+#define MAX_UPLOAD_BUDGET_MB        256
+#define TEXTURE_UPLOAD_BUDGET_MS    4              /* CPU time cap per frame for uploads */
+
+/* Display-ready wallpaper cache ($XDG_CACHE_HOME/neowall/wallpapers) */
+#define IMAGE_CACHE_MAX_MB          1024           /* LRU entries are evicted above this */
+
+/* Cycle lookahead (lookahead.h) */
+#define DEFAULT_PRELOAD_COUNT       3              /* Upcoming entries prepared (preload_count) */
+#define MAX_PRELOAD_COUNT           32
+#define DEFAULT_PRELOAD_BUDGET_MB   256            /* RAM for decoded lookahead images (preload_budget) */
+#define MAX_PRELOAD_BUDGET_MB       8192
+
+/* iChannel images fed to a shader */
+#define DEFAULT_CHANNEL_MAX_SIZE    2048           /* Longest side after loading (channel_max_size) */
+#define MIN_CHANNEL_MAX_SIZE        16
+#define MAX_CHANNEL_MAX_SIZE        16384
+
+/* Wallpaper textures shared between outputs */
+#define TEXTURE_CLAIM_TIMEOUT_MS    10000          /* A decode claim older than this can be taken over */
 
 /* Polling and sleep intervals */
 #define POLL_TIMEOUT_INFINITE   -1
 #define SLEEP_100MS_NS          100000000  /* 100ms in nanoseconds */
 #define STATS_INTERVAL_MS       10000      /* Print stats every 10 seconds */
+#define FPS_WINDOW_MS           2000       /* FPS measurement window (log + watermark refresh) */
 
 /* ============================================================================
  * Limits and Thresholds
@@ -32,6 +68,10 @@
 #define MAX_NEXT_REQUESTS       100       /* Maximum queued 'next' wallpaper requests */
 #define DAEMON_SHUTDOWN_TIMEOUT 50        /* Max attempts to wait for daemon shutdown */
 #define ALPHA_OPAQUE            255       /* Fully opaque alpha value */
+#define PARALLEL_MAX_THREADS    8         /* Threads per band-parallel image batch */
+#define IMAGE_BAND_MIN_ROWS     64        /* Smallest image band handed to a worker */
+#define DECODE_POOL_THREADS     2         /* Low-priority decode workers shared by all outputs */
+#define DECODE_POOL_NICE        19        /* Nice value when SCHED_IDLE is refused */
 
 /* ============================================================================
  * OpenGL/Shader Version
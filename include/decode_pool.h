@@ -0,0 +1,83 @@
+#ifndef DECODE_POOL_H
+#define DECODE_POOL_H
+
+#include <stdbool.h>
+#include "neowall.h"
+
+/**
+ * Background decode workers
+ *
+ * A fixed set of DECODE_POOL_THREADS low-priority threads (SCHED_IDLE, or
+ * niced where that is refused) shared by every output for CPU work that must
+ * not compete with rendering: wallpaper preloads, iChannel images and disk
+ * cache fills. Jobs wait in a queue per priority, first in first out within
+ * one. Related jobs are grouped by an owner (usually an output) so they can be
+ * cancelled together, and a job with the same owner, priority and key as one
+ * already queued or running is dropped as a duplicate.
+ *
+ * Cancellation is cooperative: queued jobs are discarded, running jobs see
+ * their cancel flag set and return at their next check.
+ */
+
+/* Room for a path plus display size and mode; longer keys are truncated */
+#define DECODE_KEY_LENGTH (MAX_PATH_LENGTH + 32)
+
+enum decode_priority {
+    DECODE_PRIORITY_VISIBLE,    /* Needed on screen now (iChannel images) */
+    DECODE_PRIORITY_PRELOAD,    /* Next wallpaper in a cycle */
+    DECODE_PRIORITY_LOOKAHEAD,  /* Entries after it (lookahead.h) */
+    DECODE_PRIORITY_IDLE,       /* Nothing waits for it (cache fills) */
+    DECODE_PRIORITY_COUNT,
+};
+
+/* Runs on a worker and owns arg; should return early once *cancelled is set */
+typedef void (*decode_job_fn)(void *arg, const atomic_bool_t *cancelled);
+
+/* Frees the arg of a job dropped before it ran */
+typedef void (*decode_discard_fn)(void *arg);
+
+struct decode_request {
+    void *owner;                    /* Cancellation group (NULL = none) */
+    enum decode_priority priority;
+    const char *key;                /* Identifies the work for deduplication (NULL = unique) */
+    bool supersede;                 /* Replace this owner's other jobs at this priority */
+    decode_job_fn run;
+    decode_discard_fn discard;      /* May be NULL if arg needs no cleanup */
+    void *arg;
+};
+
+/**
+ * Start the worker threads
+ *
+ * @return true if at least one worker is running
+ */
+bool decode_pool_start(void);
+
+/**
+ * Discard queued jobs and join the workers after their running jobs return
+ */
+void decode_pool_stop(void);
+
+/**
+ * Queue a job
+ *
+ * Always takes ownership of request->arg: a duplicate or a job that cannot be
+ * queued is discarded straight away. With supersede set, queued jobs of the
+ * same owner and priority are discarded and running ones are cancelled, so
+ * only the newest request survives (a lookahead that moved on).
+ *
+ * @param request Job description (copied)
+ * @return true if the job is queued or already pending as a duplicate
+ */
+bool decode_pool_submit(const struct decode_request *request);
+
+/**
+ * Cancel an owner's jobs and wait for its running ones to return
+ *
+ * Call before freeing anything the owner's jobs publish into.
+ *
+ * @param owner Owner whose jobs to cancel
+ */
+void decode_pool_cancel(void *owner);
+
+#endif /* DECODE_POOL_H */
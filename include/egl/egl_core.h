@@ -82,6 +82,17 @@ EGLContext egl_create_best_context(EGLDisplay display, EGLConfig config,
 EGLContext egl_create_context_version(EGLDisplay display, EGLConfig config,
                                        gles_version_t version);
 
+/**
+ * Create a context in the main context's share group (same ES version)
+ *
+ * Textures, programs and buffers created in either context are visible in
+ * both. Used by render threads and the background shader compiler.
+ *
+ * @param state NeoWall global state
+ * @return EGL context or EGL_NO_CONTEXT on failure
+ */
+EGLContext egl_core_create_shared_context(struct neowall_state *state);
+
 /**
  * Make EGL context current for an output
  * 
@@ -102,6 +113,34 @@ bool egl_core_make_current(struct neowall_state *state,
 bool egl_core_swap_buffers(struct neowall_state *state,
                            struct output_state *output);
 
+/**
+ * Swap buffers, telling the compositor which regions changed
+ *
+ * Uses EGL_KHR/EXT_swap_buffers_with_damage when available and falls back to
+ * a full-surface swap otherwise.
+ *
+ * @param state NeoWall global state
+ * @param output Output state
+ * @param rects Damage rectangles as x, y, width, height (origin bottom-left)
+ * @param n_rects Number of rectangles (0 = whole surface)
+ * @return true on success, false on failure
+ */
+bool egl_core_swap_buffers_with_damage(struct neowall_state *state,
+                                       struct output_state *output,
+                                       const EGLint *rects, EGLint n_rects);
+
+/**
+ * Query the age of the output's current back buffer (EGL_EXT_buffer_age)
+ *
+ * Must be called with the output's surface current, before drawing.
+ *
+ * @param state NeoWall global state
+ * @param output Output state
+ * @return Frames since the buffer was last presented, 0 if unknown
+ */
+EGLint egl_core_buffer_age(struct neowall_state *state,
+                           struct output_state *output);
+
 /**
  * Get EGL config with best attributes
  * 
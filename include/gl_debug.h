@@ -0,0 +1,55 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <stdbool.h>
+
+/**
+ * GL error checking layer
+ *
+ * glGetError() forces a CPU/GPU round trip on many drivers, so the frame path
+ * only queries errors while this layer is active:
+ * - build time: NEOWALL_GL_DEBUG (`make debug` or `make GL_DEBUG=1`) turns it
+ *   on by default
+ * - run time: --gl-debug turns it on in any build
+ *
+ * While active, contexts exposing GL_KHR_debug also report driver messages
+ * through a synchronous debug callback. When inactive, GL_CHECK() is a single
+ * branch and the frame runs without any error queries.
+ */
+
+/* Set once at startup before any render thread exists, read-only afterwards */
+extern bool gl_debug_active;
+
+/**
+ * Enable or disable the layer (call before EGL initialization)
+ *
+ * @param enabled true to check GL errors in the frame path
+ */
+void gl_debug_set_enabled(bool enabled);
+
+/**
+ * Install the KHR_debug callback on the current context if the layer is active.
+ * Call once with every newly created context current.
+ */
+void gl_debug_setup_context(void);
+
+/**
+ * Query and log the pending GL error
+ *
+ * @param format printf-style description of the call being checked
+ * @return true if no error was pending
+ */
+bool gl_debug_check(const char *format, ...);
+
+/**
+ * Drop stale errors so following checks report their own call
+ */
+void gl_debug_clear(void);
+
+/* Check for a GL error after a call - free when the layer is inactive */
+#define GL_CHECK(...) (!gl_debug_active || gl_debug_check(__VA_ARGS__))
+
+/* Discard stale errors before a checked sequence - free when inactive */
+#define GL_CLEAR_ERRORS() do { if (gl_debug_active) gl_debug_clear(); } while (0)
+
+#endif /* GL_DEBUG_H */
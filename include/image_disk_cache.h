@@ -0,0 +1,71 @@
+#ifndef IMAGE_DISK_CACHE_H
+#define IMAGE_DISK_CACHE_H
+
+#include <stdint.h>
+#include "neowall.h"
+
+/**
+ * Persistent cache of display-ready wallpapers
+ *
+ * Decoding and scaling a wallpaper gives the same pixels every time for the
+ * same file, output size and mode, yet it used to run on every cycle, restart
+ * and reload. Finished images are stored as raw RGBA under
+ * $XDG_CACHE_HOME/neowall/wallpapers, keyed by the file's path, mtime and
+ * size plus the display size and wallpaper_mode, so editing or replacing the
+ * file is a miss. Hits are mmap'd: the pixels go straight to
+ * render_create_texture() without a copy and are unmapped by
+ * image_free_pixels().
+ *
+ * The directory is kept under IMAGE_CACHE_MAX_MB by evicting the least
+ * recently used entries (hits refresh an entry's mtime).
+ */
+
+/**
+ * Look up a display-ready image
+ *
+ * @param path Expanded path of the source file
+ * @param display_width Output width the image was prepared for
+ * @param display_height Output height the image was prepared for
+ * @param mode Display mode the image was prepared for
+ * @return Image with mapped pixels, or NULL on a miss
+ */
+struct image_data *image_disk_cache_load(const char *path, int32_t display_width,
+                                         int32_t display_height, enum wallpaper_mode mode);
+
+/**
+ * Store a display-ready image, evicting old entries over the size limit
+ *
+ * @param path Expanded path of the source file
+ * @param display_width Output width the image was prepared for
+ * @param display_height Output height the image was prepared for
+ * @param mode Display mode the image was prepared for
+ * @param img Prepared RGBA image
+ */
+void image_disk_cache_store(const char *path, int32_t display_width, int32_t display_height,
+                            enum wallpaper_mode mode, const struct image_data *img);
+
+/**
+ * Store a copy of a display-ready image from a decode pool worker
+ *
+ * The write and eviction run at idle priority instead of delaying the
+ * caller; img can be uploaded and freed right away. Stores inline when the
+ * pool is not running.
+ *
+ * @param path Expanded path of the source file
+ * @param display_width Output width the image was prepared for
+ * @param display_height Output height the image was prepared for
+ * @param mode Display mode the image was prepared for
+ * @param img Prepared RGBA image
+ */
+void image_disk_cache_store_async(const char *path, int32_t display_width, int32_t display_height,
+                                  enum wallpaper_mode mode, const struct image_data *img);
+
+/**
+ * Get hit/miss counters since startup
+ *
+ * @param hits Receives the number of images mapped from disk
+ * @param misses Receives the number of images decoded from source
+ */
+void image_disk_cache_get_stats(unsigned long *hits, unsigned long *misses);
+
+#endif /* IMAGE_DISK_CACHE_H */
@@ -0,0 +1,113 @@
+#ifndef IMAGE_SCALE_H
+#define IMAGE_SCALE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * RGBA image resampling
+ *
+ * Separable two-pass filter (horizontal, then vertical) with per-axis
+ * coefficient tables computed once per call in 14-bit fixed point. The inner
+ * loops only multiply-accumulate 16-bit pixels by 16-bit weights, which maps
+ * directly onto SIMD multiply-add: SSE2 (baseline on x86-64), AVX2 (selected
+ * at run time) and NEON on ARM, with a portable C fallback.
+ *
+ * When downscaling, kernels are widened by the scale factor so every source
+ * pixel contributes (no aliasing from skipped pixels).
+ */
+
+struct image_scale_stream;
+
+enum image_scale_filter {
+    IMAGE_SCALE_BILINEAR,   /* Triangle kernel - upscaling */
+    IMAGE_SCALE_AREA,       /* Box kernel (area average) - large downscales */
+    IMAGE_SCALE_LANCZOS3,   /* Sharp downscales */
+};
+
+/**
+ * Filter suited to a resize: Lanczos3 for moderate downscales, area average
+ * from 2x (same quality for far fewer taps), bilinear when enlarging
+ */
+enum image_scale_filter image_scale_pick_filter(uint32_t src_width, uint32_t src_height,
+                                                uint32_t dst_width, uint32_t dst_height);
+
+/**
+ * Resample a tightly packed RGBA image
+ *
+ * @param src Source pixels (src_width * src_height * 4 bytes)
+ * @param dst Destination pixels (dst_width * dst_height * 4 bytes)
+ * @param filter Resampling kernel
+ * @return false if temporary buffers could not be allocated
+ */
+bool image_scale_rgba(const uint8_t *src, uint32_t src_width, uint32_t src_height,
+                      uint8_t *dst, uint32_t dst_width, uint32_t dst_height,
+                      enum image_scale_filter filter);
+
+/**
+ * Resample into a window of a larger destination (fused scale + crop)
+ *
+ * Produces the width x height region at (crop_x, crop_y) of the image scaled
+ * to scaled_width x scaled_height, writing rows dst_stride bytes apart, so a
+ * crop costs nothing and a padded result needs no second copy. A negative
+ * stride writes the rows bottom-up (GL row order) at no cost. Rows are split
+ * into bands processed in parallel (see parallel.h).
+ *
+ * @param src Source pixels (src_width * src_height * 4 bytes)
+ * @param scaled_width Width of the full scaled image
+ * @param scaled_height Height of the full scaled image
+ * @param crop_x Region origin within the scaled image
+ * @param crop_y Region origin within the scaled image
+ * @param width Region width
+ * @param height Region height
+ * @param dst First pixel of the region's first row in the destination
+ * @param dst_stride Destination row pitch in bytes, negative for bottom-up rows
+ * @param filter Resampling kernel
+ * @return false if the region is out of bounds or buffers could not be allocated
+ */
+bool image_scale_rgba_region(const uint8_t *src, uint32_t src_width, uint32_t src_height,
+                             uint32_t scaled_width, uint32_t scaled_height,
+                             uint32_t crop_x, uint32_t crop_y, uint32_t width, uint32_t height,
+                             uint8_t *dst, ptrdiff_t dst_stride, enum image_scale_filter filter);
+
+/**
+ * Row-streaming variant of image_scale_rgba_region() for decoders
+ *
+ * Source rows are pushed one at a time, top to bottom. Each is resampled
+ * horizontally into a small ring (as many rows as the vertical kernel has
+ * taps) and output rows are written as soon as their taps are in it, so the
+ * full-resolution image never has to exist in memory.
+ *
+ * @return Stream, or NULL if the region is invalid or allocation failed
+ */
+struct image_scale_stream *image_scale_stream_create(uint32_t src_width, uint32_t src_height,
+                                                     uint32_t scaled_width, uint32_t scaled_height,
+                                                     uint32_t crop_x, uint32_t crop_y,
+                                                     uint32_t width, uint32_t height,
+                                                     uint8_t *dst, ptrdiff_t dst_stride,
+                                                     enum image_scale_filter filter);
+
+/**
+ * Feed the next source row (src_width * 4 bytes)
+ */
+void image_scale_stream_push(struct image_scale_stream *stream, const uint8_t *src_row);
+
+/**
+ * Whether every output row has been written
+ */
+bool image_scale_stream_complete(const struct image_scale_stream *stream);
+
+/**
+ * Free a stream (the destination buffer stays with the caller)
+ *
+ * @param stream Stream (NULL is ignored)
+ */
+void image_scale_stream_destroy(struct image_scale_stream *stream);
+
+/**
+ * Name of the SIMD path selected for this CPU ("avx2", "sse2", "neon" or "c")
+ */
+const char *image_scale_backend(void);
+
+#endif /* IMAGE_SCALE_H */
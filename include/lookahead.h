@@ -0,0 +1,64 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "neowall.h"
+
+/**
+ * Decoded wallpapers further down the cycle
+ *
+ * The preload slot holds the next entry only, so a second `neowall next`
+ * before its replacement is ready fell back to a blocking decode in
+ * output_set_wallpaper(). Outputs now keep a window of the upcoming
+ * preload_count entries: the next one goes through the regular preload to the
+ * GPU, the ones after it are decoded (and ETC2-compressed when enabled) into
+ * RAM at DECODE_PRIORITY_LOOKAHEAD while they fit in preload_budget MB. Entries
+ * that don't fit only have their files read into the page cache with
+ * posix_fadvise(). Either way an image leaves the window when it is taken for
+ * upload or the cycle moves past it.
+ *
+ * Entries live in output->lookahead under output->preload_mutex.
+ */
+
+/**
+ * Bring the window in line with the current cycle position
+ *
+ * Frees entries that fell out of the window and queues decodes or readahead
+ * for new ones. Call after the cycle index or output size changed.
+ *
+ * @param output Output with an image cycle
+ */
+void lookahead_update(struct output_state *output);
+
+/**
+ * Take a decoded entry out of the window
+ *
+ * @param output Output owning the window
+ * @param path Cycle entry path
+ * @param display_width Output width the image must be prepared for
+ * @param display_height Output height the image must be prepared for
+ * @param mode Display mode the image must be prepared for
+ * @return Display-ready image (caller frees), or NULL if not decoded yet
+ */
+struct image_data *lookahead_take(struct output_state *output, const char *path,
+                                  int32_t display_width, int32_t display_height,
+                                  enum wallpaper_mode mode);
+
+/**
+ * Free the whole window
+ *
+ * Call after decode_pool_cancel(output) when destroying the output.
+ *
+ * @param output Output owning the window
+ */
+void lookahead_clear(struct output_state *output);
+
+/**
+ * Get counters since startup
+ *
+ * @param hits Receives the number of images taken from a window
+ */
+void lookahead_get_stats(unsigned long *hits);
+
+#endif /* LOOKAHEAD_H */
@@ -21,6 +21,8 @@ typedef atomic_int atomic_int_t;
 #define MAX_OUTPUTS 16
 #define MAX_WALLPAPERS 256
 #define CONFIG_WATCH_INTERVAL 1
+#define DAMAGE_HISTORY_LEN 4    /* Frames of damage kept for EGL_EXT_buffer_age */
+#define MAX_CHANNEL_SAMPLERS 16 /* iChannels channel_filter/wrap/mipmap can address */
 
 
 
@@ -29,6 +31,10 @@ struct neowall_state;
 struct output_state;
 struct wallpaper_config;
 struct compositor_backend;
+struct render_thread;
+struct shader_uniform_binding;
+struct shader_cache_entry;
+struct texture_stream;
 
 /* Wallpaper display modes */
 enum wallpaper_mode {
@@ -56,9 +62,42 @@ enum transition_type {
     TRANSITION_PIXELATE,
 };
 
+/* Wallpaper texture compression (see texture_compress.h) */
+enum texture_compression {
+    TEXTURE_COMPRESSION_NONE,       /* Upload RGBA as decoded */
+    TEXTURE_COMPRESSION_FAST,       /* ETC2, quick encode */
+    TEXTURE_COMPRESSION_QUALITY,    /* ETC2, exhaustive encode */
+};
+
+/* iChannel texture sampling (channel_filter, channel_wrap, channel_mipmap) */
+enum channel_filter {
+    CHANNEL_FILTER_LINEAR,
+    CHANNEL_FILTER_NEAREST,
+};
+
+enum channel_wrap {
+    CHANNEL_WRAP_DEFAULT,           /* Clamp for image files, repeat for built-in textures */
+    CHANNEL_WRAP_CLAMP,
+    CHANNEL_WRAP_REPEAT,
+    CHANNEL_WRAP_MIRROR,
+};
+
+struct channel_sampler {
+    enum channel_filter filter;
+    enum channel_wrap wrap;
+    bool mipmap;                    /* Sample from a mip chain when minified */
+};
+
 /* Image data structure */
 struct image_data {
     uint8_t *pixels;        /* RGBA pixel data */
+    void *mapping;          /* mmap'd cache file holding pixels (NULL if malloc'd) */
+    size_t mapping_size;
+    uint8_t *compressed;    /* ETC2 RGB8 blocks replacing pixels (NULL if uncompressed) */
+    size_t compressed_size;
+    int32_t display_width;  /* Output size and mode the image was prepared for */
+    int32_t display_height; /* (0x0 when loaded at its own size) */
+    enum wallpaper_mode display_mode;
     uint32_t width;
     uint32_t height;
     uint32_t channels;      /* Number of channels (3 for RGB, 4 for RGBA) */
@@ -66,6 +105,14 @@ struct image_data {
     char path[MAX_PATH_LENGTH];
 };
 
+/* Damaged area in buffer pixels, origin top-left (empty when width or height is 0) */
+struct damage_rect {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+};
+
 /* Wallpaper type */
 enum wallpaper_type {
     WALLPAPER_IMAGE,    /* Static image file */
@@ -84,6 +131,14 @@ struct wallpaper_config {
     float shader_speed;                 /* Shader animation speed multiplier (default 1.0) */
     int shader_fps;                     /* Target FPS for shader rendering (default 60) */
     bool show_fps;                      /* Show FPS watermark on screen (default false) */
+    float render_scale;                 /* Shader render resolution scale, upper bound (default 1.0) */
+    float render_scale_min;             /* Lower bound for adaptive scaling (== render_scale: fixed) */
+    int upload_budget_mb;               /* Texture upload budget per frame in MB (default 8) */
+    enum texture_compression texture_compression; /* Wallpaper texture compression (default none) */
+    int preload_count;                  /* Upcoming cycle entries prepared ahead (default 3) */
+    int preload_budget_mb;              /* RAM for decoded entries beyond the next, in MB (default 256) */
+    bool shuffle;                       /* cycle_paths are in a persisted random order */
+    int channel_max_size;               /* Longest side of iChannel images (default 2048) */
     bool cycle;                         /* Enable wallpaper cycling */
     char **cycle_paths;                 /* Array of paths for cycling */
     size_t cycle_count;                 /* Number of wallpapers to cycle */
@@ -92,6 +147,7 @@ struct wallpaper_config {
     /* iChannel texture configuration */
     char **channel_paths;               /* Array of texture paths/names for iChannels */
     size_t channel_count;               /* Number of configured channels */
+    struct channel_sampler channel_samplers[MAX_CHANNEL_SAMPLERS]; /* Per channel, by index */
 };
 
 /* Double-buffered config slot for race-free hot-reload */
@@ -106,6 +162,7 @@ struct output_state {
     struct wl_output *output;
     struct zxdg_output_v1 *xdg_output;  /* For getting connector name */
     struct compositor_surface *compositor_surface;  /* Compositor abstraction surface */
+    struct wp_viewport *viewport;       /* Upscales reduced render_scale buffers (NULL = native) */
 
     uint32_t name;              /* Wayland output name/ID */
     /* width/height represent the current physical buffer in pixels */
@@ -118,6 +175,8 @@ struct output_state {
     int32_t pixel_height;
     int32_t scale;
     int32_t transform;
+    int32_t refresh_mhz;        /* Current mode refresh rate in mHz (0 = unknown) */
+    float render_scale;         /* Render buffer size relative to native pixels (1.0 = native) */
 
     char make[64];
     char model[64];
@@ -147,16 +206,30 @@ struct output_state {
     char preload_path[MAX_PATH_LENGTH]; /* Path of preloaded image */
     atomic_bool_t preload_ready;        /* Is preload_texture ready for use? */
     
-    /* Background thread for async image loading */
-    pthread_t preload_thread;           /* Background preload thread */
-    atomic_bool_t preload_thread_active; /* Is background thread running? */
+    /* Hand-off from the background preload (decode_pool.h) */
     pthread_mutex_t preload_mutex;      /* Protects preload_image during thread handoff */
     struct image_data *preload_decoded_image; /* Image decoded in background, ready for GPU upload */
-    atomic_bool_t preload_upload_pending; /* Background thread finished, main thread should upload */
+    GLuint preload_decoded_texture;     /* Its texture if the uploader already uploaded it (fence signalled) */
+    struct texture_stream *preload_stream; /* Banded upload of a decoded preload in progress */
+    uint64_t preload_stream_next;       /* When the next band may be uploaded */
+    atomic_bool_t preload_upload_pending; /* Background decode finished, main thread should upload */
+    struct lookahead_entry *lookahead;  /* Decoded entries after the next one (lookahead.h) */
+    size_t lookahead_bytes;             /* Their size, under preload_mutex like the list */
     
     /* iChannel textures for shader inputs (dynamic count) */
     GLuint *channel_textures;           /* Dynamic array of channel textures */
     size_t channel_count;               /* Number of allocated channels */
+    uint64_t channel_textures_key;      /* Channel config the textures were loaded from */
+    uint32_t channel_generation;        /* Bumped whenever a channel texture is replaced */
+
+    /* Shader + image cycling: next iChannel0 image prepared on the decode pool */
+    char channel_preload_path[MAX_PATH_LENGTH]; /* Image being prepared (under preload_mutex) */
+    struct image_data *channel_preload_image;   /* Decoded and bounded, rows bottom-up (under preload_mutex) */
+    GLuint channel_uploaded_texture;            /* Its texture from the upload thread (under preload_mutex) */
+    atomic_bool_t channel_upload_pending;       /* channel_preload_image is waiting for the render thread */
+    GLuint channel_preload_texture;             /* Uploaded, waiting for the cycle deadline */
+    char channel_texture_path[MAX_PATH_LENGTH]; /* Image in channel_preload_texture */
+    bool channel_switch_pending;                /* Cycle came first: switch once it is uploaded */
     
     GLuint program;
     GLuint glitch_program;              /* Shader program for glitch transition */
@@ -174,12 +247,16 @@ struct output_state {
         GLint u_time;
         GLint u_speed;
         GLint *iChannel;    /* Dynamic array of iChannel sampler locations */
+        struct shader_uniform_binding *bindings; /* Reflected per-frame inputs (shader.h) */
+        size_t binding_count;
+        struct shader_cache_entry *shared; /* Program's cache entry, NULL if unshared */
     } shader_uniforms;
 
     struct {
         GLint position;
         GLint texcoord;
         GLint tex_sampler;
+        GLint alpha;
     } program_uniforms;
 
     struct {
@@ -191,6 +268,22 @@ struct output_state {
         GLint resolution;
     } transition_uniforms;
 
+    /* Render-once target while this output leads outputs showing the same shader frame */
+    struct {
+        GLuint fbo;
+        GLuint texture;
+        int32_t width;
+        int32_t height;
+        GLuint program;                 /* Program whose frame the target holds */
+        uint32_t channel_generation;    /* Channel textures that frame sampled */
+        uint64_t rendered_at;           /* When that frame was rendered (0 = empty) */
+    } shared_target;
+
+    /* Damage tracking: what each frame changes vs. what must be repainted */
+    struct damage_rect frame_damage;    /* Area changed by the frame being rendered */
+    struct damage_rect damage_history[DAMAGE_HISTORY_LEN]; /* Damage of presented frames, [0] newest */
+    struct damage_rect watermark_rect;  /* Area covered by the last drawn FPS watermark */
+
     /* GL state cache to avoid redundant calls */
     struct {
         GLuint bound_texture;
@@ -198,13 +291,34 @@ struct output_state {
         bool blend_enabled;
     } gl_state;
 
+    struct render_thread *render_thread; /* Dedicated render thread (--threaded-render), NULL if none */
+
+    /* Per-output deadlines (absolute get_time_ms() values, 0 = none) */
+    uint64_t frame_deadline;            /* Earliest time the next frame may render */
+    uint64_t cycle_deadline;            /* When the next wallpaper cycle is due */
+    uint64_t render_retry_time;         /* Earliest retry after a failed frame */
+
+    /* Adaptive render_scale controller */
+    uint64_t frame_render_ms;           /* Render time of the frame about to be presented */
+    double render_cost_ms;              /* Smoothed render + swap time (0 = no sample yet) */
+    uint64_t render_scale_time;         /* Last render_scale adjustment */
+
     uint64_t last_frame_time;
+    struct wl_callback *frame_callback; /* Outstanding wl_surface.frame callback (one frame in flight) */
+    uint64_t frame_request_time;        /* When frame_callback was requested */
     uint64_t last_cycle_time;           /* Last time wallpaper was changed/cycled */
     uint64_t transition_start_time;
     uint64_t shader_start_time;         /* Time when shader clock last restarted */
     uint64_t shader_time_accum_ms;      /* Accumulated time preserved across reloads */
     uint64_t shader_fade_start_time;    /* Time when shader fade started (for cross-fade) */
     char pending_shader_path[MAX_PATH_LENGTH]; /* Next shader to load after fade-out */
+    GLuint pending_shader_program;      /* Background-compiled program for pending_shader_path */
+    atomic_bool_t shader_compile_ready; /* Compiler finished pending_shader_program (0 = failed) */
+    char shader_preload_path[MAX_PATH_LENGTH]; /* Next playlist shader being compiled ahead */
+    GLuint shader_preload_program;      /* Lookahead program for shader_preload_path */
+    atomic_bool_t shader_preload_ready; /* Compiler finished shader_preload_program (0 = failed) */
+    uint64_t shader_preload_ms;         /* Compile + warm-up time of the lookahead */
+    uint32_t shader_preload_generation; /* Latest lookahead request (under the compiler's lock) */
     float transition_progress;
     uint64_t frames_rendered;
     bool shader_load_failed;            /* Set to true after 3 failed shader load attempts */
@@ -212,6 +326,7 @@ struct output_state {
     /* FPS measurement */
     uint64_t fps_last_log_time;         /* Last time we logged FPS */
     uint64_t fps_frame_count;           /* Frames rendered since last FPS log */
+    uint64_t fps_cpu_ns;                /* Render thread CPU time spent in those frames */
     float fps_current;                  /* Current measured FPS */
 
     struct output_state *next;
@@ -225,6 +340,7 @@ struct neowall_state {
     struct wl_compositor *compositor;
     struct wl_shm *shm;
     struct zxdg_output_manager_v1 *xdg_output_manager;  /* For getting connector names */
+    struct wp_viewporter *viewporter;   /* For render_scale upscaling (NULL if unsupported) */
 
     /* Compositor abstraction backend */
     struct compositor_backend *compositor_backend;
@@ -291,6 +407,9 @@ struct neowall_state {
     int wakeup_fd;              /* eventfd for waking poll on internal events */
     int signal_fd;              /* signalfd for race-free signal handling */
 
+    /* Rendering mode */
+    bool threaded_render;       /* One render thread per output (--threaded-render) */
+
     /* Statistics */
     uint64_t frames_rendered;
     uint64_t errors_count;
@@ -306,6 +425,7 @@ char **load_shaders_from_directory(const char *dir_path, size_t *count);
 
 /* Image loading */
 struct image_data *image_load(const char *path, int32_t display_width, int32_t display_height, enum wallpaper_mode mode);
+struct image_data *image_load_bounded(const char *path, uint32_t max_size);
 void image_free(struct image_data *img);
 void image_free_pixels(struct image_data *img);  /* Free pixel data only (after GPU upload) */
 enum image_format image_detect_format(const char *path);
@@ -326,6 +446,9 @@ struct output_state *output_create(struct neowall_state *state,
                                    struct wl_output *output, uint32_t name);
 void output_destroy(struct output_state *output);
 bool output_configure_compositor_surface(struct output_state *output);
+bool output_configure_render_scale(struct output_state *output,
+                                   const struct wallpaper_config *config);
+bool output_set_render_scale(struct output_state *output, float scale);
 bool output_create_egl_surface(struct output_state *output);
 void output_set_wallpaper(struct output_state *output, const char *path);
 void output_set_shader(struct output_state *output, const char *shader_path);
@@ -334,6 +457,7 @@ void output_apply_deferred_config(struct output_state *output);
 void output_cycle_wallpaper(struct output_state *output);
 bool output_should_cycle(struct output_state *output, uint64_t current_time);
 void output_preload_next_wallpaper(struct output_state *output);
+void output_upload_channel_image(struct output_state *output);
 
 /* Rendering */
 bool render_init_output(struct output_state *output);
@@ -342,6 +466,9 @@ bool render_frame(struct output_state *output);
 bool render_frame_shader(struct output_state *output);
 bool render_frame_transition(struct output_state *output, float progress);
 GLuint render_create_texture(struct image_data *img);
+GLuint render_create_channel_texture(struct output_state *output, size_t channel,
+                                     struct image_data *img);
+uint32_t render_channel_max_size(const struct output_state *output);
 void render_destroy_texture(GLuint texture);
 bool render_load_channel_textures(struct output_state *output, struct wallpaper_config *config);
 bool render_update_channel_texture(struct output_state *output, size_t channel_index, const char *image_path);
@@ -357,6 +484,16 @@ char *adapt_fragment_shader(struct neowall_state *state, const char *shader_code
 /* Main loop */
 void event_loop_run(struct neowall_state *state);
 void event_loop_stop(struct neowall_state *state);
+bool event_loop_output_animating(struct output_state *output);
+bool event_loop_output_frame_due(struct output_state *output, uint64_t now);
+bool event_loop_output_needs_frame(struct output_state *output, uint64_t now);
+uint64_t event_loop_output_next_deadline(struct neowall_state *state, struct output_state *output,
+                                         uint64_t now);
+bool event_loop_upload_preload(struct neowall_state *state, struct output_state *output);
+void event_loop_wake_output(struct output_state *output);
+bool event_loop_render_output(struct neowall_state *state, struct output_state *output);
+void event_loop_present_output(struct neowall_state *state, struct output_state *output,
+                               uint64_t frame_time, struct wl_surface *frame_surface);
 
 /* Config watching */
 void *config_watch_thread(void *arg);
@@ -388,6 +525,7 @@ bool write_wallpaper_state(const char *output_name, const char *wallpaper_path,
                            const char *status);
 bool read_wallpaper_state(void);
 int restore_cycle_index_from_state(const char *output_name);
+uint32_t get_shuffle_seed(void);
 
 /* Signal handling */
 void signal_handler_init(struct neowall_state *state);
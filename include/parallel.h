@@ -0,0 +1,47 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Band-parallel loops over image rows
+ *
+ * A small pool of CPU worker threads (one per online CPU, at most
+ * PARALLEL_MAX_THREADS including the caller) started on first use. The caller
+ * always works on its own batch too, so a busy pool - another output decoding
+ * at the same time - only means the batch runs on fewer threads. Workers keep
+ * normal priority: a visible load waits on them, and idle-priority helpers
+ * would leave it waiting behind rendering.
+ */
+
+typedef void (*parallel_band_fn)(void *ctx, uint32_t row_begin, uint32_t row_end);
+
+/**
+ * Run fn over rows [0, rows) split into bands, returning once all are done
+ *
+ * Bands are disjoint and cover every row exactly once.
+ *
+ * @param rows Total rows
+ * @param min_band_rows Smallest band worth handing to another thread
+ * @param fn Band callback (called concurrently from several threads)
+ * @param ctx Callback context
+ */
+void parallel_bands(uint32_t rows, uint32_t min_band_rows, parallel_band_fn fn, void *ctx);
+
+/**
+ * Run the calling thread's batches on that thread alone
+ *
+ * For low-priority threads (decode workers), whose bands would otherwise run
+ * at normal priority on the pool and hold it while visible loads wait.
+ *
+ * @param serial true to stop handing bands to the pool
+ */
+void parallel_set_thread_serial(bool serial);
+
+/**
+ * Stop the worker threads; later batches run on the calling thread
+ */
+void parallel_shutdown(void);
+
+#endif /* PARALLEL_H */
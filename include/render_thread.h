@@ -0,0 +1,67 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <stdbool.h>
+#include <EGL/egl.h>
+
+struct neowall_state;
+struct output_state;
+
+/**
+ * Per-output render threads (--threaded-render)
+ *
+ * Each output gets its own thread with a private EGL context in the main
+ * context's share group and its own Wayland event queue for frame callbacks,
+ * so a blocking swap on one monitor never stalls another. The main thread
+ * keeps config, IPC and cycle requests; cycling itself runs on the output's
+ * render thread so all GL work for an output stays on one context.
+ */
+
+/**
+ * Start render threads for every output with a ready EGL surface.
+ * Outputs that already have a thread are left alone.
+ *
+ * @param state Global state
+ */
+void render_threads_start(struct neowall_state *state);
+
+/**
+ * Stop and join all render threads, returning outputs to the main loop.
+ * Safe to call when no threads are running.
+ *
+ * @param state Global state
+ */
+void render_threads_stop(struct neowall_state *state);
+
+/**
+ * Stop and join the render thread of a single output (output removal).
+ *
+ * @param output Output whose thread should be stopped
+ */
+void render_thread_stop(struct output_state *output);
+
+/**
+ * Wake an output's render thread to re-check its deadlines.
+ *
+ * @param output Output with an active render thread
+ */
+void render_thread_wakeup(struct output_state *output);
+
+/**
+ * Ask an output's render thread to advance to the next wallpaper.
+ *
+ * @param output Output with an active render thread
+ */
+void render_thread_request_cycle(struct output_state *output);
+
+/**
+ * EGL context to use for GL work on an output from the calling thread:
+ * the output's private context on its render thread, the shared main
+ * context everywhere else.
+ *
+ * @param output Output to render
+ * @return EGL context to make current
+ */
+EGLContext render_thread_context_for(struct output_state *output);
+
+#endif /* RENDER_THREAD_H */
@@ -3,6 +3,29 @@
 
 #include <GLES2/gl2.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+/* Per-frame inputs a live shader can consume, identified by uniform name */
+enum shader_uniform_role {
+    SHADER_UNIFORM_TIME,        /* float: _neowall_time, time, iTime */
+    SHADER_UNIFORM_RESOLUTION,  /* vec2: _neowall_resolution, resolution */
+    SHADER_UNIFORM_RESOLUTION3, /* vec3: iResolution (width, height, aspect) */
+    SHADER_UNIFORM_CHANNEL,     /* sampler2D: iChannelN */
+};
+
+/**
+ * One active uniform of a linked live program that neowall feeds.
+ * value holds what was last uploaded so unchanged inputs are skipped.
+ */
+struct shader_cache_entry;
+
+struct shader_uniform_binding {
+    GLint location;
+    enum shader_uniform_role role;
+    unsigned int channel;       /* Texture unit for SHADER_UNIFORM_CHANNEL */
+    float value[3];
+    bool uploaded;
+};
 
 /**
  * Creates a shader program from source code.
@@ -19,6 +42,7 @@ bool shader_create_program_from_sources(const char *vertex_src,
 
 /**
  * Destroys a shader program.
+ * Cached programs are only deleted when their last user releases them.
  * @param program The program ID to destroy
  */
 void shader_destroy_program(GLuint program);
@@ -33,6 +57,51 @@ void shader_destroy_program(GLuint program);
  */
 bool shader_create_live_program(const char *shader_path, GLuint *program, size_t channel_count);
 
+/**
+ * Enable or disable program sharing (call before any program is created)
+ * 
+ * Shared programs carry one set of uniform values, so sharing is only safe
+ * while every output renders on the same thread.
+ * 
+ * @param enabled true to share programs built from identical sources
+ */
+void shader_cache_set_enabled(bool enabled);
+
+/**
+ * Find the cache entry of a shared program
+ * 
+ * The entry stays valid while the caller holds its reference to the program.
+ * 
+ * @param program Program returned by shader_create_program_from_sources()
+ * @return The entry, or NULL if the program is not shared
+ */
+struct shader_cache_entry *shader_cache_lookup(GLuint program);
+
+/**
+ * Record which user last uploaded uniforms into a program (lock-free)
+ * 
+ * @param entry Entry from shader_cache_lookup(), may be NULL
+ * @param owner Identity of the caller (e.g. its output)
+ * @return true if owner was also the previous uploader, so values it
+ *         uploaded earlier are still in place; always true for unshared programs
+ */
+bool shader_cache_claim_uniforms(struct shader_cache_entry *entry, const void *owner);
+
+/**
+ * Reflect the active uniforms of a linked live program
+ * 
+ * Enumerates the program once with glGetActiveUniform and keeps only the
+ * uniforms neowall feeds, so the frame path never looks up names. iChannel
+ * samplers are assigned their texture unit here since that never changes.
+ * 
+ * @param program Linked live shader program
+ * @param bindings Receives a malloc'd table (NULL if nothing is bound)
+ * @param count Receives the number of entries
+ * @return true on success, false on allocation failure
+ */
+bool shader_reflect_uniforms(GLuint program, struct shader_uniform_binding **bindings,
+                             size_t *count);
+
 /* Transition-specific shader creation functions (defined in transition files) */
 bool shader_create_fade_program(GLuint *program);
 bool shader_create_slide_program(GLuint *program);
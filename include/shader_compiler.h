@@ -0,0 +1,79 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct neowall_state;
+struct output_state;
+
+/**
+ * Background shader compilation
+ *
+ * Compiling and linking a Shadertoy program can take hundreds of milliseconds,
+ * and drivers often defer the real work to the first draw. Cycling therefore
+ * compiles on a worker thread that owns a surfaceless context in the main
+ * share group, warms the program with a 1x1 offscreen draw, and hands it back
+ * through output->pending_shader_program / output->shader_compile_ready. The
+ * render path starts the cross-fade only once the program is ready, so the
+ * swap at the blackout point costs nothing.
+ *
+ * Without EGL_KHR_surfaceless_context the worker is not started and
+ * shader_compiler_submit() returns false; callers then compile synchronously.
+ */
+
+/**
+ * Start the worker (call after EGL initialization)
+ *
+ * @param state NeoWall global state
+ * @return true if background compilation is available
+ */
+bool shader_compiler_start(struct neowall_state *state);
+
+/**
+ * Stop the worker and destroy its context (call before EGL cleanup)
+ */
+void shader_compiler_stop(void);
+
+/**
+ * Queue a shader for an output
+ *
+ * On completion the worker stores the program (0 on failure) in
+ * output->pending_shader_program, sets output->shader_compile_ready and wakes
+ * the output's loop.
+ *
+ * @param output Output that will use the program
+ * @param shader_path Shader file to compile
+ * @param channel_count Number of iChannel samplers to declare
+ * @return true if queued, false if the caller must compile itself
+ */
+bool shader_compiler_submit(struct output_state *output, const char *shader_path,
+                            size_t channel_count);
+
+/**
+ * Compile the next playlist shader ahead of its cycle deadline
+ *
+ * The result lands in output->shader_preload_program / shader_preload_ready
+ * (with the preparation time in shader_preload_ms) and is claimed when the
+ * cycle reaches it. A previous lookahead for the output is discarded; if it
+ * is compiling, the worker destroys its result instead of publishing it, so
+ * this never waits.
+ *
+ * @param output Output that will use the program
+ * @param shader_path Shader file to compile
+ * @param channel_count Number of iChannel samplers to declare
+ * @return true if queued, false if background compilation is unavailable
+ */
+bool shader_compiler_preload(struct output_state *output, const char *shader_path,
+                             size_t channel_count);
+
+/**
+ * Drop queued work for an output, wait for its running job and destroy any
+ * unclaimed result, including a preloaded program. Call before tearing down
+ * the output's shader state.
+ *
+ * @param output Output whose jobs to cancel
+ */
+void shader_compiler_cancel(struct output_state *output);
+
+#endif /* SHADER_COMPILER_H */
@@ -0,0 +1,49 @@
+#ifndef SHADER_DISK_CACHE_H
+#define SHADER_DISK_CACHE_H
+
+#include <GLES2/gl2.h>
+#include <stdbool.h>
+
+/**
+ * Persistent program binary cache
+ *
+ * Linked programs are saved with glGetProgramBinary (ES 3.0 or
+ * GL_OES_get_program_binary) under $XDG_CACHE_HOME/neowall/programs, keyed by
+ * a hash of the final vertex and fragment source plus the GL vendor, renderer
+ * and version strings. Each entry also records the source length and a
+ * second, independent source hash, so a key collision is a miss rather than
+ * the wrong program. A driver update changes the key; entries of other
+ * drivers are deleted when the cache is opened, and a binary the driver
+ * still rejects is deleted and rebuilt from source.
+ */
+
+/**
+ * Load a previously linked program for these sources
+ *
+ * Requires a current GL context.
+ *
+ * @param vertex_src Vertex shader source
+ * @param fragment_src Final fragment shader source
+ * @param program Receives the linked program on a hit
+ * @return true on a cache hit, false if the program must be compiled
+ */
+bool shader_disk_cache_load(const char *vertex_src, const char *fragment_src, GLuint *program);
+
+/**
+ * Save a freshly linked program (no-op if binaries are unsupported)
+ *
+ * @param vertex_src Vertex shader source
+ * @param fragment_src Final fragment shader source
+ * @param program Linked program
+ */
+void shader_disk_cache_store(const char *vertex_src, const char *fragment_src, GLuint program);
+
+/**
+ * Get hit/miss counters since startup (lookups while binaries are unsupported are not counted)
+ *
+ * @param hits Receives the number of programs loaded from disk
+ * @param misses Receives the number of programs compiled from source
+ */
+void shader_disk_cache_get_stats(unsigned long *hits, unsigned long *misses);
+
+#endif /* SHADER_DISK_CACHE_H */
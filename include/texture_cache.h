@@ -0,0 +1,101 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+
+/**
+ * Wallpaper textures shared between outputs
+ *
+ * Monitors of the same size cycling the same list (see
+ * docs/MULTI_MONITOR_SYNC.md) want the same image at the same moment. All
+ * output contexts are in one share group, so one decode and one texture can
+ * serve all of them. Textures are registered under (path, display size, mode)
+ * and reference counted; every output field holding one owns a reference,
+ * dropped through render_destroy_texture().
+ *
+ * Preloads coordinate through claims: the first output to ask for an image
+ * decodes it, later ones are queued as waiters and get a pixel-less copy of
+ * the image in their preload hand-off once the texture exists. Their own GL
+ * thread then takes a reference with texture_cache_acquire(). A claim whose
+ * decoder failed or vanished is taken over after TEXTURE_CLAIM_TIMEOUT_MS.
+ */
+
+enum texture_claim {
+    TEXTURE_CLAIM_DECODE,   /* Caller decodes and uploads; the texture is inserted on creation */
+    TEXTURE_CLAIM_SHARED,   /* Texture exists; its description was handed to the output */
+    TEXTURE_CLAIM_WAIT,     /* Another output is decoding; the output is handed the result */
+};
+
+/**
+ * Find or claim the texture for a preload
+ *
+ * @param output Output preloading the image
+ * @param path Image path as given to image_load()
+ * @param display_width Output width
+ * @param display_height Output height
+ * @param mode Display mode
+ * @return What the caller should do
+ */
+enum texture_claim texture_cache_claim(struct output_state *output, const char *path,
+                                       int32_t display_width, int32_t display_height,
+                                       enum wallpaper_mode mode);
+
+/**
+ * Give up a claim after a failed or cancelled decode
+ *
+ * Waiters stay queued for whoever claims the image next.
+ */
+void texture_cache_abandon(struct output_state *output, const char *path,
+                           int32_t display_width, int32_t display_height,
+                           enum wallpaper_mode mode);
+
+/**
+ * Take a reference to a registered texture
+ *
+ * @param path Image path
+ * @param display_width Output width
+ * @param display_height Output height
+ * @param mode Display mode
+ * @param image If not NULL, receives a pixel-less copy of the image (caller frees)
+ * @return Texture, or 0 if none is registered
+ */
+GLuint texture_cache_acquire(const char *path, int32_t display_width, int32_t display_height,
+                             enum wallpaper_mode mode, struct image_data **image);
+
+/**
+ * Register a texture just created from a display-ready image
+ *
+ * The caller's reference becomes the first one. Outputs waiting on the image
+ * are handed its description. Must not be called with a preload_mutex held.
+ *
+ * @param texture Texture created in the current context
+ * @param image Image it was created from (display_width/height set)
+ * @return true if registered, false if the texture stays private
+ */
+bool texture_cache_insert(GLuint texture, const struct image_data *image);
+
+/**
+ * Drop a reference, deleting the texture with the last one
+ *
+ * @param texture Texture to release (a context in the share group must be current)
+ * @return true if the texture is registered here, false if the caller deletes it
+ */
+bool texture_cache_release(GLuint texture);
+
+/**
+ * Forget an output's claims and waits; call before destroying it
+ */
+void texture_cache_cancel(struct output_state *output);
+
+/**
+ * Get sharing counters
+ *
+ * @param textures Receives the number of registered textures
+ * @param shared Receives the number of references handed out beyond the first
+ */
+void texture_cache_get_stats(unsigned long *textures, unsigned long *shared);
+
+#endif /* TEXTURE_CACHE_H */
@@ -0,0 +1,65 @@
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+
+/**
+ * ETC2 compression of wallpaper textures
+ *
+ * An output keeps up to three full-screen wallpaper textures (current, next
+ * and preloaded), about 100 MB of VRAM at 4K as RGBA. ETC2 RGB8 stores a 4x4
+ * block in 8 bytes, an eighth of that, and every GLES 3.0 implementation must
+ * sample it. Encoding runs on the preload thread after decoding and scaling;
+ * the blocks replace the image's pixels and render_create_texture() uploads
+ * them with glCompressedTexImage2D.
+ *
+ * Blocks are written in the ETC1-compatible individual and differential modes,
+ * which every ETC2 decoder reads unchanged.
+ */
+
+/* GL_COMPRESSED_RGB8_ETC2 - not in the GLES2 headers render.c builds against */
+#define TEXTURE_FORMAT_ETC2_RGB8 0x9274
+
+/**
+ * Replace an image's pixels with ETC2 RGB8 blocks
+ *
+ * Images with transparent pixels are left untouched, as ETC2 RGB8 has no
+ * alpha. On success img->pixels is freed and img->compressed holds the blocks.
+ *
+ * @param img Display-ready RGB or RGBA image
+ * @param quality TEXTURE_COMPRESSION_FAST or TEXTURE_COMPRESSION_QUALITY
+ * @return true if the image was compressed
+ */
+bool texture_compress_etc2(struct image_data *img, enum texture_compression quality);
+
+/**
+ * Count an uploaded ETC2 texture until texture_compress_untrack()
+ *
+ * @param texture Texture holding img's blocks
+ * @param img Compressed image, before its blocks are freed
+ */
+void texture_compress_track(GLuint texture, const struct image_data *img);
+
+/**
+ * Stop counting a texture that is about to be deleted
+ *
+ * Untracked textures are ignored, so every wallpaper texture may be passed.
+ *
+ * @param texture Texture name
+ */
+void texture_compress_untrack(GLuint texture);
+
+/**
+ * Get counters of the ETC2 textures currently alive
+ *
+ * @param textures Receives the number of live ETC2 textures
+ * @param compressed_bytes Receives the total size of their ETC2 data
+ * @param rgba_bytes Receives what the same textures would take as RGBA
+ */
+void texture_compress_get_stats(unsigned long *textures, uint64_t *compressed_bytes,
+                                uint64_t *rgba_bytes);
+
+#endif /* TEXTURE_COMPRESS_H */
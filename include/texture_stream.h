@@ -0,0 +1,67 @@
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <GLES2/gl2.h>
+
+struct image_data;
+
+/**
+ * Banded texture uploads through a pixel buffer object (OpenGL ES 3.0)
+ *
+ * A 3840x2160 RGBA wallpaper is a single 33 MB glTexImage2D. A stream instead
+ * allocates the texture once and fills it in horizontal bands: each band is
+ * written into a mapped GL_PIXEL_UNPACK_BUFFER (glMapBufferRange, invalidated
+ * so the driver never waits for the previous band) and copied with
+ * glTexSubImage2D. Callers spread the bands over frames with a byte and time
+ * budget, so other outputs keep their frame rate during a wallpaper change.
+ *
+ * Without HAVE_GLES30, or on an ES 2.0 context, texture_stream_begin()
+ * returns NULL and callers upload in one go with render_create_texture().
+ */
+
+struct texture_stream;
+
+/**
+ * Start streaming an image into a new texture (needs a current context)
+ *
+ * Takes ownership of the image on success.
+ *
+ * @param img Decoded image with pixels
+ * @return Stream, or NULL if streaming is unavailable
+ */
+struct texture_stream *texture_stream_begin(struct image_data *img);
+
+/**
+ * Upload bands until the budget is spent or the texture is complete
+ *
+ * At least one band is uploaded per call.
+ *
+ * @param stream Stream
+ * @param budget_bytes Pixel bytes to upload in this call
+ * @param budget_ms CPU time to spend in this call
+ * @return true once every band has been uploaded
+ */
+bool texture_stream_step(struct texture_stream *stream, size_t budget_bytes, uint64_t budget_ms);
+
+/**
+ * Finish a complete stream
+ *
+ * Frees the stream and the image pixels, like render_create_texture().
+ *
+ * @param stream Completed stream
+ * @param img Receives the image (metadata only)
+ * @return The texture
+ */
+GLuint texture_stream_finish(struct texture_stream *stream, struct image_data **img);
+
+/**
+ * Abandon a stream, deleting its texture and image (needs a current context)
+ *
+ * @param stream Stream (NULL is ignored)
+ */
+void texture_stream_abort(struct texture_stream *stream);
+
+#endif /* TEXTURE_STREAM_H */
@@ -0,0 +1,77 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+#include <stdbool.h>
+
+struct neowall_state;
+struct output_state;
+struct image_data;
+
+/**
+ * Background texture uploads
+ *
+ * glTexImage2D of a decoded 8K wallpaper can block for tens of milliseconds.
+ * Preloaded images are therefore uploaded by a dedicated thread owning a
+ * surfaceless context in the main share group. It creates the texture,
+ * inserts an EGL_KHR_fence_sync fence and publishes the texture in
+ * output->preload_decoded_texture only after the fence has signalled, so the
+ * render thread adopts a complete texture and never touches pixel data.
+ * iChannel0 images of a shader + image cycle take the same route, mipmaps
+ * included, so the cycle deadline only swaps a texture name.
+ *
+ * Requires EGL_KHR_fence_sync and EGL_KHR_surfaceless_context; otherwise the
+ * uploader is not started and the render thread uploads as before.
+ */
+
+/**
+ * Start the upload thread (call after EGL initialization)
+ *
+ * @param state NeoWall global state
+ * @return true if background uploads are available
+ */
+bool texture_uploader_start(struct neowall_state *state);
+
+/**
+ * Stop the upload thread and destroy its context (call before EGL cleanup)
+ */
+void texture_uploader_stop(void);
+
+/**
+ * Queue a decoded preload image for upload
+ *
+ * Takes ownership of the image on success. When the upload completes the
+ * image (pixels freed) and its texture are stored in the output's preload
+ * hand-off fields, preload_upload_pending is set and the output's loop is
+ * woken, exactly like a decode-only preload.
+ *
+ * @param output Output the image was preloaded for
+ * @param image Decoded image
+ * @param path Path of the image
+ * @return true if queued, false if the caller must hand over the image itself
+ */
+bool texture_uploader_submit(struct output_state *output, struct image_data *image,
+                             const char *path);
+
+/**
+ * Queue a decoded iChannel0 image for upload
+ *
+ * Takes ownership of the image on success. The finished texture, with the
+ * output's iChannel0 sampling and mipmaps, is stored with the image in
+ * channel_uploaded_texture and channel_preload_image unless the output has
+ * moved on to another image; channel_upload_pending is then set and the
+ * output's loop is woken.
+ *
+ * @param output Output the image was decoded for
+ * @param image Decoded image in GL row order
+ * @return true if queued, false if the caller must hand over the image itself
+ */
+bool texture_uploader_submit_channel(struct output_state *output, struct image_data *image);
+
+/**
+ * Drop queued uploads for an output and wait for its running one
+ *
+ * @param output Output whose uploads to cancel
+ */
+void texture_uploader_cancel(struct output_state *output);
+
+#endif /* TEXTURE_UPLOADER_H */
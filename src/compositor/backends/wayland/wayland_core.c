@@ -5,8 +5,10 @@
 #include <unistd.h>
 #include <time.h>
 #include "neowall.h"
+#include "constants.h"
 #include "compositor.h"
 #include "xdg-output-unstable-v1-client-protocol.h"
+#include "viewporter-client-protocol.h"
 
 /* Maximum retries and delay when waiting for compositor to be ready */
 #define COMPOSITOR_READY_MAX_RETRIES 5
@@ -101,11 +103,11 @@ static void output_handle_mode(void *data, struct wl_output *wl_output,
                                int32_t refresh) {
     struct output_state *output = data;
     (void)wl_output;
-    (void)refresh;
 
     if (flags & WL_OUTPUT_MODE_CURRENT) {
         output->pixel_width = width;
         output->pixel_height = height;
+        output->refresh_mhz = refresh;  /* Frame cadence is aligned to this */
 
         log_info("Output %s: mode %dx%d @ %d mHz",
                  output->model[0] ? output->model : "unknown",
@@ -207,6 +209,25 @@ static bool output_apply_render_size(struct output_state *output,
         return false;
     }
 
+    /* With a viewport the compositor scales the buffer to the logical size, so
+     * render_scale shrinks the buffer and buffer_scale must stay 1 */
+    if (output->viewport) {
+        float render_scale = output->render_scale > 0.0f ? output->render_scale : 1.0f;
+        physical_w = (int32_t)((float)physical_w * render_scale + 0.5f);
+        physical_h = (int32_t)((float)physical_h * render_scale + 0.5f);
+        if (physical_w < 1) {
+            physical_w = 1;
+        }
+        if (physical_h < 1) {
+            physical_h = 1;
+        }
+
+        wp_viewport_set_destination(output->viewport, logical_w, logical_h);
+        if (output->compositor_surface && output->compositor_surface->scale != 1) {
+            compositor_surface_set_scale(output->compositor_surface, 1);
+        }
+    }
+
     if (output->width == physical_w && output->height == physical_h) {
         if (out_changed) {
             *out_changed = false;
@@ -222,9 +243,11 @@ static bool output_apply_render_size(struct output_state *output,
         *out_changed = true;
     }
 
-    log_info("Output %s: render buffer %dx%d (logical %dx%d @ scale %d) [%s]",
+    log_info("Output %s: render buffer %dx%d (logical %dx%d @ scale %d, render scale %.2f) [%s]",
              output_readable_name(output), physical_w, physical_h,
-             logical_w, logical_h, scale, reason ? reason : "update");
+             logical_w, logical_h, scale,
+             output->viewport ? (double)output->render_scale : 1.0,
+             reason ? reason : "update");
 
     if (output->compositor_surface && output->compositor_surface->egl_window) {
         compositor_surface_resize_egl(output->compositor_surface, physical_w, physical_h);
@@ -235,6 +258,73 @@ static bool output_apply_render_size(struct output_state *output,
     return true;
 }
 
+/* Set up render_scale for a config. Shader configs that allow scaling get a
+ * wp_viewport so the compositor upscales the reduced buffer to the output;
+ * anything else renders at native resolution without one */
+bool output_configure_render_scale(struct output_state *output,
+                                   const struct wallpaper_config *config) {
+    if (!output || !output->state || !config) {
+        return false;
+    }
+
+    struct neowall_state *state = output->state;
+    struct compositor_surface *surface = output->compositor_surface;
+    bool wants_viewport = config->type == WALLPAPER_SHADER && config->render_scale_min < 1.0f;
+
+    if (wants_viewport && !output->viewport) {
+        if (!surface || !surface->wl_surface) {
+            /* Applied again once the surface exists (deferred config) */
+            output->render_scale = 1.0f;
+            return false;
+        }
+
+        if (!state->viewporter) {
+            log_error("Output %s: render_scale needs wp_viewporter, rendering at native resolution",
+                      output_readable_name(output));
+            output->render_scale = 1.0f;
+            return false;
+        }
+
+        output->viewport = wp_viewporter_get_viewport(state->viewporter, surface->wl_surface);
+        if (!output->viewport) {
+            log_error("Failed to create viewport for output %s", output_readable_name(output));
+            output->render_scale = 1.0f;
+            return false;
+        }
+        log_debug("Created viewport for output %s", output_readable_name(output));
+    } else if (!wants_viewport && output->viewport) {
+        wp_viewport_destroy(output->viewport);
+        output->viewport = NULL;
+        if (surface) {
+            compositor_surface_set_scale(surface, output_normalized_scale(output));
+        }
+        log_debug("Destroyed viewport for output %s", output_readable_name(output));
+    }
+
+    output->render_scale = wants_viewport ? config->render_scale : 1.0f;
+    output->render_cost_ms = 0.0;
+    output->render_scale_time = get_time_ms();
+    output_apply_render_size(output, "render scale config", NULL);
+    return true;
+}
+
+/* Resize the render buffer to a new render_scale (adaptive controller step).
+ * Only meaningful while a viewport is attached */
+bool output_set_render_scale(struct output_state *output, float scale) {
+    if (!output || !output->viewport) {
+        return false;
+    }
+
+    if (scale > 1.0f) {
+        scale = 1.0f;
+    } else if (scale < RENDER_SCALE_FLOOR) {
+        scale = RENDER_SCALE_FLOOR;
+    }
+
+    output->render_scale = scale;
+    return output_apply_render_size(output, "adaptive render scale", NULL);
+}
+
 /* Wait for compositor outputs to be available with minimal retries
  * This is compositor-agnostic and works with any Wayland compositor */
 static bool wait_for_outputs_configured(struct neowall_state *state) {
@@ -369,6 +459,9 @@ static void registry_handle_global(void *data, struct wl_registry *registry,
         state->xdg_output_manager = wl_registry_bind(registry, name,
                                                       &zxdg_output_manager_v1_interface, 2);
         log_debug("Bound to xdg_output_manager");
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+        state->viewporter = wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
+        log_debug("Bound to wp_viewporter");
     } else if (strcmp(interface, wl_output_interface.name) == 0) {
         struct wl_output *output_obj = wl_registry_bind(registry, name,
                                                          &wl_output_interface, 3);
@@ -547,6 +640,11 @@ void wayland_cleanup(struct neowall_state *state) {
     }
 
     /* Destroy Wayland objects */
+    if (state->viewporter) {
+        wp_viewporter_destroy(state->viewporter);
+        state->viewporter = NULL;
+    }
+
     if (state->shm) {
         wl_shm_destroy(state->shm);
         state->shm = NULL;
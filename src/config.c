@@ -12,7 +12,9 @@
 #include "vibe.h"
 #include "neowall.h"
 #include "config_access.h"
+#include "constants.h"
 #include "compositor.h"
+#include "shader_compiler.h"
 
 /* ============================================================================
  * CONFIGURATION PHILOSOPHY
@@ -441,6 +443,20 @@ static ValidationResult validate_shader_speed(double speed) {
     return VALIDATION_OK();
 }
 
+static ValidationResult validate_render_scale(double scale) {
+    ValidationResult result;
+    
+    if (scale < RENDER_SCALE_FLOOR || scale > 1.0) {
+        result.valid = false;
+        snprintf(result.error_message, sizeof(result.error_message), 
+                "Render scale must be between %.2f and 1.0 (got %.2f)",
+                (double)RENDER_SCALE_FLOOR, scale);
+        return result;
+    }
+    
+    return VALIDATION_OK();
+}
+
 static ValidationResult validate_transition_duration(double duration) {
     ValidationResult result;
     
@@ -461,6 +477,27 @@ static ValidationResult validate_transition_duration(double duration) {
     return VALIDATION_OK();
 }
 
+/* Put the cycle in a random order that only changes with the seed or the list,
+ * so the saved cycle index and other outputs cycling the same list agree */
+static void shuffle_cycle_paths(struct wallpaper_config *config, uint32_t seed) {
+    uint32_t x = seed ? seed : 0x9e3779b9u;
+    for (size_t i = config->cycle_count - 1; i > 0; i--) {
+        /* xorshift32 */
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        size_t j = x % (i + 1);
+        char *tmp = config->cycle_paths[i];
+        config->cycle_paths[i] = config->cycle_paths[j];
+        config->cycle_paths[j] = tmp;
+    }
+
+    /* The first entry is the initial wallpaper */
+    char *first = config->type == WALLPAPER_SHADER ? config->shader_path : config->path;
+    strncpy(first, config->cycle_paths[0], MAX_PATH_LENGTH - 1);
+    first[MAX_PATH_LENGTH - 1] = '\0';
+}
+
 /* Initialize config with safe defaults */
 static void init_wallpaper_config_defaults(struct wallpaper_config *config) {
     config->type = WALLPAPER_IMAGE;
@@ -473,12 +510,108 @@ static void init_wallpaper_config_defaults(struct wallpaper_config *config) {
     config->shader_speed = 1.0f;
     config->shader_fps = 60;  /* Default 60 FPS for shaders */
     config->show_fps = false;  /* Default: no FPS watermark */
+    config->render_scale = 1.0f;  /* Default: native resolution */
+    config->render_scale_min = 1.0f;
+    config->upload_budget_mb = DEFAULT_UPLOAD_BUDGET_MB;
+    config->texture_compression = TEXTURE_COMPRESSION_NONE;
+    config->preload_count = DEFAULT_PRELOAD_COUNT;
+    config->preload_budget_mb = DEFAULT_PRELOAD_BUDGET_MB;
+    config->shuffle = false;
+    config->channel_max_size = DEFAULT_CHANNEL_MAX_SIZE;
     config->cycle = false;
     config->cycle_paths = NULL;
     config->cycle_count = 0;
     config->current_cycle_index = 0;
     config->channel_paths = NULL;
     config->channel_count = 0;
+    for (size_t i = 0; i < MAX_CHANNEL_SAMPLERS; i++) {
+        config->channel_samplers[i] = (struct channel_sampler){
+            .filter = CHANNEL_FILTER_LINEAR,
+            .wrap = CHANNEL_WRAP_DEFAULT,
+            .mipmap = true,
+        };
+    }
+}
+
+static bool parse_channel_filter(const VibeValue *value, struct channel_sampler *sampler) {
+    if (value->type != VIBE_TYPE_STRING) {
+        return false;
+    }
+    if (strcmp(value->as_string, "linear") == 0) {
+        sampler->filter = CHANNEL_FILTER_LINEAR;
+    } else if (strcmp(value->as_string, "nearest") == 0) {
+        sampler->filter = CHANNEL_FILTER_NEAREST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_channel_wrap(const VibeValue *value, struct channel_sampler *sampler) {
+    if (value->type != VIBE_TYPE_STRING) {
+        return false;
+    }
+    if (strcmp(value->as_string, "clamp") == 0) {
+        sampler->wrap = CHANNEL_WRAP_CLAMP;
+    } else if (strcmp(value->as_string, "repeat") == 0) {
+        sampler->wrap = CHANNEL_WRAP_REPEAT;
+    } else if (strcmp(value->as_string, "mirror") == 0) {
+        sampler->wrap = CHANNEL_WRAP_MIRROR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parse_channel_mipmap(const VibeValue *value, struct channel_sampler *sampler) {
+    if (value->type != VIBE_TYPE_BOOLEAN) {
+        return false;
+    }
+    sampler->mipmap = value->as_boolean;
+    return true;
+}
+
+/* Parse a channel_filter/channel_wrap/channel_mipmap key: an array lining up
+ * with 'channels', or a single value for every channel */
+static bool parse_channel_sampler_key(VibeValue *obj, const char *key,
+                                      bool (*parse)(const VibeValue *, struct channel_sampler *),
+                                      const char *expected, struct wallpaper_config *config,
+                                      const char *context_name) {
+    VibeValue *val = vibe_object_get(obj->as_object, key);
+    if (!val) {
+        return true;
+    }
+
+    if (config->type != WALLPAPER_SHADER) {
+        log_error("[%s] INVALID CONFIG: '%s' specified in IMAGE mode. "
+                 "It only applies to iChannel textures of shaders.", context_name, key);
+        return false;
+    }
+
+    if (val->type != VIBE_TYPE_ARRAY) {
+        for (size_t i = 0; i < MAX_CHANNEL_SAMPLERS; i++) {
+            if (!parse(val, &config->channel_samplers[i])) {
+                log_error("[%s] '%s' must be %s", context_name, key, expected);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t count = val->as_array->count;
+    if (count > MAX_CHANNEL_SAMPLERS) {
+        log_error("[%s] '%s' lists %zu channels (at most %d)", context_name, key, count,
+                 MAX_CHANNEL_SAMPLERS);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        VibeValue *elem = val->as_array->values[i];
+        if (!elem || !parse(elem, &config->channel_samplers[i])) {
+            log_error("[%s] %s[%zu] must be %s", context_name, key, i, expected);
+            return false;
+        }
+    }
+    return true;
 }
 
 /* Parse wallpaper configuration with strict validation */
@@ -796,7 +929,163 @@ static bool parse_wallpaper_config(VibeValue *obj, struct wallpaper_config *conf
         log_info("[%s] FPS watermark: %s", context_name, config->show_fps ? "enabled" : "disabled");
     }
     
-    /* Parse channels (only relevant for shader mode) */
+    /* Parse render_scale / render_scale_min (only relevant for shader mode) */
+    const char *scale_keys[] = { "render_scale", "render_scale_min" };
+    double scale_values[2] = { config->render_scale, -1.0 };
+    for (size_t i = 0; i < 2; i++) {
+        VibeValue *scale_val = vibe_object_get(obj->as_object, scale_keys[i]);
+        if (!scale_val) {
+            continue;
+        }
+        
+        if (scale_val->type == VIBE_TYPE_FLOAT) {
+            scale_values[i] = scale_val->as_float;
+        } else if (scale_val->type == VIBE_TYPE_INTEGER) {
+            scale_values[i] = (double)scale_val->as_integer;
+        } else {
+            log_error("[%s] '%s' must be a number", context_name, scale_keys[i]);
+            return false;
+        }
+        
+        ValidationResult scale_validation = validate_render_scale(scale_values[i]);
+        if (!scale_validation.valid) {
+            log_error("[%s] Invalid %s: %s", context_name, scale_keys[i],
+                     scale_validation.error_message);
+            return false;
+        }
+        
+        if (config->type != WALLPAPER_SHADER) {
+            log_error("[%s] INVALID CONFIG: '%s' specified in IMAGE mode. "
+                     "Render scale only applies to GLSL shaders. This setting is invalid for images.", 
+                     context_name, scale_keys[i]);
+            return false;
+        }
+    }
+    
+    /* Without render_scale_min the scale is fixed; with it, it adapts between the two */
+    if (scale_values[1] < 0.0) {
+        scale_values[1] = scale_values[0];
+    } else if (scale_values[1] > scale_values[0]) {
+        log_error("[%s] Invalid render_scale_min: %.2f is above render_scale %.2f",
+                 context_name, scale_values[1], scale_values[0]);
+        return false;
+    }
+    
+    config->render_scale = (float)scale_values[0];
+    config->render_scale_min = (float)scale_values[1];
+    if (config->render_scale_min < config->render_scale) {
+        log_info("[%s] Adaptive render scale: %.2f - %.2f", context_name,
+                 scale_values[1], scale_values[0]);
+    } else if (config->render_scale < 1.0f) {
+        log_info("[%s] Render scale set to: %.2f", context_name, scale_values[0]);
+    }
+    
+    /* Parse upload_budget (MB of texture data uploaded per frame) */
+    VibeValue *upload_budget_val = vibe_object_get(obj->as_object, "upload_budget");
+    if (upload_budget_val) {
+        if (upload_budget_val->type != VIBE_TYPE_INTEGER) {
+            log_error("[%s] 'upload_budget' must be a whole number of megabytes", context_name);
+            return false;
+        }
+        if (upload_budget_val->as_integer < 1 || upload_budget_val->as_integer > MAX_UPLOAD_BUDGET_MB) {
+            log_error("[%s] Invalid upload_budget: %lld (must be between 1 and %d)",
+                     context_name, (long long)upload_budget_val->as_integer, MAX_UPLOAD_BUDGET_MB);
+            return false;
+        }
+        config->upload_budget_mb = (int)upload_budget_val->as_integer;
+        log_info("[%s] Texture upload budget: %d MB per frame", context_name, config->upload_budget_mb);
+    }
+
+    /* Parse texture_compression (ETC2 wallpaper textures, image mode only) */
+    VibeValue *compression_val = vibe_object_get(obj->as_object, "texture_compression");
+    if (compression_val) {
+        if (compression_val->type != VIBE_TYPE_STRING) {
+            log_error("[%s] 'texture_compression' must be a string", context_name);
+            return false;
+        }
+
+        if (config->type == WALLPAPER_SHADER) {
+            log_error("[%s] INVALID CONFIG: 'texture_compression' specified in SHADER mode. "
+                     "Compression only applies to image wallpapers.", context_name);
+            return false;
+        }
+
+        const char *value = compression_val->as_string;
+        if (strcmp(value, "none") == 0) {
+            config->texture_compression = TEXTURE_COMPRESSION_NONE;
+        } else if (strcmp(value, "fast") == 0) {
+            config->texture_compression = TEXTURE_COMPRESSION_FAST;
+        } else if (strcmp(value, "quality") == 0) {
+            config->texture_compression = TEXTURE_COMPRESSION_QUALITY;
+        } else {
+            log_error("[%s] Invalid texture_compression: '%s' (must be none, fast or quality)",
+                     context_name, value);
+            return false;
+        }
+        log_info("[%s] Texture compression set to: %s", context_name, value);
+    }
+
+    /* Parse preload_count (upcoming cycle entries prepared ahead, image mode only) */
+    VibeValue *preload_count_val = vibe_object_get(obj->as_object, "preload_count");
+    if (preload_count_val) {
+        if (preload_count_val->type != VIBE_TYPE_INTEGER) {
+            log_error("[%s] 'preload_count' must be a whole number", context_name);
+            return false;
+        }
+        if (config->type == WALLPAPER_SHADER) {
+            log_error("[%s] INVALID CONFIG: 'preload_count' specified in SHADER mode. "
+                     "Only image cycles are decoded ahead.", context_name);
+            return false;
+        }
+        if (preload_count_val->as_integer < 1 || preload_count_val->as_integer > MAX_PRELOAD_COUNT) {
+            log_error("[%s] Invalid preload_count: %lld (must be between 1 and %d)",
+                     context_name, (long long)preload_count_val->as_integer, MAX_PRELOAD_COUNT);
+            return false;
+        }
+        config->preload_count = (int)preload_count_val->as_integer;
+        log_info("[%s] Preloading %d upcoming wallpapers", context_name, config->preload_count);
+    }
+
+    /* Parse preload_budget (MB of RAM for decoded lookahead images) */
+    VibeValue *preload_budget_val = vibe_object_get(obj->as_object, "preload_budget");
+    if (preload_budget_val) {
+        if (preload_budget_val->type != VIBE_TYPE_INTEGER) {
+            log_error("[%s] 'preload_budget' must be a whole number of megabytes", context_name);
+            return false;
+        }
+        if (config->type == WALLPAPER_SHADER) {
+            log_error("[%s] INVALID CONFIG: 'preload_budget' specified in SHADER mode. "
+                     "Only image cycles are decoded ahead.", context_name);
+            return false;
+        }
+        if (preload_budget_val->as_integer < 0 ||
+            preload_budget_val->as_integer > MAX_PRELOAD_BUDGET_MB) {
+            log_error("[%s] Invalid preload_budget: %lld (must be between 0 and %d)",
+                     context_name, (long long)preload_budget_val->as_integer, MAX_PRELOAD_BUDGET_MB);
+            return false;
+        }
+        config->preload_budget_mb = (int)preload_budget_val->as_integer;
+        log_info("[%s] Preload budget: %d MB", context_name, config->preload_budget_mb);
+    }
+
+    /* Parse shuffle (random cycle order, kept across restarts) */
+    VibeValue *shuffle_val = vibe_object_get(obj->as_object, "shuffle");
+    if (shuffle_val) {
+        if (shuffle_val->type != VIBE_TYPE_BOOLEAN) {
+            log_error("[%s] 'shuffle' must be true or false", context_name);
+            return false;
+        }
+        config->shuffle = shuffle_val->as_boolean;
+        if (config->shuffle && config->cycle_count > 1) {
+            shuffle_cycle_paths(config, get_shuffle_seed());
+            log_info("[%s] Cycling %zu entries in shuffled order", context_name, config->cycle_count);
+        } else if (config->shuffle) {
+            log_info("[%s] Shuffle specified but nothing to cycle. "
+                    "Shuffle will have no effect.", context_name);
+        }
+    }
+    
+        /* Parse channels (only relevant for shader mode) */
     VibeValue *channels_val = vibe_object_get(obj->as_object, "channels");
     if (channels_val) {
         if (channels_val->type != VIBE_TYPE_ARRAY) {
@@ -843,10 +1132,46 @@ static bool parse_wallpaper_config(VibeValue *obj, struct wallpaper_config *conf
         }
     }
     
+    /* Parse channel_max_size (longest side of iChannel images) */
+    VibeValue *channel_max_val = vibe_object_get(obj->as_object, "channel_max_size");
+    if (channel_max_val) {
+        if (channel_max_val->type != VIBE_TYPE_INTEGER) {
+            log_error("[%s] 'channel_max_size' must be a whole number of pixels", context_name);
+            return false;
+        }
+        if (config->type != WALLPAPER_SHADER) {
+            log_error("[%s] INVALID CONFIG: 'channel_max_size' specified in IMAGE mode. "
+                     "It only applies to images fed to a shader.", context_name);
+            return false;
+        }
+        if (channel_max_val->as_integer < MIN_CHANNEL_MAX_SIZE ||
+            channel_max_val->as_integer > MAX_CHANNEL_MAX_SIZE) {
+            log_error("[%s] Invalid channel_max_size: %lld (must be between %d and %d)",
+                     context_name, (long long)channel_max_val->as_integer,
+                     MIN_CHANNEL_MAX_SIZE, MAX_CHANNEL_MAX_SIZE);
+            return false;
+        }
+        config->channel_max_size = (int)channel_max_val->as_integer;
+        log_info("[%s] iChannel images limited to %d pixels", context_name, config->channel_max_size);
+    }
+
+    /* Parse per-channel sampling of iChannel textures */
+    if (!parse_channel_sampler_key(obj, "channel_filter", parse_channel_filter,
+                                   "linear or nearest", config, context_name) ||
+        !parse_channel_sampler_key(obj, "channel_wrap", parse_channel_wrap,
+                                   "clamp, repeat or mirror", config, context_name) ||
+        !parse_channel_sampler_key(obj, "channel_mipmap", parse_channel_mipmap,
+                                   "true or false", config, context_name)) {
+        return false;
+    }
+
     /* Warn about unknown keys */
     const char *known_keys[] = {
         "path", "shader", "mode", "duration", "transition", 
-        "transition_duration", "shader_speed", "channels", "shader_fps", "show_fps"
+        "transition_duration", "shader_speed", "channels", "shader_fps", "show_fps",
+        "render_scale", "render_scale_min", "upload_budget", "texture_compression",
+        "preload_count", "preload_budget", "shuffle", "channel_max_size",
+        "channel_filter", "channel_wrap", "channel_mipmap"
     };
     size_t known_key_count = sizeof(known_keys) / sizeof(known_keys[0]);
     
@@ -1919,6 +2244,7 @@ void config_reload(struct neowall_state *state) {
         }
         
         /* Clear all shader uniform locations */
+        free(output->shader_uniforms.bindings);
         memset(&output->shader_uniforms, 0, sizeof(output->shader_uniforms));
         if (output->shader_uniforms.iChannel) {
             free(output->shader_uniforms.iChannel);
@@ -1940,6 +2266,7 @@ void config_reload(struct neowall_state *state) {
         output->transition_start_time = 0;
         output->transition_progress = 0.0f;
         output->shader_start_time = 0;
+        shader_compiler_cancel(output);
         output->shader_fade_start_time = 0;
         output->last_cycle_time = get_time_ms();  /* Reset cycle timer */
         output->pending_shader_path[0] = '\0';
@@ -0,0 +1,260 @@
+#define _GNU_SOURCE     /* SCHED_IDLE */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include "neowall.h"
+#include "constants.h"
+#include "decode_pool.h"
+#include "parallel.h"
+
+struct decode_job {
+    void *owner;
+    enum decode_priority priority;
+    bool has_key;
+    char key[DECODE_KEY_LENGTH];
+    decode_job_fn run;
+    decode_discard_fn discard;
+    void *arg;
+    atomic_bool_t cancelled;
+    struct decode_job *next;
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;   /* A running job returned */
+static pthread_t pool_threads[DECODE_POOL_THREADS];
+static uint32_t pool_size = 0;
+static bool pool_stop = false;
+static struct decode_job *job_queues[DECODE_PRIORITY_COUNT];
+static struct decode_job *jobs_running[DECODE_POOL_THREADS];  /* Indexed by worker */
+
+static void discard_job(struct decode_job *job) {
+    if (job->discard) {
+        job->discard(job->arg);
+    }
+    free(job);
+}
+
+/* Unlink and discard queued jobs matching owner (and priority unless negative);
+ * called with pool_lock held */
+static void discard_queued(void *owner, int priority) {
+    for (int p = 0; p < DECODE_PRIORITY_COUNT; p++) {
+        if (priority >= 0 && p != priority) {
+            continue;
+        }
+        struct decode_job **link = &job_queues[p];
+        while (*link) {
+            if ((*link)->owner == owner) {
+                struct decode_job *job = *link;
+                *link = job->next;
+                discard_job(job);
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+}
+
+static bool same_work(const struct decode_job *a, const struct decode_job *b) {
+    return a->owner == b->owner && a->priority == b->priority && a->has_key && b->has_key &&
+           strcmp(a->key, b->key) == 0 && !atomic_load(&a->cancelled);
+}
+
+static bool is_duplicate(const struct decode_job *job) {
+    for (const struct decode_job *q = job_queues[job->priority]; q; q = q->next) {
+        if (same_work(q, job)) {
+            return true;
+        }
+    }
+    for (uint32_t i = 0; i < pool_size; i++) {
+        if (jobs_running[i] && same_work(jobs_running[i], job)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Keep decode work off the CPU time rendering needs. Both calls only affect
+ * the calling thread on Linux. */
+static void lower_priority(void) {
+#ifdef SCHED_IDLE
+    struct sched_param param = { .sched_priority = 0 };
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0) {
+        return;
+    }
+#endif
+    if (setpriority(PRIO_PROCESS, 0, DECODE_POOL_NICE) != 0) {
+        log_debug("Decode worker keeps normal priority");
+    }
+}
+
+static void *worker_func(void *arg) {
+    uint32_t slot = (uint32_t)(uintptr_t)arg;
+
+    lower_priority();
+    /* Bands on the normal-priority pool would defeat the lower priority */
+    parallel_set_thread_serial(true);
+
+    pthread_mutex_lock(&pool_lock);
+    while (!pool_stop) {
+        struct decode_job *job = NULL;
+        for (int p = 0; p < DECODE_PRIORITY_COUNT && !job; p++) {
+            job = job_queues[p];
+            if (job) {
+                job_queues[p] = job->next;
+            }
+        }
+        if (!job) {
+            pthread_cond_wait(&work_cond, &pool_lock);
+            continue;
+        }
+
+        jobs_running[slot] = job;
+        pthread_mutex_unlock(&pool_lock);
+
+        job->run(job->arg, &job->cancelled);
+
+        pthread_mutex_lock(&pool_lock);
+        jobs_running[slot] = NULL;
+        free(job);
+        pthread_cond_broadcast(&idle_cond);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+bool decode_pool_start(void) {
+    pthread_mutex_lock(&pool_lock);
+    if (pool_size > 0) {
+        pthread_mutex_unlock(&pool_lock);
+        return true;
+    }
+
+    pool_stop = false;
+    for (uint32_t i = 0; i < DECODE_POOL_THREADS; i++) {
+        if (pthread_create(&pool_threads[i], NULL, worker_func, (void *)(uintptr_t)i) != 0) {
+            log_error("Failed to start decode worker thread %u", i);
+            break;
+        }
+        pool_size++;
+    }
+    uint32_t started = pool_size;
+    pthread_mutex_unlock(&pool_lock);
+
+    if (started == 0) {
+        return false;
+    }
+    log_debug("Decode workers started: %u", started);
+    return true;
+}
+
+void decode_pool_stop(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_stop = true;
+    for (int p = 0; p < DECODE_PRIORITY_COUNT; p++) {
+        while (job_queues[p]) {
+            struct decode_job *job = job_queues[p];
+            job_queues[p] = job->next;
+            discard_job(job);
+        }
+    }
+    for (uint32_t i = 0; i < pool_size; i++) {
+        if (jobs_running[i]) {
+            atomic_store(&jobs_running[i]->cancelled, true);
+        }
+    }
+    pthread_cond_broadcast(&work_cond);
+    uint32_t count = pool_size;
+    pthread_mutex_unlock(&pool_lock);
+
+    for (uint32_t i = 0; i < count; i++) {
+        pthread_join(pool_threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    pool_size = 0;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+bool decode_pool_submit(const struct decode_request *request) {
+    if (!request || !request->run) {
+        return false;
+    }
+
+    struct decode_job *job = calloc(1, sizeof(*job));
+    if (!job) {
+        log_error("Failed to allocate decode job");
+        if (request->discard) {
+            request->discard(request->arg);
+        }
+        return false;
+    }
+    job->owner = request->owner;
+    job->priority = request->priority;
+    job->run = request->run;
+    job->discard = request->discard;
+    job->arg = request->arg;
+    atomic_store(&job->cancelled, false);
+    if (request->key) {
+        job->has_key = true;
+        strncpy(job->key, request->key, sizeof(job->key) - 1);
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    if (pool_stop || pool_size == 0) {
+        pthread_mutex_unlock(&pool_lock);
+        discard_job(job);
+        return false;
+    }
+
+    if (is_duplicate(job)) {
+        pthread_mutex_unlock(&pool_lock);
+        log_debug("Decode job already pending: %s", job->key);
+        discard_job(job);
+        return true;
+    }
+
+    if (request->supersede) {
+        discard_queued(job->owner, (int)job->priority);
+        for (uint32_t i = 0; i < pool_size; i++) {
+            struct decode_job *running = jobs_running[i];
+            if (running && running->owner == job->owner && running->priority == job->priority) {
+                atomic_store(&running->cancelled, true);
+            }
+        }
+    }
+
+    struct decode_job **tail = &job_queues[job->priority];
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = job;
+    pthread_cond_signal(&work_cond);
+    pthread_mutex_unlock(&pool_lock);
+    return true;
+}
+
+void decode_pool_cancel(void *owner) {
+    pthread_mutex_lock(&pool_lock);
+    discard_queued(owner, -1);
+
+    bool waiting = true;
+    while (waiting) {
+        waiting = false;
+        for (uint32_t i = 0; i < pool_size; i++) {
+            if (jobs_running[i] && jobs_running[i]->owner == owner) {
+                atomic_store(&jobs_running[i]->cancelled, true);
+                waiting = true;
+            }
+        }
+        if (waiting) {
+            pthread_cond_wait(&idle_cond, &pool_lock);
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
@@ -9,11 +9,38 @@
 #include "../../include/compositor.h"
 #include "../../include/egl/egl_core.h"
 #include "../../include/egl/capability.h"
+#include "../../include/gl_debug.h"
 
 /**
  * EGL Core Dispatch System - Simplified for compilation
  */
 
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
+/* Damage-aware presentation (EGL_KHR/EXT_swap_buffers_with_damage, EGL_EXT_buffer_age).
+ * Resolved once in egl_core_init; the EXT and KHR entry points share a signature */
+typedef EGLBoolean (*swap_buffers_with_damage_fn)(EGLDisplay display, EGLSurface surface,
+                                                  const EGLint *rects, EGLint n_rects);
+static swap_buffers_with_damage_fn swap_buffers_with_damage = NULL;
+static bool has_buffer_age = false;
+
+static void egl_core_load_damage_extensions(EGLDisplay display) {
+    if (egl_has_extension(display, "EGL_KHR_swap_buffers_with_damage")) {
+        swap_buffers_with_damage = (swap_buffers_with_damage_fn)
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    }
+    if (!swap_buffers_with_damage && egl_has_extension(display, "EGL_EXT_swap_buffers_with_damage")) {
+        swap_buffers_with_damage = (swap_buffers_with_damage_fn)
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+    has_buffer_age = egl_has_extension(display, "EGL_EXT_buffer_age");
+
+    log_info("Damage tracking: swap with damage %s, buffer age %s",
+             swap_buffers_with_damage ? "yes" : "no", has_buffer_age ? "yes" : "no");
+}
+
 const char *egl_error_string(EGLint error) {
     switch (error) {
         case EGL_SUCCESS: return "Success";
@@ -81,6 +108,7 @@ bool egl_core_init(struct neowall_state *state) {
     
     /* Detect capabilities */
     egl_detect_capabilities(state->egl_display, &state->gl_caps);
+    egl_core_load_damage_extensions(state->egl_display);
     
     /* Try ES 3.0 first, then ES 2.0 */
     const EGLint config_attribs_es3[] = {
@@ -183,13 +211,13 @@ bool egl_core_init(struct neowall_state *state) {
     
     output = state->outputs;
     if (output && output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
-        /* Enable vsync to reduce GPU usage and prevent tearing */
-        if (!eglSwapInterval(state->egl_display, 1)) {
+        /* Non-blocking swaps - the event loop paces frames with wl_surface.frame callbacks */
+        if (!eglSwapInterval(state->egl_display, 0)) {
             EGLint err = eglGetError();
-            log_debug("Could not set swap interval (vsync): 0x%x - continuing without vsync", err);
+            log_debug("Could not set swap interval 0: 0x%x - swaps may block on vblank", err);
             log_debug("This is normal on some compositors/drivers and won't affect functionality");
         } else {
-            log_info("Enabled vsync (swap interval = 1) for power efficiency");
+            log_info("Swap interval 0, frames paced by compositor frame callbacks");
         }
         
         if (output->compositor_surface && 
@@ -198,6 +226,7 @@ bool egl_core_init(struct neowall_state *state) {
             gles_detect_capabilities_for_context(state->egl_display, 
                                                  state->egl_context,
                                                  &state->gl_caps);
+            gl_debug_setup_context();
             
             log_info("Using OpenGL ES %s (%s Shadertoy compatibility)",
                      gles_version_string(state->gl_caps.gles_version),
@@ -281,6 +310,23 @@ void egl_core_cleanup(struct neowall_state *state) {
     }
 }
 
+EGLContext egl_core_create_shared_context(struct neowall_state *state) {
+    const EGLint context_attribs_es3[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 0,
+        EGL_NONE
+    };
+    const EGLint context_attribs_es2[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    const EGLint *attribs = (state->gl_caps.gles_version >= GLES_VERSION_3_0) ?
+                            context_attribs_es3 : context_attribs_es2;
+
+    return eglCreateContext(state->egl_display, state->egl_config,
+                            state->egl_context, attribs);
+}
+
 bool egl_core_make_current(struct neowall_state *state, struct output_state *output) {
     if (!state || state->egl_display == EGL_NO_DISPLAY) return false;
     
@@ -300,3 +346,28 @@ bool egl_core_swap_buffers(struct neowall_state *state, struct output_state *out
     if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) return false;
     return eglSwapBuffers(state->egl_display, output->compositor_surface->egl_surface);
 }
+
+bool egl_core_swap_buffers_with_damage(struct neowall_state *state, struct output_state *output,
+                                       const EGLint *rects, EGLint n_rects) {
+    if (!state || !output || state->egl_display == EGL_NO_DISPLAY) return false;
+    if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) return false;
+
+    /* n_rects == 0 means "whole surface" for the extension, same as a plain swap */
+    if (swap_buffers_with_damage && rects && n_rects > 0) {
+        return swap_buffers_with_damage(state->egl_display, output->compositor_surface->egl_surface,
+                                        rects, n_rects);
+    }
+    return eglSwapBuffers(state->egl_display, output->compositor_surface->egl_surface);
+}
+
+EGLint egl_core_buffer_age(struct neowall_state *state, struct output_state *output) {
+    if (!has_buffer_age || !state || !output || state->egl_display == EGL_NO_DISPLAY) return 0;
+    if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) return 0;
+
+    EGLint age = 0;
+    if (!eglQuerySurface(state->egl_display, output->compositor_surface->egl_surface,
+                         EGL_BUFFER_AGE_EXT, &age)) {
+        return 0;
+    }
+    return age;
+}
@@ -5,6 +5,7 @@
 #include <poll.h>
 #include <unistd.h>
 #include <time.h>
+#include <math.h>
 #include <sys/timerfd.h>
 #include <sys/eventfd.h>
 #include <sys/signalfd.h>
@@ -12,6 +13,14 @@
 #include "config_access.h"
 #include "constants.h"
 #include "compositor.h"
+#include "render_thread.h"
+#include "egl/egl_core.h"
+#include "shader_disk_cache.h"
+#include "image_disk_cache.h"
+#include "texture_compress.h"
+#include "texture_cache.h"
+#include "lookahead.h"
+#include "texture_stream.h"
 
 /* Forward declarations */
 extern void handle_signal_from_fd(struct neowall_state *state, int signum);
@@ -19,64 +28,314 @@ extern void config_reload(struct neowall_state *state);
 
 static struct neowall_state *event_loop_state = NULL;
 
-/* Update timerfd to wake up at next cycle time */
-static void update_cycle_timer(struct neowall_state *state) {
-    if (!state || state->timer_fd < 0) {
+/* Check if an output is continuously animating (transition or live shader) */
+bool event_loop_output_animating(struct output_state *output) {
+    if (output->transition_start_time > 0 &&
+        output->config->transition != TRANSITION_NONE) {
+        return true;
+    }
+    /* A shader whose program has no active time uniform (every Shadertoy time
+     * input maps to _neowall_time) renders the same image each frame; after its
+     * first frame (-2 = not looked up yet) it only redraws on demand */
+    return output->config->type == WALLPAPER_SHADER &&
+           !output->shader_load_failed &&
+           output->live_shader_program != 0 &&
+           (output->shader_uniforms.u_time != -1 || output->shader_fade_start_time > 0);
+}
+
+/* CPU time consumed by the calling thread - excludes time blocked on the GPU */
+static uint64_t thread_cpu_time_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* When a static output's FPS watermark is due for its once-per-window refresh
+ * (a watermark-only frame), 0 if it has none */
+static uint64_t output_watermark_deadline(struct output_state *output) {
+    if (!output->config->show_fps || output->config->type != WALLPAPER_SHADER ||
+        output->fps_last_log_time == 0) {
+        return 0;
+    }
+    return output->fps_last_log_time + FPS_WINDOW_MS;
+}
+
+/* A compiled program is waiting to start the cross-fade: a finished compile,
+ * or the lookahead for the shader the cycle just moved to */
+static bool output_shader_swap_ready(struct output_state *output) {
+    return atomic_load(&output->shader_compile_ready) ||
+           (output->pending_shader_path[0] != '\0' && atomic_load(&output->shader_preload_ready));
+}
+
+/* Whether the output has anything to draw: a requested redraw, or only its watermark */
+bool event_loop_output_needs_frame(struct output_state *output, uint64_t now) {
+    if (output->needs_redraw || output_shader_swap_ready(output)) {
+        return true;
+    }
+    uint64_t watermark_deadline = output_watermark_deadline(output);
+    return watermark_deadline != 0 && now >= watermark_deadline;
+}
+
+/* Refresh period of the output's current mode in milliseconds */
+static double output_refresh_period_ms(struct output_state *output) {
+    int32_t refresh_mhz = output->refresh_mhz > 0 ? output->refresh_mhz : DEFAULT_REFRESH_MHZ;
+    return 1000000.0 / (double)refresh_mhz;
+}
+
+/* Minimum interval between shader frames (0 = every frame callback).
+ * shader_fps is an upper cap, rounded to a whole number of refresh periods so
+ * the cadence stays vblank-aligned: 60 fps on 144 Hz renders every 3rd vblank
+ * (48 fps) instead of jittering between 2 and 3 */
+static double output_frame_interval_ms(struct output_state *output) {
+    if (output->config->type != WALLPAPER_SHADER || output->config->shader_fps <= 0) {
+        return 0.0;
+    }
+
+    double period_ms = output_refresh_period_ms(output);
+    double refresh_hz = 1000.0 / period_ms;
+    int vblanks = (int)ceil(refresh_hz / (double)output->config->shader_fps - 0.01);
+    if (vblanks <= 1) {
+        return 0.0;
+    }
+    return period_ms * (double)vblanks;
+}
+
+/* Adaptive render_scale: steer the smoothed render + swap time of shader frames
+ * into [LOW_LOAD, HIGH_LOAD] of the frame budget by resizing the buffer that the
+ * compositor upscales. Swap time counts because the driver throttles there once
+ * the GPU falls behind */
+static void output_adapt_render_scale(struct output_state *output, uint64_t cost_ms,
+                                      uint64_t now) {
+    const struct wallpaper_config *config = output->config;
+    if (!output->viewport || config->render_scale_min >= config->render_scale) {
+        return;
+    }
+
+    /* Exponential moving average, seeded by the first sample after a resize */
+    if (output->render_cost_ms <= 0.0) {
+        output->render_cost_ms = (double)cost_ms;
+    } else {
+        output->render_cost_ms += ((double)cost_ms - output->render_cost_ms) * 0.1;
+    }
+
+    if (now - output->render_scale_time < RENDER_SCALE_ADJUST_MS) {
+        return;
+    }
+
+    double budget_ms = output_frame_interval_ms(output);
+    double period_ms = output_refresh_period_ms(output);
+    if (budget_ms < period_ms) {
+        budget_ms = period_ms;
+    }
+
+    float scale = output->render_scale;
+    float target = scale;
+    if (output->render_cost_ms > budget_ms * RENDER_SCALE_HIGH_LOAD) {
+        target = scale - RENDER_SCALE_STEP;
+    } else {
+        /* Cost follows the pixel count, i.e. the square of the scale */
+        double growth = (double)(scale + RENDER_SCALE_STEP) / (double)scale;
+        if (output->render_cost_ms * growth * growth < budget_ms * RENDER_SCALE_LOW_LOAD) {
+            target = scale + RENDER_SCALE_STEP;
+        }
+    }
+
+    if (target < config->render_scale_min) {
+        target = config->render_scale_min;
+    } else if (target > config->render_scale) {
+        target = config->render_scale;
+    }
+
+    if (fabsf(target - scale) < 0.001f) {
         return;
     }
 
+    log_debug("Render scale [%s]: %.2f -> %.2f (cost %.1fms, budget %.1fms)",
+              output->model, (double)scale, (double)target,
+              output->render_cost_ms, budget_ms);
+
+    output->render_scale_time = now;
+    output->render_cost_ms = 0.0;
+    output_set_render_scale(output, target);
+}
+
+/* Recompute an output's deadlines (absolute get_time_ms() values, 0 = none) */
+static void output_update_deadlines(struct neowall_state *state, struct output_state *output,
+                                    uint64_t now) {
+    /* Frame deadline: animation or pending redraw (or a static watermark refresh).
+     * Without a surface there is nothing to draw into; its configure wakes the loop. */
+    if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) {
+        output->frame_deadline = 0;
+    } else if (!event_loop_output_animating(output) && !output->needs_redraw) {
+        output->frame_deadline = output_watermark_deadline(output);
+    } else if (output->frame_callback) {
+        /* The callback itself arrives on the Wayland fd; this is only the lost-callback fallback */
+        output->frame_deadline = output->frame_request_time + FRAME_CALLBACK_TIMEOUT_MS;
+    } else {
+        double interval_ms = output_frame_interval_ms(output);
+        if (interval_ms > 0.0 && output->last_frame_time > 0) {
+            double slack_ms = output_refresh_period_ms(output) / 2.0;
+            output->frame_deadline = output->last_frame_time + (uint64_t)(interval_ms - slack_ms);
+        } else {
+            output->frame_deadline = now;
+        }
+        if (output->render_retry_time > output->frame_deadline) {
+            output->frame_deadline = output->render_retry_time;
+        }
+    }
+
+    /* Cycle deadline: same conditions as output_should_cycle() */
+    bool paused = atomic_load_explicit(&state->paused, memory_order_acquire);
+    bool can_cycle = !paused && output->config->cycle && output->config->duration > 0.0f &&
+                     output->config->cycle_count > 1 &&
+                     (output->config->type == WALLPAPER_SHADER ? output->live_shader_program != 0 :
+                                                                  output->current_image != NULL);
+    if (can_cycle) {
+        uint64_t duration_ms = (uint64_t)(output->config->duration * 1000.0f);  /* Convert seconds to milliseconds */
+        output->cycle_deadline = output->last_cycle_time + duration_ms;
+    } else {
+        output->cycle_deadline = 0;
+    }
+}
+
+/* Earliest deadline of an output, or 0 if it has none */
+static uint64_t output_next_deadline(struct output_state *output) {
+    uint64_t next = output->frame_deadline;
+    if (output->cycle_deadline && (next == 0 || output->cycle_deadline < next)) {
+        next = output->cycle_deadline;
+    }
+    if (atomic_load(&output->preload_upload_pending)) {
+        /* Preload completion: upload as soon as possible, streamed bands once per frame */
+        uint64_t upload_at = output->preload_stream ? output->preload_stream_next : 1;
+        if (next == 0 || upload_at < next) {
+            next = upload_at;
+        }
+    }
+    if (output_shader_swap_ready(output)) {
+        next = 1;  /* Background compile done: start the cross-fade */
+    }
+    return next;
+}
+
+/* Refresh per-output deadlines and arm timerfd for the earliest one.
+ * Outputs on their own render thread schedule themselves and are skipped.
+ * Returns the number of outputs with an active shader animation */
+static int arm_deadline_timer(struct neowall_state *state) {
+    if (!state || state->timer_fd < 0) {
+        return 0;
+    }
+
     uint64_t now = get_time_ms();
-    uint64_t next_wake_ms = UINT64_MAX;
-    
-    /* Find the earliest cycle time across all outputs - use read lock */
+    uint64_t next_deadline = 0;
+    struct output_state *next_output = NULL;
+    int shader_count = 0;
+
     pthread_rwlock_rdlock(&state->output_list_lock);
-    
-    bool paused = atomic_load_explicit(&state->paused, memory_order_acquire);
+
     struct output_state *output = state->outputs;
     while (output) {
-        if (!paused && output->config->cycle && output->config->duration > 0.0f &&
-            output->config->cycle_count > 1 && output->current_image) {
-            uint64_t elapsed_ms = now - output->last_cycle_time;
-            uint64_t duration_ms = (uint64_t)(output->config->duration * 1000.0f);  /* Convert seconds to milliseconds */
-            
-            if (elapsed_ms >= duration_ms) {
-                /* Should cycle now */
-                next_wake_ms = 0;
-                break;
-            } else {
-                uint64_t time_until_cycle = duration_ms - elapsed_ms;
-                if (time_until_cycle < next_wake_ms) {
-                    next_wake_ms = time_until_cycle;
-                }
+        if (!output->render_thread) {
+            output_update_deadlines(state, output, now);
+            uint64_t deadline = output_next_deadline(output);
+            if (deadline && (next_deadline == 0 || deadline < next_deadline)) {
+                next_deadline = deadline;
+                next_output = output;
+            }
+            if (output->config->type == WALLPAPER_SHADER && event_loop_output_animating(output)) {
+                shader_count++;
             }
         }
         output = output->next;
     }
-    
+
     pthread_rwlock_unlock(&state->output_list_lock);
-    
-    /* Set the timer */
+
+    /* Absolute CLOCK_MONOTONIC timer, same clock as get_time_ms();
+     * a zero it_value disarms, so due/overdue deadlines fire at now */
     struct itimerspec timer_spec;
     memset(&timer_spec, 0, sizeof(timer_spec));
-    
-    if (next_wake_ms == UINT64_MAX) {
-        /* No cycling needed, disarm timer */
-        timer_spec.it_value.tv_sec = 0;
-        timer_spec.it_value.tv_nsec = 0;
-    } else {
-        /* Set timer to wake at next cycle time */
-        timer_spec.it_value.tv_sec = next_wake_ms / MS_PER_SECOND;
-        timer_spec.it_value.tv_nsec = (next_wake_ms % MS_PER_SECOND) * NS_PER_MS;
+
+    if (next_deadline != 0) {
+        uint64_t wake_ms = next_deadline > now ? next_deadline : now;
+        timer_spec.it_value.tv_sec = wake_ms / MS_PER_SECOND;
+        timer_spec.it_value.tv_nsec = (wake_ms % MS_PER_SECOND) * NS_PER_MS;
     }
-    
-    timer_spec.it_interval.tv_sec = 0;
-    timer_spec.it_interval.tv_nsec = 0;
-    
-    if (timerfd_settime(state->timer_fd, 0, &timer_spec, NULL) < 0) {
+
+    if (timerfd_settime(state->timer_fd, TFD_TIMER_ABSTIME, &timer_spec, NULL) < 0) {
         log_error("Failed to set timerfd: %s", strerror(errno));
-    } else if (next_wake_ms != UINT64_MAX) {
-        log_debug("Cycle timer set to wake in %lums", next_wake_ms);
+    } else if (next_output && next_deadline > now + FRAME_CALLBACK_TIMEOUT_MS) {
+        /* Only log long waits (cycles), not per-frame deadlines */
+        log_debug("Next deadline: output %s in %lums", next_output->model, next_deadline - now);
+    }
+
+    return shader_count;
+}
+
+/* wl_surface.frame callback - compositor is ready for this output's next frame */
+static void frame_callback_done(void *data, struct wl_callback *callback, uint32_t time) {
+    (void)time;
+    struct output_state *output = data;
+
+    wl_callback_destroy(callback);
+    if (output->frame_callback == callback) {
+        output->frame_callback = NULL;
+    }
+}
+
+static const struct wl_callback_listener frame_callback_listener = {
+    .done = frame_callback_done,
+};
+
+/* Request a frame callback before the swap commits, so at most one frame
+ * per surface is ever in flight. frame_surface may be a queue-bound wrapper
+ * of the output's wl_surface (render threads) */
+static void request_frame_callback(struct output_state *output, struct wl_surface *frame_surface,
+                                   uint64_t now) {
+    struct wl_callback *callback = wl_surface_frame(frame_surface);
+    if (!callback) {
+        return;
+    }
+    wl_callback_add_listener(callback, &frame_callback_listener, output);
+    output->frame_callback = callback;
+    output->frame_request_time = now;
+}
+
+/* Check if an output may render now: no frame in flight and shader_fps cap respected */
+bool event_loop_output_frame_due(struct output_state *output, uint64_t now) {
+    if (now < output->render_retry_time) {
+        return false;
+    }
+
+    if (output->frame_callback) {
+        if (now - output->frame_request_time < FRAME_CALLBACK_TIMEOUT_MS) {
+            return false;
+        }
+        /* Compositor never answered (surface hidden or callback lost) - re-arm */
+        log_debug("Frame callback for output %s timed out after %lums",
+                  output->model, now - output->frame_request_time);
+        wl_callback_destroy(output->frame_callback);
+        output->frame_callback = NULL;
     }
+
+    /* Half a refresh period of slack: a frame callback landing a hair early
+     * must not push the frame to the next vblank */
+    double interval_ms = output_frame_interval_ms(output);
+    if (interval_ms > 0.0 && output->last_frame_time > 0 &&
+        (double)(now - output->last_frame_time) + output_refresh_period_ms(output) / 2.0 < interval_ms) {
+        return false;
+    }
+
+    return true;
+}
+
+/* Refresh one output's deadlines and return the earliest (absolute ms, 0 = none).
+ * Used by render threads, which schedule their own output */
+uint64_t event_loop_output_next_deadline(struct neowall_state *state, struct output_state *output,
+                                         uint64_t now) {
+    output_update_deadlines(state, output, now);
+    return output_next_deadline(output);
 }
 
 /* Render all outputs that need redrawing */
@@ -84,9 +343,305 @@ static void update_cycle_timer(struct neowall_state *state) {
 struct swap_info {
     struct output_state *output;
     bool render_success;
+    uint64_t frame_time;
     struct swap_info *next;
 };
 
+/* Per-frame upload budget of an output in bytes */
+static size_t output_upload_budget(struct output_state *output) {
+    int budget_mb = output->config->upload_budget_mb > 0 ? output->config->upload_budget_mb
+                                                          : DEFAULT_UPLOAD_BUDGET_MB;
+    return (size_t)budget_mb * 1024 * 1024;
+}
+
+/* Upload a preload the decode pool finished. Caller holds
+ * output_list_lock (read); the output's context is made current here.
+ * On ES 3.0 the image streams in bands across frames within the output's
+ * upload budget; preload_upload_pending stays set until the last band.
+ * Returns true if a new preload texture became ready */
+bool event_loop_upload_preload(struct neowall_state *state, struct output_state *output) {
+    bool uploaded = false;
+    GLuint created_texture = 0;     /* Uploaded here, to be shared after unlocking */
+    struct image_data created_image;
+
+    /* iChannel0 image of a shader + image cycle (small, uploaded in one go) */
+    output_upload_channel_image(output);
+
+    /* Check if a background decode finished - upload to GPU now */
+    if (atomic_load(&output->preload_upload_pending)) {
+        pthread_mutex_lock(&output->preload_mutex);
+
+        /* One step of a stream per frame unless a newer preload arrived */
+        if (output->preload_stream && !output->preload_decoded_image &&
+            get_time_ms() < output->preload_stream_next) {
+            pthread_mutex_unlock(&output->preload_mutex);
+            return false;
+        }
+        
+        if (output->preload_decoded_image || output->preload_stream) {
+            /* Ensure EGL context is current for this output */
+            if (output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
+                if (!eglMakeCurrent(state->egl_display, output->compositor_surface->egl_surface,
+                                   output->compositor_surface->egl_surface, render_thread_context_for(output))) {
+                    log_error("Failed to make EGL context current for preload upload");
+                } else {
+                    /* Adopt the upload thread's texture (already complete on the GPU),
+                     * otherwise upload the decoded image here */
+                    GLuint new_texture = output->preload_decoded_texture;
+                    struct image_data *new_image = NULL;
+                    output->preload_decoded_texture = 0;
+                    if (new_texture != 0) {
+                        new_image = output->preload_decoded_image;
+                        output->preload_decoded_image = NULL;
+                    } else if (output->preload_decoded_image && !output->preload_decoded_image->pixels &&
+                               !output->preload_decoded_image->compressed) {
+                        /* Another output decoded it: share that texture */
+                        if (output->preload_stream) {
+                            texture_stream_abort(output->preload_stream);
+                            output->preload_stream = NULL;
+                        }
+                        new_image = output->preload_decoded_image;
+                        output->preload_decoded_image = NULL;
+                        new_texture = texture_cache_acquire(new_image->path, new_image->display_width,
+                                                            new_image->display_height,
+                                                            new_image->display_mode, NULL);
+                    } else {
+                        /* A newer preload supersedes a stream still in progress */
+                        if (output->preload_decoded_image && output->preload_stream) {
+                            texture_stream_abort(output->preload_stream);
+                            output->preload_stream = NULL;
+                        }
+                        if (output->preload_decoded_image) {
+                            output->preload_stream = texture_stream_begin(output->preload_decoded_image);
+                            if (output->preload_stream) {
+                                output->preload_decoded_image = NULL;  /* Owned by the stream */
+                            } else {
+                                new_image = output->preload_decoded_image;
+                                output->preload_decoded_image = NULL;
+                                new_texture = render_create_texture(new_image);
+                                created_texture = new_texture;
+                            }
+                        }
+                        if (output->preload_stream) {
+                            if (!texture_stream_step(output->preload_stream, output_upload_budget(output),
+                                                     TEXTURE_UPLOAD_BUDGET_MS)) {
+                                /* More bands next frame */
+                                output->preload_stream_next = get_time_ms() +
+                                                              (uint64_t)output_refresh_period_ms(output);
+                                output->gl_state.bound_texture = 0;
+                                pthread_mutex_unlock(&output->preload_mutex);
+                                return false;
+                            }
+                            new_texture = texture_stream_finish(output->preload_stream, &new_image);
+                            output->preload_stream = NULL;
+                            created_texture = new_texture;
+                        }
+                    }
+                    if (new_texture != 0) {
+                        /* CRITICAL: Invalidate GL state cache after texture creation
+                         * render_create_texture unbinds the texture (binds 0), which
+                         * invalidates our cached state. Reset to force proper rebinding. */
+                        output->gl_state.bound_texture = 0;
+                        
+                        /* Clean up old preload texture if exists */
+                        if (output->preload_texture) {
+                            render_destroy_texture(output->preload_texture);
+                        }
+                        if (output->preload_image) {
+                            image_free(output->preload_image);
+                        }
+                        
+                        /* Store uploaded texture */
+                        output->preload_texture = new_texture;
+                        output->preload_image = new_image; /* Ownership transferred */
+                        if (created_texture) {
+                            created_image = *new_image;
+                        }
+                        atomic_store(&output->preload_ready, true);
+                        uploaded = true;
+                        
+                        log_info("GPU upload complete: %s (texture=%u) - ZERO-STALL ready!",
+                                 output->preload_path, new_texture);
+                    } else {
+                        log_error("Failed to create preload texture from decoded image");
+                        created_texture = 0;
+                        if (new_image) {
+                            image_free(new_image);
+                        }
+                    }
+                }
+            }
+        }
+        
+        /* An iChannel0 image published meanwhile keeps the flag for the next pass */
+        atomic_store(&output->preload_upload_pending, atomic_load(&output->channel_upload_pending));
+        pthread_mutex_unlock(&output->preload_mutex);
+    }
+
+    /* Outputs of the same size waiting on this image take it from here */
+    if (created_texture) {
+        texture_cache_insert(created_texture, &created_image);
+    }
+    
+    return uploaded;
+}
+
+/* Render one output's frame: transition progress, draw and FPS accounting.
+ * Caller holds output_list_lock (read) and has made the output's context
+ * current; presentation happens in event_loop_present_output() */
+bool event_loop_render_output(struct neowall_state *state, struct output_state *output) {
+    /* Recalculate time for accurate transition timing */
+    uint64_t current_time = get_time_ms();
+
+    /* Handle image transitions */
+    if (output->transition_start_time > 0 &&
+        output->config->transition != TRANSITION_NONE) {
+        uint64_t elapsed = current_time - output->transition_start_time;
+        uint64_t transition_duration_ms = (uint64_t)(output->config->transition_duration * 1000.0f);
+        float progress = (float)elapsed / (float)transition_duration_ms;
+
+        if (progress >= 1.0f) {
+            /* Clamp progress to 1.0 for final frame */
+            output->transition_progress = 1.0f;
+        } else {
+            /* Apply easing function */
+            output->transition_progress = ease_in_out_cubic(progress);
+        }
+    }
+
+    /* Render frame */
+    uint64_t frame_start = get_time_ms();
+    uint64_t cpu_start = thread_cpu_time_ns();
+    bool render_success = render_frame(output);
+    uint64_t cpu_ns = thread_cpu_time_ns() - cpu_start;
+    uint64_t frame_end = get_time_ms();
+    output->frame_render_ms = frame_end - frame_start;
+    
+    /* FPS measurement for shaders */
+    if (render_success && output->config->type == WALLPAPER_SHADER) {
+        output->fps_frame_count++;
+        output->fps_cpu_ns += cpu_ns;
+        
+        if (output->fps_last_log_time == 0) {
+            output->fps_last_log_time = frame_end;
+        }
+        
+        uint64_t elapsed = frame_end - output->fps_last_log_time;
+        if (elapsed >= FPS_WINDOW_MS) {  /* Log every 2 seconds */
+            float actual_fps = (float)output->fps_frame_count / ((float)elapsed / 1000.0f);
+            output->fps_current = actual_fps;
+            uint64_t frame_time = frame_end - frame_start;
+            int target_fps = output->config->shader_fps > 0 ? output->config->shader_fps : 60;
+            
+            /* CPU per frame is the figure to compare with and without --gl-debug */
+            double cpu_ms = (double)output->fps_cpu_ns / 1e6 / (double)output->fps_frame_count;
+            
+            log_info("FPS [%s]: %.1f FPS (target: %d, frame_time: %lums, cpu: %.2fms/frame)", 
+                     output->model, actual_fps, target_fps, frame_time, cpu_ms);
+            
+            output->fps_frame_count = 0;
+            output->fps_cpu_ns = 0;
+            output->fps_last_log_time = frame_end;
+        }
+    }
+    
+    if (!render_success) {
+        /* Only log if shader hasn't permanently failed (after 3 attempts, be silent) */
+        if (!output->shader_load_failed) {
+            /* Throttle error logging to prevent spam when shader fails to load */
+            static uint64_t last_render_error_time = 0;
+            static int render_error_count = 0;
+            current_time = get_time_ms();
+            
+            if (current_time - last_render_error_time >= 1000) {
+                /* Log once per second */
+                if (render_error_count > 0) {
+                    log_error("Failed to render frame for output %s (%d failures in last second)", 
+                             output->model, render_error_count + 1);
+                } else {
+                    log_error("Failed to render frame for output %s", output->model);
+                }
+                last_render_error_time = current_time;
+                render_error_count = 0;
+            } else {
+                render_error_count++;
+            }
+        }
+        state->errors_count++;
+        /* Back off before retrying so a broken frame doesn't spin the scheduler */
+        output->render_retry_time = get_time_ms() + MS_PER_SECOND;
+    }
+    
+    return render_success;
+}
+
+/* Present a rendered frame: request the next frame callback, swap and commit, then
+ * finish completed transitions. Must be called without locks held (swap may block) */
+void event_loop_present_output(struct neowall_state *state, struct output_state *output,
+                               uint64_t frame_time, struct wl_surface *frame_surface) {
+    /* Frame callback must be requested before the swap commits the buffer */
+    request_frame_callback(output, frame_surface, frame_time);
+    
+    /* Swap buffers - swap interval is 0, pacing comes from the frame callback.
+     * The swap commits the surface with only this frame's damage (bottom-left origin) */
+    struct damage_rect *damage = &output->frame_damage;
+    EGLint damage_rect[4] = {
+        damage->x, output->height - damage->y - damage->height, damage->width, damage->height
+    };
+    EGLint damage_count = (damage->width > 0 && damage->height > 0) ? 1 : 0;
+    uint64_t swap_start = get_time_ms();
+    if (!egl_core_swap_buffers_with_damage(state, output, damage_rect, damage_count)) {
+        log_error("Failed to swap buffers for output %s: 0x%x",
+                 output->model, eglGetError());
+        state->errors_count++;
+        /* Nothing was committed, don't wait for a callback that won't come */
+        if (output->frame_callback) {
+            wl_callback_destroy(output->frame_callback);
+            output->frame_callback = NULL;
+        }
+    } else {
+        /* Remember what each presented buffer was missing, for EGL_EXT_buffer_age */
+        memmove(&output->damage_history[1], &output->damage_history[0],
+                sizeof(output->damage_history) - sizeof(output->damage_history[0]));
+        output->damage_history[0] = output->frame_damage;
+
+        output->last_frame_time = frame_time;
+        state->frames_rendered++;
+
+        uint64_t swap_end = get_time_ms();
+        output_adapt_render_scale(output, output->frame_render_ms + (swap_end - swap_start),
+                                  swap_end);
+        
+        /* Clean up transition after final frame is rendered */
+        if (output->transition_start_time > 0 && 
+            output->transition_progress >= 1.0f) {
+            output->transition_start_time = 0;
+            
+            /* Clean up old texture */
+            if (output->next_texture) {
+                render_destroy_texture(output->next_texture);
+                output->next_texture = 0;
+            }
+            
+            if (output->next_image) {
+                image_free(output->next_image);
+                output->next_image = NULL;
+            }
+            
+            /* Preload next wallpaper after transition completes */
+            if (output->config->cycle && output->config->cycle_count > 1 && 
+                output->config->type == WALLPAPER_IMAGE) {
+                output_preload_next_wallpaper(output);
+            }
+        }
+        
+        /* Reset needs_redraw unless still animating (transition or time-driven shader) */
+        if (!event_loop_output_animating(output)) {
+            output->needs_redraw = false;
+        }
+    }
+}
+
 static void render_outputs(struct neowall_state *state) {
     if (!state) {
         return;
@@ -157,7 +712,12 @@ static void render_outputs(struct neowall_state *state) {
                 if (same_config) {
                     log_debug("Cycling to next wallpaper for output %s (synchronized)",
                              sync_output->model[0] ? sync_output->model : "unknown");
-                    output_cycle_wallpaper(sync_output);
+                    if (sync_output->render_thread) {
+                        /* GL work for threaded outputs stays on their own render thread */
+                        render_thread_request_cycle(sync_output);
+                    } else {
+                        output_cycle_wallpaper(sync_output);
+                    }
                     cycled_count++;
                 }
                 
@@ -174,147 +734,42 @@ static void render_outputs(struct neowall_state *state) {
             atomic_fetch_sub_explicit(&state->next_requested, 1, memory_order_acq_rel);
         }
         
+        /* Outputs with a dedicated render thread cycle, render and present on it */
+        if (output->render_thread) {
+            output = output->next;
+            continue;
+        }
+        
         /* Check if we should cycle wallpaper (timer-driven) */
         if (!state->paused && output->config->cycle && output->config->duration > 0.0f) {
             if (output_should_cycle(output, current_time)) {
                 output_cycle_wallpaper(output);
                 current_time = get_time_ms();
-                /* Update timer for next cycle */
-                update_cycle_timer(state);
             }
         }
 
-        /* Check if this output needs rendering */
-        if (output->needs_redraw && output->compositor_surface &&
-            output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
+        /* Preload completion deadline - upload now so the next cycle is zero-stall */
+        if (atomic_load(&output->preload_upload_pending)) {
+            event_loop_upload_preload(state, output);
+        }
+
+        /* Check if this output needs rendering (and the compositor is ready for a frame) */
+        if (event_loop_output_needs_frame(output, get_time_ms()) && output->compositor_surface &&
+            output->compositor_surface->egl_surface != EGL_NO_SURFACE &&
+            event_loop_output_frame_due(output, get_time_ms())) {
             /* Make EGL context current for this output */
             if (!eglMakeCurrent(state->egl_display, output->compositor_surface->egl_surface,
                                output->compositor_surface->egl_surface, state->egl_context)) {
                 log_error("Failed to make EGL context current for output %s: 0x%x",
                          output->model, eglGetError());
+                /* Same backoff as a failed frame, or the deadline timer fires right away again */
+                output->render_retry_time = get_time_ms() + MS_PER_SECOND;
                 output = output->next;
                 continue;
             }
 
-            /* Recalculate time for accurate transition timing */
-            current_time = get_time_ms();
-
-            /* Check if background thread finished decoding - upload to GPU now */
-            if (atomic_load(&output->preload_upload_pending)) {
-                pthread_mutex_lock(&output->preload_mutex);
-                
-                if (output->preload_decoded_image) {
-                    /* Ensure EGL context is current for this output */
-                    if (output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
-                        if (!eglMakeCurrent(state->egl_display, output->compositor_surface->egl_surface,
-                                           output->compositor_surface->egl_surface, state->egl_context)) {
-                            log_error("Failed to make EGL context current for preload upload");
-                        } else {
-                            /* Upload decoded image to GPU (fast - just texture creation) */
-                            GLuint new_texture = render_create_texture(output->preload_decoded_image);
-                            if (new_texture != 0) {
-                                /* CRITICAL: Invalidate GL state cache after texture creation
-                                 * render_create_texture unbinds the texture (binds 0), which
-                                 * invalidates our cached state. Reset to force proper rebinding. */
-                                output->gl_state.bound_texture = 0;
-                                
-                                /* Clean up old preload texture if exists */
-                                if (output->preload_texture) {
-                                    render_destroy_texture(output->preload_texture);
-                                }
-                                if (output->preload_image) {
-                                    image_free(output->preload_image);
-                                }
-                                
-                                /* Store uploaded texture */
-                                output->preload_texture = new_texture;
-                                output->preload_image = output->preload_decoded_image;
-                                output->preload_decoded_image = NULL; /* Ownership transferred */
-                                atomic_store(&output->preload_ready, true);
-                                
-                                log_info("GPU upload complete: %s (texture=%u) - ZERO-STALL ready!",
-                                         output->preload_path, new_texture);
-                            } else {
-                                log_error("Failed to create preload texture from decoded image");
-                                image_free(output->preload_decoded_image);
-                                output->preload_decoded_image = NULL;
-                            }
-                        }
-                    }
-                }
-                
-                atomic_store(&output->preload_upload_pending, false);
-                pthread_mutex_unlock(&output->preload_mutex);
-            }
-            
-            /* Handle image transitions */
-            if (output->transition_start_time > 0 &&
-                output->config->transition != TRANSITION_NONE) {
-                uint64_t elapsed = current_time - output->transition_start_time;
-                uint64_t transition_duration_ms = (uint64_t)(output->config->transition_duration * 1000.0f);
-                float progress = (float)elapsed / (float)transition_duration_ms;
-
-                if (progress >= 1.0f) {
-                    /* Clamp progress to 1.0 for final frame */
-                    output->transition_progress = 1.0f;
-                } else {
-                    /* Apply easing function */
-                    output->transition_progress = ease_in_out_cubic(progress);
-                }
-            }
-
-            /* Render frame */
             uint64_t frame_start = get_time_ms();
-            bool render_success = render_frame(output);
-            uint64_t frame_end = get_time_ms();
-            
-            /* FPS measurement for shaders */
-            if (render_success && output->config->type == WALLPAPER_SHADER) {
-                output->fps_frame_count++;
-                
-                if (output->fps_last_log_time == 0) {
-                    output->fps_last_log_time = frame_end;
-                }
-                
-                uint64_t elapsed = frame_end - output->fps_last_log_time;
-                if (elapsed >= 2000) {  /* Log every 2 seconds */
-                    float actual_fps = (float)output->fps_frame_count / ((float)elapsed / 1000.0f);
-                    output->fps_current = actual_fps;
-                    uint64_t frame_time = frame_end - frame_start;
-                    int target_fps = output->config->shader_fps > 0 ? output->config->shader_fps : 60;
-                    
-                    log_info("FPS [%s]: %.1f FPS (target: %d, frame_time: %lums)", 
-                             output->model, actual_fps, target_fps, frame_time);
-                    
-                    output->fps_frame_count = 0;
-                    output->fps_last_log_time = frame_end;
-                }
-            }
-            
-            if (!render_success) {
-                /* Only log if shader hasn't permanently failed (after 3 attempts, be silent) */
-                if (!output->shader_load_failed) {
-                    /* Throttle error logging to prevent spam when shader fails to load */
-                    static uint64_t last_render_error_time = 0;
-                    static int render_error_count = 0;
-                    uint64_t current_time = get_time_ms();
-                    
-                    if (current_time - last_render_error_time >= 1000) {
-                        /* Log once per second */
-                        if (render_error_count > 0) {
-                            log_error("Failed to render frame for output %s (%d failures in last second)", 
-                                     output->model, render_error_count + 1);
-                        } else {
-                            log_error("Failed to render frame for output %s", output->model);
-                        }
-                        last_render_error_time = current_time;
-                        render_error_count = 0;
-                    } else {
-                        render_error_count++;
-                    }
-                }
-                state->errors_count++;
-            }
+            bool render_success = event_loop_render_output(state, output);
             
             /* BUG FIX #10: Add output to swap list to defer eglSwapBuffers until after lock release
              * This prevents deadlock where render thread holds read lock while blocking in
@@ -323,6 +778,7 @@ static void render_outputs(struct neowall_state *state) {
             if (info) {
                 info->output = output;
                 info->render_success = render_success;
+                info->frame_time = frame_start;
                 info->next = NULL;
                 
                 if (swap_tail) {
@@ -359,50 +815,8 @@ static void render_outputs(struct neowall_state *state) {
                 continue;
             }
             
-            /* Swap buffers - this can BLOCK waiting for vsync, so no locks must be held */
-            if (!eglSwapBuffers(state->egl_display, output->compositor_surface->egl_surface)) {
-                log_error("Failed to swap buffers for output %s: 0x%x",
-                         output->model, eglGetError());
-                state->errors_count++;
-            } else {
-                /* Damage the entire surface to tell compositor it needs repainting */
-                wl_surface_damage(output->compositor_surface->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
-                
-                /* Commit Wayland surface */
-                wl_surface_commit(output->compositor_surface->wl_surface);
-                output->last_frame_time = current_time;
-                state->frames_rendered++;
-                
-                /* Clean up transition after final frame is rendered */
-                if (output->transition_start_time > 0 && 
-                    output->transition_progress >= 1.0f) {
-                    output->transition_start_time = 0;
-                    
-                    /* Clean up old texture */
-                    if (output->next_texture) {
-                        render_destroy_texture(output->next_texture);
-                        output->next_texture = 0;
-                    }
-                    
-                    if (output->next_image) {
-                        image_free(output->next_image);
-                        output->next_image = NULL;
-                    }
-                    
-                    /* Preload next wallpaper after transition completes */
-                    if (output->config->cycle && output->config->cycle_count > 1 && 
-                        output->config->type == WALLPAPER_IMAGE) {
-                        output_preload_next_wallpaper(output);
-                    }
-                }
-                
-                /* Reset needs_redraw unless we're in a transition or using a shader wallpaper */
-                if ((output->transition_start_time == 0 || 
-                     output->config->transition == TRANSITION_NONE) &&
-                    output->config->type != WALLPAPER_SHADER) {
-                    output->needs_redraw = false;
-                }
-            }
+            event_loop_present_output(state, output, swap->frame_time,
+                                      output->compositor_surface->wl_surface);
         }
         
         /* Free this swap info node and move to next */
@@ -432,8 +846,8 @@ static void render_outputs(struct neowall_state *state) {
         atomic_fetch_sub(&state->next_requested, 1);
     }
     
-    /* Update timer after rendering changes */
-    update_cycle_timer(state);
+    /* Re-arm for the earliest deadline after rendering changes */
+    arm_deadline_timer(state);
 }
 
 /* Handle pending Wayland events */
@@ -553,8 +967,13 @@ void event_loop_run(struct neowall_state *state) {
     handle_wayland_events(state);
     wl_display_flush(state->display);
     
-    /* Set initial timer for cycling */
-    update_cycle_timer(state);
+    /* Set initial deadline timer */
+    arm_deadline_timer(state);
+
+    /* Hand outputs over to their own render threads (--threaded-render) */
+    if (state->threaded_render) {
+        render_threads_start(state);
+    }
 
     log_info("Entering main event loop");
     
@@ -600,42 +1019,14 @@ void event_loop_run(struct neowall_state *state) {
          * (Ctrl+C, neowall kill, etc.) because poll wouldn't return until a Wayland event arrived */
         int timeout_ms = 1000; /* 1 second max - ensures signals checked regularly */
         
-        /* Check if any output has active transitions or shader wallpapers - use read lock */
-        pthread_rwlock_rdlock(&state->output_list_lock);
-        output = state->outputs;
-        int shader_count = 0;
-        while (output) {
-            /* Only count shader as active if it loaded successfully and hasn't failed */
-            if (output->config->type == WALLPAPER_SHADER && 
-                !output->shader_load_failed && 
-                output->live_shader_program != 0) {
-                shader_count++;
-                /* Use configured shader_fps or default to FRAME_TIME_MS */
-                int target_fps = output->config->shader_fps > 0 ? output->config->shader_fps : FPS_TARGET;
-                timeout_ms = 1000 / target_fps;
-                /* Only log shader detection once, not every frame */
-                if (!shader_mode_logged) {
-                    log_info("Shader active on %s, rendering at %d FPS (shader_fps=%d, timeout_ms=%d)", 
-                             output->model, target_fps, output->config->shader_fps, timeout_ms);
-                    shader_mode_logged = true;
-                }
-            }
-            if ((output->transition_start_time > 0 && 
-                 output->config->transition != TRANSITION_NONE) ||
-                (output->config->type == WALLPAPER_SHADER && 
-                 !output->shader_load_failed && 
-                 output->live_shader_program != 0)) {
-                /* Use configured shader_fps for shaders, otherwise use default FRAME_TIME_MS */
-                if (output->config->type == WALLPAPER_SHADER && output->config->shader_fps > 0) {
-                    timeout_ms = 1000 / output->config->shader_fps;
-                } else {
-                    timeout_ms = FRAME_TIME_MS;
-                }
-                break;
-            }
-            output = output->next;
+        /* Per-output deadlines (frames, cycles, preload completions) are armed on
+         * timerfd; frame callbacks arrive on the Wayland fd. The poll timeout is only
+         * a fallback so signals are checked regularly */
+        int shader_count = arm_deadline_timer(state);
+        if (shader_count > 0 && !shader_mode_logged) {
+            log_info("Shader animation active on %d output(s), frame-callback paced", shader_count);
+            shader_mode_logged = true;
         }
-        pthread_rwlock_unlock(&state->output_list_lock);
         
         if (shader_count == 0 && shader_mode_logged) {
             log_info("No active shaders, reverting to event-driven mode");
@@ -697,12 +1088,12 @@ void event_loop_run(struct neowall_state *state) {
                 wl_display_cancel_read(state->display);
             }
             
-            /* Check timerfd - time to cycle wallpaper */
+            /* Check timerfd - an output deadline is due */
             if (fds[1].revents & POLLIN) {
                 uint64_t expirations;
                 ssize_t s = read(state->timer_fd, &expirations, sizeof(expirations));
                 if (s == sizeof(expirations)) {
-                    log_debug("Cycle timer expired (%lu expirations), checking outputs", expirations);
+                    log_debug("Deadline timer expired (%lu expirations), checking outputs", expirations);
                 }
             }
             
@@ -737,8 +1128,13 @@ void event_loop_run(struct neowall_state *state) {
              * - Backup and rollback on failure
              * - Thread-safe operations
              * - Prevents race conditions with file watcher
+             * Render threads are parked first so reload owns all GL resources.
              */
+            render_threads_stop(state);
             config_reload(state);
+            if (state->threaded_render) {
+                render_threads_start(state);
+            }
         }
 
         /* Dispatch any events that were read */
@@ -766,26 +1162,33 @@ void event_loop_run(struct neowall_state *state) {
             double elapsed_sec = (current_time - last_stats_time) / (double)MS_PER_SECOND;
             double fps = frame_count / elapsed_sec;
 
-            log_debug("Stats: %.1f FPS, %lu frames rendered, %lu errors",
-                     fps, state->frames_rendered, state->errors_count);
+            unsigned long cache_hits, cache_misses, image_hits, image_misses, etc2_textures;
+            unsigned long live_textures, shared_textures, lookahead_hits;
+            uint64_t etc2_bytes, rgba_bytes;
+            shader_disk_cache_get_stats(&cache_hits, &cache_misses);
+            image_disk_cache_get_stats(&image_hits, &image_misses);
+            texture_compress_get_stats(&etc2_textures, &etc2_bytes, &rgba_bytes);
+            texture_cache_get_stats(&live_textures, &shared_textures);
+            lookahead_get_stats(&lookahead_hits);
+
+            log_debug("Stats: %.1f FPS, %lu frames rendered, %lu errors, shader cache %lu hits / %lu misses, "
+                     "wallpaper cache %lu hits / %lu misses, %lu wallpaper textures (%lu shared), "
+                     "ETC2 %lu textures in VRAM (%lu MB, %lu MB saved), %lu lookahead hits",
+                     fps, state->frames_rendered, state->errors_count, cache_hits, cache_misses,
+                     image_hits, image_misses, live_textures, shared_textures, etc2_textures,
+                     (unsigned long)(etc2_bytes / (1024 * 1024)),
+                     (unsigned long)((rgba_bytes - etc2_bytes) / (1024 * 1024)), lookahead_hits);
 
             last_stats_time = current_time;
             frame_count = 0;
         }
 
-        /* Keep redrawing during active transitions and for shader wallpapers */
+        /* Keep redrawing during active transitions and for shader wallpapers
+         * (continuous animation, only if shader loaded successfully and hasn't failed).
+         * Actual frame rate is gated by output_frame_due() in render_outputs */
         output = state->outputs;
         while (output) {
-            /* Keep redrawing during transitions */
-            if (output->transition_start_time > 0 && 
-                output->config->transition != TRANSITION_NONE) {
-                output->needs_redraw = true;
-            }
-            /* Keep redrawing for shader wallpapers (continuous animation) 
-             * but only if shader loaded successfully and hasn't failed */
-            if (output->config->type == WALLPAPER_SHADER && 
-                !output->shader_load_failed && 
-                output->live_shader_program != 0) {
+            if (event_loop_output_animating(output)) {
                 output->needs_redraw = true;
             }
             output = output->next;
@@ -794,11 +1197,14 @@ void event_loop_run(struct neowall_state *state) {
         /* Throttle debug logging - only every 300 frames (~5 seconds at 60fps) */
         log_throttle_counter++;
         if (log_throttle_counter >= 300 && shader_count > 0) {
-            log_debug("Shader animation active: %d outputs rendering at ~60 FPS", shader_count);
+            log_debug("Shader animation active: %d outputs (frame-callback paced)", shader_count);
             log_throttle_counter = 0;
         }
     }
 
+    /* Join render threads before EGL/Wayland teardown */
+    render_threads_stop(state);
+
     /* Clean up file descriptors */
     if (state->timer_fd >= 0) {
         close(state->timer_fd);
@@ -833,6 +1239,25 @@ void event_loop_request_redraw(struct neowall_state *state) {
     }
 }
 
+/* Wake whichever loop schedules this output (background work finished) */
+void event_loop_wake_output(struct output_state *output) {
+    if (!output) {
+        return;
+    }
+
+    if (output->render_thread) {
+        render_thread_wakeup(output);
+        return;
+    }
+
+    struct neowall_state *state = output->state;
+    if (state && state->wakeup_fd >= 0) {
+        uint64_t value = 1;
+        ssize_t s = write(state->wakeup_fd, &value, sizeof(value));
+        (void)s; /* Counter saturation (EAGAIN) still leaves poll woken */
+    }
+}
+
 /* Request a redraw for a specific output */
 void event_loop_request_output_redraw(struct output_state *output) {
     if (output) {
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "egl/capability.h"
+#include "gl_debug.h"
+
+/* KHR_debug tokens and entry point (ES exposes them with the KHR suffix) */
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS_KHR 0x8242
+#define GL_DEBUG_OUTPUT_KHR             0x92E0
+#define GL_DEBUG_TYPE_ERROR_KHR         0x824C
+#define GL_DEBUG_SEVERITY_HIGH_KHR      0x9146
+#define GL_DEBUG_SEVERITY_NOTIFICATION_KHR 0x826B
+
+typedef void (GL_APIENTRY *gl_debug_proc)(GLenum source, GLenum type, GLuint id,
+                                          GLenum severity, GLsizei length,
+                                          const GLchar *message, const void *user_param);
+typedef void (GL_APIENTRY *gl_debug_message_callback_fn)(gl_debug_proc callback,
+                                                         const void *user_param);
+
+#ifdef NEOWALL_GL_DEBUG
+bool gl_debug_active = true;
+#else
+bool gl_debug_active = false;
+#endif
+
+void gl_debug_set_enabled(bool enabled) {
+    gl_debug_active = enabled;
+    if (enabled) {
+        log_info("GL debug layer enabled: checking GL errors on every call");
+    }
+}
+
+static void GL_APIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id,
+                                          GLenum severity, GLsizei length,
+                                          const GLchar *message, const void *user_param) {
+    (void)source;
+    (void)length;
+    (void)user_param;
+
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION_KHR) {
+        log_debug("GL debug [id %u]: %s", id, message);
+    } else if (type == GL_DEBUG_TYPE_ERROR_KHR || severity == GL_DEBUG_SEVERITY_HIGH_KHR) {
+        log_error("GL debug [id %u]: %s", id, message);
+    } else {
+        log_info("GL debug [id %u]: %s", id, message);
+    }
+}
+
+void gl_debug_setup_context(void) {
+    if (!gl_debug_active || !gles_has_extension("GL_KHR_debug")) {
+        return;
+    }
+
+    gl_debug_message_callback_fn message_callback = (gl_debug_message_callback_fn)
+        eglGetProcAddress("glDebugMessageCallbackKHR");
+    if (!message_callback) {
+        log_debug("GL_KHR_debug advertised but glDebugMessageCallbackKHR is missing");
+        return;
+    }
+
+    /* Synchronous output so a message is logged from inside the offending call */
+    glEnable(GL_DEBUG_OUTPUT_KHR);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_KHR);
+    message_callback(gl_debug_callback, NULL);
+    log_debug("Installed KHR_debug message callback");
+}
+
+bool gl_debug_check(const char *format, ...) {
+    GLenum error = glGetError();
+    if (error == GL_NO_ERROR) {
+        return true;
+    }
+
+    char what[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(what, sizeof(what), format, args);
+    va_end(args);
+
+    log_error("OpenGL error %s: 0x%x", what, error);
+    return false;
+}
+
+void gl_debug_clear(void) {
+    while (glGetError() != GL_NO_ERROR);
+}
@@ -4,15 +4,60 @@
 #include <strings.h>
 #include <errno.h>
 #include <stdint.h>
+#include <sys/mman.h>
 #include <png.h>
 #include <jpeglib.h>
 #include "neowall.h"
 #include "constants.h"
+#include "image_disk_cache.h"
+#include "image_scale.h"
+#include "parallel.h"
+
+/* Display geometry a decoder can use to produce only what will be shown */
+struct decode_hint {
+    int32_t display_width;
+    int32_t display_height;
+    enum wallpaper_mode mode;
+    bool bounded;           /* Fit inside without padding, bottom-up rows (iChannel images) */
+};
+
+/* Where a display-mode scale puts the image: resampled to scaled_width x
+ * scaled_height, its (crop_x, crop_y, width, height) window lands at
+ * (pad_x, pad_y) of an out_width x out_height buffer */
+struct display_layout {
+    uint32_t scaled_width;
+    uint32_t scaled_height;
+    uint32_t out_width;
+    uint32_t out_height;
+    uint32_t crop_x;
+    uint32_t crop_y;
+    uint32_t pad_x;
+    uint32_t pad_y;
+    uint32_t width;
+    uint32_t height;
+    bool tile;              /* Repeated to display size afterwards */
+    bool bottom_up;         /* Region rows written last to first (GL row order) */
+};
 
 /* Forward declarations */
+static void calculate_optimal_dimensions(uint32_t img_width, uint32_t img_height,
+                                         int32_t display_width, int32_t display_height,
+                                         enum wallpaper_mode mode,
+                                         uint32_t *out_width, uint32_t *out_height);
+static bool display_layout_plan(uint32_t img_width, uint32_t img_height,
+                                int32_t display_width, int32_t display_height,
+                                enum wallpaper_mode mode, struct display_layout *layout);
+static bool bounded_layout_plan(uint32_t img_width, uint32_t img_height, uint32_t max_size,
+                                struct display_layout *layout);
+static bool decode_layout_plan(uint32_t img_width, uint32_t img_height,
+                               const struct decode_hint *hint, struct display_layout *layout);
+static uint8_t *display_layout_alloc(const struct display_layout *layout);
+static uint8_t *display_layout_origin(const struct display_layout *layout, uint8_t *pixels);
+static ptrdiff_t display_layout_stride(const struct display_layout *layout);
+static struct image_data *image_scale_compose(struct image_data *img, const struct display_layout *layout);
+static struct image_data *image_tile_to_size(struct image_data *img, uint32_t target_width, uint32_t target_height);
 static struct image_data *image_scale_to_display(struct image_data *img, int32_t display_width, 
                                                    int32_t display_height, enum wallpaper_mode mode);
-static struct image_data *image_scale_bilinear(struct image_data *img, uint32_t new_width, uint32_t new_height);
 
 /* Expand path with tilde */
 static bool expand_path(const char *path, char *expanded, size_t size) {
@@ -77,8 +122,11 @@ enum image_format image_detect_format(const char *path) {
     return FORMAT_UNKNOWN;
 }
 
-/* Load PNG image */
-struct image_data *image_load_png(const char *path) {
+/* Decode a PNG; with a hint, rows stream through the resampler into the
+ * display-ready result and *display_ready is set */
+static struct image_data *png_decode(const char *path, const struct decode_hint *hint, bool *display_ready) {
+    *display_ready = false;
+
     if (!path) {
         log_error("Invalid path for PNG loading");
         return NULL;
@@ -127,9 +175,19 @@ struct image_data *image_load_png(const char *path) {
         return NULL;
     }
 
+    /* Modified after setjmp - volatile so the error path sees current values */
+    struct image_data *volatile img = NULL;
+    png_bytep *volatile row_pointers = NULL;
+    png_bytep volatile row = NULL;
+    struct image_scale_stream *volatile stream = NULL;
+
     /* Set up error handling */
     if (setjmp(png_jmpbuf(png_ptr))) {
         log_error("Error reading PNG file %s", expanded_path);
+        image_scale_stream_destroy(stream);
+        free(row);
+        free(row_pointers);
+        image_free(img);
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         fclose(fp);
         return NULL;
@@ -178,10 +236,12 @@ struct image_data *image_load_png(const char *path) {
         png_set_gray_to_rgb(png_ptr);
     }
 
+    /* png_read_image() assembles interlaced passes only when asked to */
+    png_set_interlace_handling(png_ptr);
     png_read_update_info(png_ptr, info_ptr);
 
     /* Allocate image data */
-    struct image_data *img = calloc(1, sizeof(struct image_data));
+    img = calloc(1, sizeof(struct image_data));
     if (!img) {
         log_error("Failed to allocate image data: %s", strerror(errno));
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
@@ -195,8 +255,66 @@ struct image_data *image_load_png(const char *path) {
     img->format = FORMAT_PNG;
     strncpy(img->path, path, sizeof(img->path) - 1);
 
-    /* Allocate pixel buffer */
     size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
+
+    /* Stream rows straight into the display-sized result: peak memory is the
+     * output plus a few source rows instead of the full-resolution image.
+     * Interlaced images only complete rows in the last pass, so they don't. */
+    struct display_layout layout;
+    if (hint && png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE &&
+        decode_layout_plan(width, height, hint, &layout)) {
+        log_info("Streaming PNG %s (%ux%u) to %ux%u for %dx%d display (mode=%d)",
+                 expanded_path, width, height, layout.scaled_width, layout.scaled_height,
+                 hint->display_width, hint->display_height, hint->mode);
+
+        img->pixels = display_layout_alloc(&layout);
+        row = malloc(row_bytes);
+        if (img->pixels && row) {
+            stream = image_scale_stream_create(width, height, layout.scaled_width, layout.scaled_height,
+                                               layout.crop_x, layout.crop_y, layout.width, layout.height,
+                                               display_layout_origin(&layout, img->pixels),
+                                               display_layout_stride(&layout),
+                                               image_scale_pick_filter(width, height, layout.scaled_width,
+                                                                       layout.scaled_height));
+        }
+        if (!stream) {
+            log_error("Failed to allocate PNG streaming buffers: %s", strerror(errno));
+            free(row);
+            image_free(img);
+            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+            fclose(fp);
+            return NULL;
+        }
+
+        for (uint32_t y = 0; y < height; y++) {
+            png_read_row(png_ptr, row, NULL);
+            image_scale_stream_push(stream, row);
+        }
+        bool complete = image_scale_stream_complete(stream);
+
+        image_scale_stream_destroy(stream);
+        free(row);
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        fclose(fp);
+
+        if (!complete) {
+            log_error("PNG stream ended before the image was complete: %s", expanded_path);
+            image_free(img);
+            return NULL;
+        }
+
+        img->width = layout.out_width;
+        img->height = layout.out_height;
+        if (layout.tile) {
+            img = image_tile_to_size(img, hint->display_width, hint->display_height);
+        }
+        *display_ready = true;
+
+        log_info("Loaded PNG image: %s (%ux%u)", expanded_path, img->width, img->height);
+        return img;
+    }
+
+    /* Allocate pixel buffer */
     /* Height and row_bytes are constrained by PNG format, overflow not possible */
     img->pixels = malloc(row_bytes * height);
     if (!img->pixels) {
@@ -209,7 +327,7 @@ struct image_data *image_load_png(const char *path) {
 
     /* Allocate row pointers */
     /* sizeof(png_bytep) is pointer size (8 bytes), height constrained by format */
-    png_bytep *row_pointers = malloc(sizeof(png_bytep) * height);
+    row_pointers = malloc(sizeof(png_bytep) * height);
     if (!row_pointers) {
         log_error("Failed to allocate row pointers: %s", strerror(errno));
         free(img->pixels);
@@ -219,8 +337,10 @@ struct image_data *image_load_png(const char *path) {
         return NULL;
     }
 
+    /* Bounded loads want GL row order: libpng fills the rows bottom-up */
+    bool bottom_up = hint && hint->bounded;
     for (uint32_t y = 0; y < height; y++) {
-        row_pointers[y] = img->pixels + y * row_bytes;
+        row_pointers[y] = img->pixels + (bottom_up ? height - 1 - y : y) * row_bytes;
     }
 
     /* Read image data */
@@ -236,6 +356,12 @@ struct image_data *image_load_png(const char *path) {
     return img;
 }
 
+/* Load PNG image */
+struct image_data *image_load_png(const char *path) {
+    bool display_ready;
+    return png_decode(path, NULL, &display_ready);
+}
+
 /* JPEG error handler */
 struct jpeg_error_mgr_ext {
     struct jpeg_error_mgr pub;
@@ -249,8 +375,48 @@ static void jpeg_error_exit(j_common_ptr cinfo) {
     longjmp(err->setjmp_buffer, 1);
 }
 
-/* Load JPEG image */
-struct image_data *image_load_jpeg(const char *path) {
+/* Centered window of a width x height image with the display's aspect ratio
+ * (the part MODE_FILL keeps) */
+static void fill_crop_rect(uint32_t width, uint32_t height, int32_t display_width, int32_t display_height,
+                           uint32_t *x, uint32_t *y, uint32_t *crop_width, uint32_t *crop_height) {
+    *x = 0;
+    *y = 0;
+    *crop_width = width;
+    *crop_height = height;
+
+    if ((uint64_t)width * (uint64_t)display_height > (uint64_t)height * (uint64_t)display_width) {
+        /* Image is wider - keep full height */
+        *crop_width = (uint32_t)(((uint64_t)height * (uint64_t)display_width + display_height / 2) /
+                                 (uint64_t)display_height);
+        *crop_width = *crop_width > 0 ? *crop_width : 1;
+        *x = (width - *crop_width) / 2;
+    } else {
+        /* Image is taller - keep full width */
+        *crop_height = (uint32_t)(((uint64_t)width * (uint64_t)display_height + display_width / 2) /
+                                  (uint64_t)display_width);
+        *crop_height = *crop_height > 0 ? *crop_height : 1;
+        *y = (height - *crop_height) / 2;
+    }
+}
+
+/* Largest power-of-two DCT scaling (1/1 .. 1/8) that still decodes at least
+ * as many pixels as the display mode scales the image to */
+static unsigned int jpeg_scale_denom(uint32_t width, uint32_t height, const struct decode_hint *hint) {
+    uint32_t target_width, target_height;
+    calculate_optimal_dimensions(width, height, hint->display_width, hint->display_height,
+                                 hint->mode, &target_width, &target_height);
+
+    for (unsigned int denom = 8; denom > 1; denom /= 2) {
+        if ((width + denom - 1) / denom >= target_width &&
+            (height + denom - 1) / denom >= target_height) {
+            return denom;
+        }
+    }
+    return 1;
+}
+
+/* Decode a JPEG, reduced and cropped to what the display needs when a hint is given */
+static struct image_data *jpeg_decode(const char *path, const struct decode_hint *hint) {
     if (!path) {
         log_error("Invalid path for JPEG loading");
         return NULL;
@@ -270,6 +436,9 @@ struct image_data *image_load_jpeg(const char *path) {
 
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr_ext jerr;
+    /* Modified after setjmp - volatile so the error path sees current values */
+    struct image_data *volatile img = NULL;
+    unsigned char *volatile row_buffer = NULL;
 
     /* Set up error handling */
     cinfo.err = jpeg_std_error(&jerr.pub);
@@ -277,6 +446,8 @@ struct image_data *image_load_jpeg(const char *path) {
 
     if (setjmp(jerr.setjmp_buffer)) {
         log_error("JPEG error: %s (file: %s)", jerr.error_msg, expanded_path);
+        free(row_buffer);
+        image_free(img);
         jpeg_destroy_decompress(&cinfo);
         fclose(fp);
         return NULL;
@@ -291,30 +462,79 @@ struct image_data *image_load_jpeg(const char *path) {
     /* Read JPEG header */
     jpeg_read_header(&cinfo, TRUE);
 
-    /* Force RGB output */
+#ifdef JCS_ALPHA_EXTENSIONS
+    /* libjpeg-turbo writes RGBA directly (alpha = 255) */
+    cinfo.out_color_space = JCS_EXT_RGBA;
+#else
+    /* Force RGB output, expanded to RGBA per row */
     cinfo.out_color_space = JCS_RGB;
+#endif
+
+    /* Reduced-size IDCT: decoding 1/2, 1/4 or 1/8 is far cheaper than
+     * decoding everything and resampling it away afterwards */
+    if (hint) {
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = jpeg_scale_denom(cinfo.image_width, cinfo.image_height, hint);
+    }
 
     /* Start decompression */
     jpeg_start_decompress(&cinfo);
 
-    uint32_t width = cinfo.output_width;
-    uint32_t height = cinfo.output_height;
     uint32_t channels = cinfo.output_components;
-
-    log_debug("Loading JPEG: %s (%ux%u, %u channels)",
-              expanded_path, width, height, channels);
-
-    if (channels != 3) {
+    if (channels != 3 && channels != 4) {
         log_error("Unexpected number of channels in JPEG: %u", channels);
         jpeg_destroy_decompress(&cinfo);
         fclose(fp);
         return NULL;
     }
 
+    /* Region to keep: the display-aspect window for MODE_FILL, else everything */
+    uint32_t crop_x = 0, crop_y = 0;
+    uint32_t width = cinfo.output_width;
+    uint32_t height = cinfo.output_height;
+    if (hint && hint->mode == MODE_FILL) {
+        fill_crop_rect(cinfo.output_width, cinfo.output_height,
+                       hint->display_width, hint->display_height,
+                       &crop_x, &crop_y, &width, &height);
+    }
+
+    /* Skip unneeded columns and rows inside the decoder where possible */
+    uint32_t skip_x = crop_x;
+#ifdef LIBJPEG_TURBO_VERSION
+    if (width < cinfo.output_width) {
+        JDIMENSION xoffset = crop_x, crop_width = width;
+        jpeg_crop_scanline(&cinfo, &xoffset, &crop_width);  /* Aligns to iMCU boundaries */
+        skip_x = crop_x - xoffset;
+    }
+    if (crop_y > 0) {
+        jpeg_skip_scanlines(&cinfo, crop_y);
+    }
+#else
+    while (cinfo.output_scanline < crop_y) {
+        unsigned char *discard[1] = { NULL };
+        if (!row_buffer) {
+            row_buffer = malloc((size_t)cinfo.output_width * channels);
+            if (!row_buffer) {
+                log_error("Failed to allocate row buffer: %s", strerror(errno));
+                jpeg_destroy_decompress(&cinfo);
+                fclose(fp);
+                return NULL;
+            }
+        }
+        discard[0] = row_buffer;
+        jpeg_read_scanlines(&cinfo, discard, 1);
+    }
+#endif
+
+    log_debug("Loading JPEG: %s (%ux%u, decoding 1/%u, region %ux%u+%u+%u)",
+              expanded_path, cinfo.image_width, cinfo.image_height, cinfo.scale_denom,
+              width, height, crop_x, crop_y);
+
     /* Allocate image data */
-    struct image_data *img = calloc(1, sizeof(struct image_data));
+    img = calloc(1, sizeof(struct image_data));
     if (!img) {
         log_error("Failed to allocate image data: %s", strerror(errno));
+        free(row_buffer);
         jpeg_destroy_decompress(&cinfo);
         fclose(fp);
         return NULL;
@@ -322,15 +542,16 @@ struct image_data *image_load_jpeg(const char *path) {
 
     img->width = width;
     img->height = height;
-    img->channels = 4; /* We'll convert RGB to RGBA */
+    img->channels = 4;
     img->format = FORMAT_JPEG;
     strncpy(img->path, path, sizeof(img->path) - 1);
 
     /* Allocate pixel buffer (RGBA) - check for overflow */
     size_t pixel_count = (size_t)width * (size_t)height;
     if (pixel_count > SIZE_MAX / 4) {
-        log_error("Image too large (potential overflow): %dx%d", width, height);
-        free(img);
+        log_error("Image too large (potential overflow): %ux%u", width, height);
+        image_free(img);
+        free(row_buffer);
         jpeg_destroy_decompress(&cinfo);
         fclose(fp);
         return NULL;
@@ -338,48 +559,57 @@ struct image_data *image_load_jpeg(const char *path) {
     img->pixels = malloc(pixel_count * 4);
     if (!img->pixels) {
         log_error("Failed to allocate pixel buffer: %s", strerror(errno));
-        free(img);
+        image_free(img);
+        free(row_buffer);
         jpeg_destroy_decompress(&cinfo);
         fclose(fp);
         return NULL;
     }
 
-    /* Allocate temporary RGB row buffer */
-    /* JPEG width is int type, constrained by format (max 65535 typically) */
-    size_t row_stride = width * 3;
-    unsigned char *row_buffer = malloc(row_stride);
-    if (!row_buffer) {
-        log_error("Failed to allocate row buffer: %s", strerror(errno));
-        free(img->pixels);
-        free(img);
-        jpeg_destroy_decompress(&cinfo);
-        fclose(fp);
-        return NULL;
+    /* RGBA rows with nothing to trim are decoded in place */
+    bool direct = channels == 4 && skip_x == 0 && cinfo.output_width == width;
+    if (!direct && !row_buffer) {
+        row_buffer = malloc((size_t)cinfo.output_width * channels);
+        if (!row_buffer) {
+            log_error("Failed to allocate row buffer: %s", strerror(errno));
+            image_free(img);
+            jpeg_destroy_decompress(&cinfo);
+            fclose(fp);
+            return NULL;
+        }
     }
 
-    /* Read scanlines and convert RGB to RGBA */
-    uint32_t row = 0;
-    while (cinfo.output_scanline < height) {
-        unsigned char *row_ptr = row_buffer;
+    /* Bounded loads want GL row order: scanlines land bottom-up */
+    bool bottom_up = hint && hint->bounded;
+    for (uint32_t row = 0; row < height; row++) {
+        uint8_t *dst = img->pixels + (size_t)(bottom_up ? height - 1 - row : row) * width * 4;
+        unsigned char *row_ptr = direct ? dst : row_buffer;
         jpeg_read_scanlines(&cinfo, &row_ptr, 1);
+        if (direct) {
+            continue;
+        }
 
+        const unsigned char *src = row_buffer + (size_t)skip_x * channels;
+        if (channels == 4) {
+            memcpy(dst, src, (size_t)width * 4);
+            continue;
+        }
         /* Convert RGB to RGBA */
         for (uint32_t x = 0; x < width; x++) {
-            uint32_t src_idx = x * 3;
-            uint32_t dst_idx = (row * width + x) * 4;
-
-            img->pixels[dst_idx + 0] = row_buffer[src_idx + 0]; /* R */
-            img->pixels[dst_idx + 1] = row_buffer[src_idx + 1]; /* G */
-            img->pixels[dst_idx + 2] = row_buffer[src_idx + 2]; /* B */
-            img->pixels[dst_idx + 3] = ALPHA_OPAQUE;                      /* A */
+            dst[x * 4 + 0] = src[x * 3 + 0]; /* R */
+            dst[x * 4 + 1] = src[x * 3 + 1]; /* G */
+            dst[x * 4 + 2] = src[x * 3 + 2]; /* B */
+            dst[x * 4 + 3] = ALPHA_OPAQUE;   /* A */
         }
-
-        row++;
     }
 
-    /* Clean up */
+    /* Clean up - rows below the region are never decoded */
     free(row_buffer);
-    jpeg_finish_decompress(&cinfo);
+    if (cinfo.output_scanline < cinfo.output_height) {
+        jpeg_abort_decompress(&cinfo);
+    } else {
+        jpeg_finish_decompress(&cinfo);
+    }
     jpeg_destroy_decompress(&cinfo);
     fclose(fp);
 
@@ -388,6 +618,11 @@ struct image_data *image_load_jpeg(const char *path) {
     return img;
 }
 
+/* Load JPEG image */
+struct image_data *image_load_jpeg(const char *path) {
+    return jpeg_decode(path, NULL);
+}
+
 /* Load image from file (auto-detect format) with display-aware scaling */
 struct image_data *image_load(const char *path, int32_t display_width, 
                               int32_t display_height, enum wallpaper_mode mode) {
@@ -398,13 +633,37 @@ struct image_data *image_load(const char *path, int32_t display_width,
 
     enum image_format format = image_detect_format(path);
     struct image_data *img = NULL;
+    bool display_ready = false;
+    struct decode_hint hint = {
+        .display_width = display_width,
+        .display_height = display_height,
+        .mode = mode,
+    };
+    const struct decode_hint *display_hint = (display_width > 0 && display_height > 0) ? &hint : NULL;
+    
+    /* Display-ready images are cached on disk per (file, output size, mode) */
+    char expanded_path[MAX_PATH_LENGTH];
+    bool cacheable = display_hint && format != FORMAT_UNKNOWN &&
+                     expand_path(path, expanded_path, sizeof(expanded_path));
+    if (cacheable) {
+        img = image_disk_cache_load(expanded_path, display_width, display_height, mode);
+        if (img) {
+            strncpy(img->path, path, sizeof(img->path) - 1);
+            img->path[sizeof(img->path) - 1] = '\0';
+            img->display_width = display_width;
+            img->display_height = display_height;
+            img->display_mode = mode;
+            log_info("Loaded %s (%ux%u) from wallpaper cache", path, img->width, img->height);
+            return img;
+        }
+    }
     
     switch (format) {
         case FORMAT_PNG:
-            img = image_load_png(path);
+            img = png_decode(path, display_hint, &display_ready);
             break;
         case FORMAT_JPEG:
-            img = image_load_jpeg(path);
+            img = jpeg_decode(path, display_hint);
             break;
         default:
             log_error("Unsupported or unknown image format: %s", path);
@@ -416,23 +675,87 @@ struct image_data *image_load(const char *path, int32_t display_width,
     }
 
     /* Scale image intelligently based on display dimensions and mode */
-    if (display_width > 0 && display_height > 0) {
+    if (!display_ready && display_width > 0 && display_height > 0) {
         img = image_scale_to_display(img, display_width, display_height, mode);
     }
 
+    if (!img) {
+        return NULL;
+    }
+    if (display_hint) {
+        img->display_width = display_width;
+        img->display_height = display_height;
+        img->display_mode = mode;
+    }
+
+    if (cacheable && img->pixels) {
+        image_disk_cache_store_async(expanded_path, display_width, display_height, mode, img);
+    }
+
     return img;
 }
 
+/* Load an image no larger than max_size on either side, keeping its aspect ratio
+ * and without padding (iChannel images); smaller images keep their size. Rows
+ * come out bottom-up, written that way by the decoder or the resampler. */
+struct image_data *image_load_bounded(const char *path, uint32_t max_size) {
+    if (!path || max_size == 0) {
+        log_error("Invalid parameters for image_load_bounded");
+        return NULL;
+    }
+
+    /* Lets PNGs stream through the resampler and libjpeg drop the DCT detail
+     * the fit would discard anyway */
+    struct decode_hint hint = {
+        .display_width = (int32_t)max_size,
+        .display_height = (int32_t)max_size,
+        .mode = MODE_FIT,
+        .bounded = true,
+    };
+    struct image_data *img = NULL;
+    bool display_ready = false;
+
+    switch (image_detect_format(path)) {
+        case FORMAT_PNG:
+            img = png_decode(path, &hint, &display_ready);
+            break;
+        case FORMAT_JPEG:
+            img = jpeg_decode(path, &hint);
+            break;
+        default:
+            log_error("Unsupported or unknown image format: %s", path);
+            return NULL;
+    }
+
+    /* Decoded rows are bottom-up already, so the resampler keeps their order */
+    struct display_layout layout;
+    if (!img || display_ready || !bounded_layout_plan(img->width, img->height, max_size, &layout)) {
+        return img;
+    }
+
+    log_debug("Bounding %s from %ux%u to %ux%u", path, img->width, img->height,
+              layout.out_width, layout.out_height);
+    return image_scale_compose(img, &layout);
+}
+
 /* Free only pixel data, keeping metadata (for memory optimization after GPU upload) */
 void image_free_pixels(struct image_data *img) {
     if (!img) {
         return;
     }
 
-    if (img->pixels) {
+    if (img->mapping) {
+        munmap(img->mapping, img->mapping_size);
+        img->mapping = NULL;
+        img->mapping_size = 0;
+    } else if (img->pixels) {
         free(img->pixels);
-        img->pixels = NULL;
     }
+    img->pixels = NULL;
+
+    free(img->compressed);
+    img->compressed = NULL;
+    img->compressed_size = 0;
 }
 
 /* Free image data */
@@ -518,57 +841,227 @@ static void calculate_optimal_dimensions(uint32_t img_width, uint32_t img_height
     }
 }
 
-/* Pad image to exact dimensions with transparent borders (center positioning) */
-static struct image_data *image_center_pad(struct image_data *img, uint32_t pad_width, uint32_t pad_height) {
-    if (!img || !img->pixels) {
-        return img;
+/* Fill pixels with opaque black (R=0, G=0, B=0, A=255) */
+static void fill_opaque_black(uint8_t *pixels, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        pixels[i * 4 + 0] = 0;
+        pixels[i * 4 + 1] = 0;
+        pixels[i * 4 + 2] = 0;
+        pixels[i * 4 + 3] = ALPHA_OPAQUE;
+    }
+}
+
+/* Place a scaled extent on a display extent: center-crop it if larger (when
+ * allowed) or center it between padding if smaller (when allowed) */
+static void layout_axis(uint32_t scaled, uint32_t display, bool crop, bool pad,
+                        uint32_t *out, uint32_t *crop_offset, uint32_t *pad_offset, uint32_t *extent) {
+    *out = scaled;
+    *crop_offset = 0;
+    *pad_offset = 0;
+    *extent = scaled;
+
+    if (crop && scaled > display) {
+        *out = display;
+        *crop_offset = (scaled - display) / 2;
+        *extent = display;
+    } else if (pad && scaled < display) {
+        *out = display;
+        *pad_offset = (display - scaled) / 2;
     }
+}
+
+/* Work out the display layout for an image of the given size
+ *
+ * Returns false when the image is used as is (already optimal, or the mode
+ * does not upscale). */
+static bool display_layout_plan(uint32_t img_width, uint32_t img_height,
+                                int32_t display_width, int32_t display_height,
+                                enum wallpaper_mode mode, struct display_layout *layout) {
+    /* Calculate optimal dimensions for this display mode */
+    uint32_t target_width, target_height;
+    calculate_optimal_dimensions(img_width, img_height, display_width, display_height,
+                                 mode, &target_width, &target_height);
     
-    /* No padding needed if already exact size or larger */
-    if (img->width >= pad_width && img->height >= pad_height) {
-        return img;
+    /* Only scale if dimensions changed */
+    if (target_width == img_width && target_height == img_height) {
+        log_debug("Image %ux%u already optimal for display %dx%d (mode=%d)",
+                 img_width, img_height, display_width, display_height, mode);
+        return false;
     }
     
-    log_debug("Center-padding image from %ux%u to %ux%u",
-             img->width, img->height, pad_width, pad_height);
+    /* Only downscale for modes other than FILL/STRETCH (which need to fill display) */
+    if (mode != MODE_FILL && mode != MODE_STRETCH) {
+        if (target_width > img_width || target_height > img_height) {
+            log_debug("Keeping original size %ux%u (would upscale to %ux%u)",
+                     img_width, img_height, target_width, target_height);
+            return false;
+        }
+    }
     
-    /* Allocate new pixel buffer filled with opaque black (R=0, G=0, B=0, A=255) */
-    size_t new_size = (size_t)pad_width * pad_height * 4; /* RGBA */
-    uint8_t *new_pixels = malloc(new_size);
-    if (!new_pixels) {
-        log_error("Failed to allocate memory for padded image");
-        return img;
+    /* Produce the exact display size for seamless transitions
+     * All modes except TILE end up exactly display-sized for consistent rendering:
+     * FILL keeps the centered display-sized window, FIT centers between black
+     * borders, CENTER (1:1) crops if larger and pads if smaller, STRETCH is
+     * already exact and TILE is repeated to display size afterwards */
+    bool crop = (mode == MODE_FILL || mode == MODE_CENTER);
+    bool pad = (mode == MODE_FIT || mode == MODE_CENTER);
+    
+    layout->scaled_width = target_width;
+    layout->scaled_height = target_height;
+    layout->tile = (mode == MODE_TILE);
+    layout->bottom_up = false;
+    layout_axis(target_width, display_width, crop, pad,
+                &layout->out_width, &layout->crop_x, &layout->pad_x, &layout->width);
+    layout_axis(target_height, display_height, crop, pad,
+                &layout->out_height, &layout->crop_y, &layout->pad_y, &layout->height);
+    return true;
+}
+
+/* Layout shrinking an image to fit max_size on both sides, without padding;
+ * false if it already fits */
+static bool bounded_layout_plan(uint32_t img_width, uint32_t img_height, uint32_t max_size,
+                                struct display_layout *layout) {
+    if (img_width <= max_size && img_height <= max_size) {
+        return false;
+    }
+
+    uint32_t longest = img_width > img_height ? img_width : img_height;
+    uint32_t width = (uint32_t)((uint64_t)img_width * max_size / longest);
+    uint32_t height = (uint32_t)((uint64_t)img_height * max_size / longest);
+    *layout = (struct display_layout) {
+        .scaled_width = width > 0 ? width : 1,
+        .scaled_height = height > 0 ? height : 1,
+    };
+    layout->out_width = layout->width = layout->scaled_width;
+    layout->out_height = layout->height = layout->scaled_height;
+    return true;
+}
+
+/* Layout a decoder streams into for a hint; bounded loads get bottom-up rows */
+static bool decode_layout_plan(uint32_t img_width, uint32_t img_height,
+                               const struct decode_hint *hint, struct display_layout *layout) {
+    if (hint->bounded) {
+        if (!bounded_layout_plan(img_width, img_height, (uint32_t)hint->display_width, layout)) {
+            return false;
+        }
+        layout->bottom_up = true;
+        return true;
+    }
+    return display_layout_plan(img_width, img_height, hint->display_width, hint->display_height,
+                               hint->mode, layout);
+}
+
+/* Allocate the output buffer of a layout with its padding already filled */
+static uint8_t *display_layout_alloc(const struct display_layout *layout) {
+    size_t stride = (size_t)layout->out_width * 4;
+    uint8_t *pixels = malloc(stride * layout->out_height);
+    if (!pixels) {
+        log_error("Failed to allocate scaled image buffer");
+        return NULL;
     }
     
-    /* Fill with opaque black (important: alpha = 255 for opaque) */
-    for (size_t i = 0; i < new_size; i += 4) {
-        new_pixels[i] = 0;       /* R */
-        new_pixels[i + 1] = 0;   /* G */
-        new_pixels[i + 2] = 0;   /* B */
-        new_pixels[i + 3] = 255; /* A - opaque */
+    /* Padding: black bars above and below, then left and right of each image row */
+    if (layout->width < layout->out_width || layout->height < layout->out_height) {
+        uint32_t bottom = layout->pad_y + layout->height;
+        uint32_t right = layout->pad_x + layout->width;
+        fill_opaque_black(pixels, (size_t)layout->out_width * layout->pad_y);
+        fill_opaque_black(pixels + bottom * stride, (size_t)layout->out_width * (layout->out_height - bottom));
+        for (uint32_t y = layout->pad_y; y < bottom; y++) {
+            uint8_t *row = pixels + y * stride;
+            fill_opaque_black(row, layout->pad_x);
+            fill_opaque_black(row + (size_t)right * 4, layout->out_width - right);
+        }
+    }
+    return pixels;
+}
+
+/* First pixel of the image region's first row within a layout's output buffer */
+static uint8_t *display_layout_origin(const struct display_layout *layout, uint8_t *pixels) {
+    uint32_t row = layout->bottom_up ? layout->pad_y + layout->height - 1 : layout->pad_y;
+    return pixels + ((size_t)row * layout->out_width + layout->pad_x) * 4;
+}
+
+/* Distance from one region row to the next in a layout's output buffer */
+static ptrdiff_t display_layout_stride(const struct display_layout *layout) {
+    ptrdiff_t stride = (ptrdiff_t)layout->out_width * 4;
+    return layout->bottom_up ? -stride : stride;
+}
+
+static const char *filter_name(enum image_scale_filter filter) {
+    switch (filter) {
+        case IMAGE_SCALE_AREA:
+            return "area";
+        case IMAGE_SCALE_LANCZOS3:
+            return "lanczos3";
+        default:
+            return "bilinear";
+    }
+}
+
+/* Scale, crop and pad in one pass into a single new buffer
+ *
+ * Only the pixels that survive the crop are resampled, straight into their
+ * place in the padded result; the resampler splits rows across worker threads. */
+static struct image_data *image_scale_compose(struct image_data *img, const struct display_layout *layout) {
+    if (!img || !img->pixels) {
+        return img;
     }
     
-    /* Calculate position to center the image */
-    uint32_t offset_x = (pad_width > img->width) ? (pad_width - img->width) / 2 : 0;
-    uint32_t offset_y = (pad_height > img->height) ? (pad_height - img->height) / 2 : 0;
+    uint8_t *new_pixels = display_layout_alloc(layout);
+    if (!new_pixels) {
+        return img;
+    }
     
-    /* Copy original image to center of new buffer */
-    for (uint32_t y = 0; y < img->height; y++) {
-        uint32_t dst_y = offset_y + y;
-        uint32_t src_offset = y * img->width * 4;
-        uint32_t dst_offset = (dst_y * pad_width + offset_x) * 4;
-        memcpy(new_pixels + dst_offset, img->pixels + src_offset, img->width * 4);
+    enum image_scale_filter filter = image_scale_pick_filter(img->width, img->height,
+                                                             layout->scaled_width, layout->scaled_height);
+    uint64_t start = get_time_ms();
+    if (!image_scale_rgba_region(img->pixels, img->width, img->height,
+                                 layout->scaled_width, layout->scaled_height,
+                                 layout->crop_x, layout->crop_y, layout->width, layout->height,
+                                 display_layout_origin(layout, new_pixels), display_layout_stride(layout),
+                                 filter)) {
+        log_error("Failed to allocate image scaling buffers");
+        free(new_pixels);
+        return img;
     }
+    log_debug("Resampled %ux%u -> %ux%u, region %ux%u+%u+%u into %ux%u (%s, %s) in %lums",
+              img->width, img->height, layout->scaled_width, layout->scaled_height,
+              layout->width, layout->height, layout->crop_x, layout->crop_y,
+              layout->out_width, layout->out_height, filter_name(filter),
+              image_scale_backend(), (unsigned long)(get_time_ms() - start));
     
-    /* Replace old pixels with padded ones */
+    /* Free old pixels and update image */
     free(img->pixels);
     img->pixels = new_pixels;
-    img->width = pad_width;
-    img->height = pad_height;
+    img->width = layout->out_width;
+    img->height = layout->out_height;
     
     return img;
 }
 
+struct tile_job {
+    const uint8_t *src;
+    uint32_t src_width;
+    uint32_t src_height;
+    uint8_t *dst;
+    uint32_t dst_width;
+};
+
+static void tile_band(void *ctx, uint32_t row_begin, uint32_t row_end) {
+    struct tile_job *job = ctx;
+    size_t src_stride = (size_t)job->src_width * 4;
+    size_t dst_stride = (size_t)job->dst_width * 4;
+    
+    for (uint32_t y = row_begin; y < row_end; y++) {
+        const uint8_t *src_row = job->src + (y % job->src_height) * src_stride;  /* Wrap vertically */
+        uint8_t *dst_row = job->dst + y * dst_stride;
+        /* Whole copies of the source row, then the partial one at the right edge */
+        for (size_t x = 0; x < dst_stride; x += src_stride) {
+            memcpy(dst_row + x, src_row, dst_stride - x < src_stride ? dst_stride - x : src_stride);
+        }
+    }
+}
+
 /* Tile image to fill exact dimensions by repeating the source image */
 static struct image_data *image_tile_to_size(struct image_data *img, uint32_t target_width, uint32_t target_height) {
     if (!img || !img->pixels) {
@@ -591,23 +1084,14 @@ static struct image_data *image_tile_to_size(struct image_data *img, uint32_t ta
         return img;
     }
     
-    /* Tile the image by copying it repeatedly */
-    for (uint32_t dst_y = 0; dst_y < target_height; dst_y++) {
-        uint32_t src_y = dst_y % img->height;  /* Wrap vertically */
-        
-        for (uint32_t dst_x = 0; dst_x < target_width; dst_x++) {
-            uint32_t src_x = dst_x % img->width;  /* Wrap horizontally */
-            
-            /* Copy pixel from source to destination */
-            uint32_t src_offset = (src_y * img->width + src_x) * 4;
-            uint32_t dst_offset = (dst_y * target_width + dst_x) * 4;
-            
-            new_pixels[dst_offset + 0] = img->pixels[src_offset + 0]; /* R */
-            new_pixels[dst_offset + 1] = img->pixels[src_offset + 1]; /* G */
-            new_pixels[dst_offset + 2] = img->pixels[src_offset + 2]; /* B */
-            new_pixels[dst_offset + 3] = img->pixels[src_offset + 3]; /* A */
-        }
-    }
+    struct tile_job job = {
+        .src = img->pixels,
+        .src_width = img->width,
+        .src_height = img->height,
+        .dst = new_pixels,
+        .dst_width = target_width,
+    };
+    parallel_bands(target_height, IMAGE_BAND_MIN_ROWS, tile_band, &job);
     
     /* Replace old pixels with tiled ones */
     free(img->pixels);
@@ -619,53 +1103,6 @@ static struct image_data *image_tile_to_size(struct image_data *img, uint32_t ta
     return img;
 }
 
-/* Center-crop image to exact dimensions */
-static struct image_data *image_center_crop(struct image_data *img, uint32_t crop_width, uint32_t crop_height) {
-    if (!img || !img->pixels) {
-        return img;
-    }
-    
-    /* No crop needed if already exact size */
-    if (img->width == crop_width && img->height == crop_height) {
-        return img;
-    }
-    
-    /* Calculate crop offsets (center crop) */
-    uint32_t offset_x = (img->width > crop_width) ? (img->width - crop_width) / 2 : 0;
-    uint32_t offset_y = (img->height > crop_height) ? (img->height - crop_height) / 2 : 0;
-    
-    /* Ensure we don't crop to larger than source */
-    uint32_t actual_crop_width = (crop_width < img->width) ? crop_width : img->width;
-    uint32_t actual_crop_height = (crop_height < img->height) ? crop_height : img->height;
-    
-    log_debug("Center-cropping image from %ux%u to %ux%u (offset: %u,%u)",
-             img->width, img->height, actual_crop_width, actual_crop_height, offset_x, offset_y);
-    
-    /* Allocate new pixel buffer */
-    size_t new_size = (size_t)actual_crop_width * actual_crop_height * 4; /* RGBA */
-    uint8_t *new_pixels = malloc(new_size);
-    if (!new_pixels) {
-        log_error("Failed to allocate memory for cropped image");
-        return img;
-    }
-    
-    /* Copy cropped region row by row */
-    for (uint32_t y = 0; y < actual_crop_height; y++) {
-        uint32_t src_y = offset_y + y;
-        uint32_t src_offset = (src_y * img->width + offset_x) * 4;
-        uint32_t dst_offset = y * actual_crop_width * 4;
-        memcpy(new_pixels + dst_offset, img->pixels + src_offset, actual_crop_width * 4);
-    }
-    
-    /* Replace old pixels with cropped ones */
-    free(img->pixels);
-    img->pixels = new_pixels;
-    img->width = actual_crop_width;
-    img->height = actual_crop_height;
-    
-    return img;
-}
-
 /* Scale image to optimal size for display mode */
 static struct image_data *image_scale_to_display(struct image_data *img, int32_t display_width, 
                                                    int32_t display_height, enum wallpaper_mode mode) {
@@ -673,137 +1110,22 @@ static struct image_data *image_scale_to_display(struct image_data *img, int32_t
         return img;
     }
     
-    /* Calculate optimal dimensions for this display mode */
-    uint32_t target_width, target_height;
-    calculate_optimal_dimensions(img->width, img->height, display_width, display_height,
-                                 mode, &target_width, &target_height);
-    
-    /* Only scale if dimensions changed */
-    if (target_width == img->width && target_height == img->height) {
-        log_debug("Image %ux%u already optimal for display %dx%d (mode=%d)",
-                 img->width, img->height, display_width, display_height, mode);
+    struct display_layout layout;
+    if (!display_layout_plan(img->width, img->height, display_width, display_height, mode, &layout)) {
         return img;
     }
     
-    /* Only downscale for modes other than FILL/STRETCH (which need to fill display) */
-    if (mode != MODE_FILL && mode != MODE_STRETCH) {
-        if (target_width > img->width || target_height > img->height) {
-            log_debug("Keeping original size %ux%u (would upscale to %ux%u)",
-                     img->width, img->height, target_width, target_height);
-            return img;
-        }
-    }
-    
     log_info("Scaling image from %ux%u to %ux%u for %dx%d display (mode=%d)",
-             img->width, img->height, target_width, target_height, 
+             img->width, img->height, layout.scaled_width, layout.scaled_height, 
              display_width, display_height, mode);
     
-    img = image_scale_bilinear(img, target_width, target_height);
+    img = image_scale_compose(img, &layout);
     
-    if (!img || !img->pixels) {
-        return img;
+    /* Physically tile the image to exact display size for seamless transitions
+     * This makes transitions work perfectly while maintaining tile appearance */
+    if (layout.tile) {
+        img = image_tile_to_size(img, display_width, display_height);
     }
     
-    /* Adjust image to exact display size for seamless transitions
-     * All modes except TILE need to be exact display size for consistent rendering */
-    switch (mode) {
-        case MODE_FILL:
-            /* Already scaled to fill, now crop excess to exact display size */
-            img = image_center_crop(img, display_width, display_height);
-            break;
-            
-        case MODE_FIT:
-            /* Scaled to fit inside, now pad to exact display size with black borders */
-            if (img->width < (uint32_t)display_width || img->height < (uint32_t)display_height) {
-                img = image_center_pad(img, display_width, display_height);
-            }
-            break;
-            
-        case MODE_CENTER:
-            /* No scaling (1:1 pixels), crop if larger or pad if smaller to exact display size */
-            if (img->width > (uint32_t)display_width || img->height > (uint32_t)display_height) {
-                img = image_center_crop(img, display_width, display_height);
-            } else if (img->width < (uint32_t)display_width || img->height < (uint32_t)display_height) {
-                img = image_center_pad(img, display_width, display_height);
-            }
-            /* else: already exact size, perfect! */
-            break;
-            
-        case MODE_STRETCH:
-            /* Already scaled to exact display size, no adjustment needed */
-            break;
-            
-        case MODE_TILE:
-            /* Physically tile the image to exact display size for seamless transitions
-             * This makes transitions work perfectly while maintaining tile appearance */
-            img = image_tile_to_size(img, display_width, display_height);
-            break;
-    }
-    
-    return img;
-}
-
-/* High-quality bilinear image scaling */
-static struct image_data *image_scale_bilinear(struct image_data *img, uint32_t new_width, uint32_t new_height) {
-    if (!img || !img->pixels) {
-        return img;
-    }
-    
-    /* Allocate new pixel buffer */
-    size_t new_size = (size_t)new_width * new_height * 4;
-    uint8_t *new_pixels = malloc(new_size);
-    if (!new_pixels) {
-        log_error("Failed to allocate scaled image buffer");
-        return img;
-    }
-    
-    float x_ratio = (float)(img->width - 1) / (float)new_width;
-    float y_ratio = (float)(img->height - 1) / (float)new_height;
-    
-    /* Bilinear interpolation */
-    for (uint32_t y = 0; y < new_height; y++) {
-        for (uint32_t x = 0; x < new_width; x++) {
-            float src_x = x * x_ratio;
-            float src_y = y * y_ratio;
-            
-            uint32_t x1 = (uint32_t)src_x;
-            uint32_t y1 = (uint32_t)src_y;
-            uint32_t x2 = (x1 < img->width - 1) ? x1 + 1 : x1;
-            uint32_t y2 = (y1 < img->height - 1) ? y1 + 1 : y1;
-            
-            float x_diff = src_x - x1;
-            float y_diff = src_y - y1;
-            
-            /* Get the four surrounding pixels */
-            size_t idx_tl = (y1 * img->width + x1) * 4;  /* Top-left */
-            size_t idx_tr = (y1 * img->width + x2) * 4;  /* Top-right */
-            size_t idx_bl = (y2 * img->width + x1) * 4;  /* Bottom-left */
-            size_t idx_br = (y2 * img->width + x2) * 4;  /* Bottom-right */
-            
-            size_t dst_idx = (y * new_width + x) * 4;
-            
-            /* Interpolate each channel (RGBA) */
-            for (int c = 0; c < 4; c++) {
-                float tl = img->pixels[idx_tl + c];
-                float tr = img->pixels[idx_tr + c];
-                float bl = img->pixels[idx_bl + c];
-                float br = img->pixels[idx_br + c];
-                
-                /* Bilinear interpolation formula */
-                float top = tl * (1.0f - x_diff) + tr * x_diff;
-                float bottom = bl * (1.0f - x_diff) + br * x_diff;
-                float value = top * (1.0f - y_diff) + bottom * y_diff;
-                
-                new_pixels[dst_idx + c] = (uint8_t)(value + 0.5f);  /* Round */
-            }
-        }
-    }
-    
-    /* Free old pixels and update image */
-    free(img->pixels);
-    img->pixels = new_pixels;
-    img->width = new_width;
-    img->height = new_height;
-    
     return img;
 }
\ No newline at end of file
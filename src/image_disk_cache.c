@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "neowall.h"
+#include "constants.h"
+#include "image_disk_cache.h"
+#include "decode_pool.h"
+
+#define IMAGE_CACHE_MAGIC   "NWIC"
+#define IMAGE_CACHE_VERSION 1u
+#define IMAGE_CACHE_ALIGN   4096u   /* Pixels start on a page boundary */
+
+struct image_cache_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key_hash;
+    /* Source identity - any change is a miss */
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t file_size;
+    int32_t display_width;
+    int32_t display_height;
+    uint32_t mode;
+    /* Stored image */
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint64_t data_offset;
+    char path[MAX_PATH_LENGTH];     /* Guards against hash collisions */
+};
+
+struct cache_entry {
+    char name[64];
+    off_t size;
+    struct timespec mtime;
+};
+
+static pthread_mutex_t disk_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool disk_cache_initialized = false;
+static bool disk_cache_available = false;
+static char cache_dir[MAX_PATH_LENGTH];
+
+static atomic_ulong cache_hits;
+static atomic_ulong cache_misses;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* mkdir -p */
+static bool ensure_directory(const char *path) {
+    char tmp[MAX_PATH_LENGTH];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(tmp, 0755) == -1 && errno != EEXIST) {
+                return false;
+            }
+            *p = '/';
+        }
+    }
+    return mkdir(tmp, 0755) == 0 || errno == EEXIST;
+}
+
+static bool disk_cache_init(void) {
+    pthread_mutex_lock(&disk_cache_lock);
+    if (disk_cache_initialized) {
+        pthread_mutex_unlock(&disk_cache_lock);
+        return disk_cache_available;
+    }
+    disk_cache_initialized = true;
+
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (cache_home && cache_home[0] != '\0') {
+        snprintf(cache_dir, sizeof(cache_dir), "%s/neowall/wallpapers", cache_home);
+    } else if (home && home[0] != '\0') {
+        snprintf(cache_dir, sizeof(cache_dir), "%s/.cache/neowall/wallpapers", home);
+    } else {
+        log_debug("No cache directory (XDG_CACHE_HOME and HOME unset), wallpaper disk cache disabled");
+        pthread_mutex_unlock(&disk_cache_lock);
+        return false;
+    }
+
+    if (!ensure_directory(cache_dir)) {
+        log_error("Failed to create wallpaper cache directory %s: %s", cache_dir, strerror(errno));
+        pthread_mutex_unlock(&disk_cache_lock);
+        return false;
+    }
+
+    disk_cache_available = true;
+    log_debug("Wallpaper disk cache: %s (limit %d MB)", cache_dir, IMAGE_CACHE_MAX_MB);
+    pthread_mutex_unlock(&disk_cache_lock);
+    return true;
+}
+
+/* Fill in the source identity part of a header; false if the file is gone */
+static bool fill_key(struct image_cache_header *header, const char *path, int32_t display_width,
+                     int32_t display_height, enum wallpaper_mode mode) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, IMAGE_CACHE_MAGIC, sizeof(header->magic));
+    header->version = IMAGE_CACHE_VERSION;
+    header->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    header->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    header->file_size = (uint64_t)st.st_size;
+    header->display_width = display_width;
+    header->display_height = display_height;
+    header->mode = (uint32_t)mode;
+    snprintf(header->path, sizeof(header->path), "%s", path);
+
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, path, strlen(path));
+    hash = fnv1a(hash, &header->mtime_sec, sizeof(header->mtime_sec));
+    hash = fnv1a(hash, &header->mtime_nsec, sizeof(header->mtime_nsec));
+    hash = fnv1a(hash, &header->file_size, sizeof(header->file_size));
+    hash = fnv1a(hash, &header->display_width, sizeof(header->display_width));
+    hash = fnv1a(hash, &header->display_height, sizeof(header->display_height));
+    hash = fnv1a(hash, &header->mode, sizeof(header->mode));
+    header->key_hash = hash;
+    return true;
+}
+
+static void entry_path(char *path, size_t size, uint64_t key_hash) {
+    snprintf(path, size, "%s/%016" PRIx64 ".rgba", cache_dir, key_hash);
+}
+
+struct image_data *image_disk_cache_load(const char *path, int32_t display_width,
+                                         int32_t display_height, enum wallpaper_mode mode) {
+    if (!path || display_width <= 0 || display_height <= 0 || !disk_cache_init()) {
+        return NULL;
+    }
+
+    struct image_cache_header key;
+    if (!fill_key(&key, path, display_width, display_height, mode)) {
+        return NULL;
+    }
+
+    char entry[MAX_PATH_LENGTH + 32];
+    entry_path(entry, sizeof(entry), key.key_hash);
+
+    int fd = open(entry, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        atomic_fetch_add(&cache_misses, 1);
+        return NULL;
+    }
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(struct image_cache_header)) {
+        /* Private writable mapping: consumers may modify pixels in place
+         * (copy-on-write) without touching the file */
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+
+    const struct image_cache_header *header = map != MAP_FAILED ? map : NULL;
+    bool valid = header &&
+                 memcmp(header->magic, key.magic, sizeof(key.magic)) == 0 &&
+                 header->version == key.version &&
+                 header->key_hash == key.key_hash &&
+                 header->mtime_sec == key.mtime_sec &&
+                 header->mtime_nsec == key.mtime_nsec &&
+                 header->file_size == key.file_size &&
+                 header->display_width == key.display_width &&
+                 header->display_height == key.display_height &&
+                 header->mode == key.mode &&
+                 strncmp(header->path, key.path, sizeof(key.path)) == 0 &&
+                 header->width > 0 && header->height > 0 &&
+                 header->data_offset >= sizeof(*header) &&
+                 header->data_offset + (uint64_t)header->width * header->height * 4 == (uint64_t)st.st_size;
+
+    if (!valid) {
+        if (map != MAP_FAILED) {
+            munmap(map, (size_t)st.st_size);
+        }
+        close(fd);
+        log_debug("Discarding unusable wallpaper cache entry %s", entry);
+        unlink(entry);
+        atomic_fetch_add(&cache_misses, 1);
+        return NULL;
+    }
+
+    /* Refresh the entry's age for LRU eviction */
+    futimens(fd, NULL);
+    close(fd);
+
+    struct image_data *img = calloc(1, sizeof(struct image_data));
+    if (!img) {
+        munmap(map, (size_t)st.st_size);
+        atomic_fetch_add(&cache_misses, 1);
+        return NULL;
+    }
+    img->pixels = (uint8_t *)map + header->data_offset;
+    img->mapping = map;
+    img->mapping_size = (size_t)st.st_size;
+    img->width = header->width;
+    img->height = header->height;
+    img->channels = 4;
+    img->format = (enum image_format)header->format;
+    snprintf(img->path, sizeof(img->path), "%s", path);
+
+    /* The whole image is about to be uploaded */
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+    atomic_fetch_add(&cache_hits, 1);
+    log_debug("Mapped %ux%u wallpaper for %s from disk cache", img->width, img->height, path);
+    return img;
+}
+
+static int compare_entry_age(const void *a, const void *b) {
+    const struct cache_entry *ea = a, *eb = b;
+    if (ea->mtime.tv_sec != eb->mtime.tv_sec) {
+        return ea->mtime.tv_sec < eb->mtime.tv_sec ? -1 : 1;
+    }
+    if (ea->mtime.tv_nsec != eb->mtime.tv_nsec) {
+        return ea->mtime.tv_nsec < eb->mtime.tv_nsec ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Delete least recently used entries until the directory fits the limit
+ * (called with disk_cache_lock held) */
+static void evict_entries(void) {
+    DIR *dir = opendir(cache_dir);
+    if (!dir) {
+        return;
+    }
+
+    struct cache_entry *entries = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t total = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len < 5 || len >= sizeof(entries->name) || strcmp(de->d_name + len - 5, ".rgba") != 0) {
+            continue;
+        }
+        struct stat st;
+        if (fstatat(dirfd(dir), de->d_name, &st, 0) != 0) {
+            continue;
+        }
+        if (count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 64;
+            struct cache_entry *grown = realloc(entries, new_capacity * sizeof(*entries));
+            if (!grown) {
+                break;
+            }
+            entries = grown;
+            capacity = new_capacity;
+        }
+        snprintf(entries[count].name, sizeof(entries[count].name), "%s", de->d_name);
+        entries[count].size = st.st_size;
+        entries[count].mtime = st.st_mtim;
+        total += (uint64_t)st.st_size;
+        count++;
+    }
+
+    uint64_t limit = (uint64_t)IMAGE_CACHE_MAX_MB * 1024 * 1024;
+    if (total > limit) {
+        qsort(entries, count, sizeof(*entries), compare_entry_age);
+        for (size_t i = 0; i < count && total > limit; i++) {
+            if (unlinkat(dirfd(dir), entries[i].name, 0) == 0) {
+                total -= (uint64_t)entries[i].size;
+                log_debug("Evicted wallpaper cache entry %s", entries[i].name);
+            }
+        }
+    }
+
+    free(entries);
+    closedir(dir);
+}
+
+void image_disk_cache_store(const char *path, int32_t display_width, int32_t display_height,
+                            enum wallpaper_mode mode, const struct image_data *img) {
+    if (!path || !img || !img->pixels || img->channels != 4 ||
+        display_width <= 0 || display_height <= 0 || !disk_cache_init()) {
+        return;
+    }
+
+    size_t data_size = (size_t)img->width * img->height * 4;
+    if (data_size > (uint64_t)IMAGE_CACHE_MAX_MB * 1024 * 1024 / 2) {
+        return;  /* Would evict most of the cache on its own */
+    }
+
+    struct image_cache_header header;
+    if (!fill_key(&header, path, display_width, display_height, mode)) {
+        return;
+    }
+    header.width = img->width;
+    header.height = img->height;
+    header.format = (uint32_t)img->format;
+    header.data_offset = (sizeof(header) + IMAGE_CACHE_ALIGN - 1) / IMAGE_CACHE_ALIGN * IMAGE_CACHE_ALIGN;
+
+    char entry[MAX_PATH_LENGTH + 32];
+    char tmp_path[MAX_PATH_LENGTH + 16];
+    entry_path(entry, sizeof(entry), header.key_hash);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp-XXXXXX", cache_dir);
+
+    /* Write to a temp file and rename so readers never see a partial entry */
+    int fd = mkstemp(tmp_path);
+    FILE *fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!fp) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        return;
+    }
+
+    static const char zeros[IMAGE_CACHE_ALIGN];
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              (header.data_offset == sizeof(header) ||
+               fwrite(zeros, header.data_offset - sizeof(header), 1, fp) == 1) &&
+              fwrite(img->pixels, data_size, 1, fp) == 1;
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok || rename(tmp_path, entry) != 0) {
+        log_debug("Failed to write wallpaper cache entry %s", entry);
+        unlink(tmp_path);
+        return;
+    }
+    log_debug("Stored %ux%u wallpaper for %s in %s", img->width, img->height, path, entry);
+
+    pthread_mutex_lock(&disk_cache_lock);
+    evict_entries();
+    pthread_mutex_unlock(&disk_cache_lock);
+}
+
+/* Deferred store of a private copy, run on the decode pool */
+struct cache_fill {
+    char path[MAX_PATH_LENGTH];
+    int32_t display_width;
+    int32_t display_height;
+    enum wallpaper_mode mode;
+    struct image_data *img;
+};
+
+static void cache_fill_discard(void *arg) {
+    struct cache_fill *fill = arg;
+    image_free(fill->img);
+    free(fill);
+}
+
+static void cache_fill_run(void *arg, const atomic_bool_t *cancelled) {
+    struct cache_fill *fill = arg;
+    if (!atomic_load(cancelled)) {
+        image_disk_cache_store(fill->path, fill->display_width, fill->display_height,
+                               fill->mode, fill->img);
+    }
+    cache_fill_discard(fill);
+}
+
+void image_disk_cache_store_async(const char *path, int32_t display_width, int32_t display_height,
+                                  enum wallpaper_mode mode, const struct image_data *img) {
+    if (!path || !img || !img->pixels || img->channels != 4) {
+        return;
+    }
+    /* No pixel copy when there is nowhere to write it */
+    if (!disk_cache_init()) {
+        return;
+    }
+
+    size_t data_size = (size_t)img->width * img->height * 4;
+    struct cache_fill *fill = calloc(1, sizeof(*fill));
+    struct image_data *copy = calloc(1, sizeof(*copy));
+    uint8_t *pixels = malloc(data_size);
+    if (!fill || !copy || !pixels) {
+        free(fill);
+        free(copy);
+        free(pixels);
+        image_disk_cache_store(path, display_width, display_height, mode, img);
+        return;
+    }
+
+    memcpy(pixels, img->pixels, data_size);
+    *copy = (struct image_data){
+        .pixels = pixels,
+        .width = img->width,
+        .height = img->height,
+        .channels = img->channels,
+        .format = img->format,
+    };
+    memcpy(copy->path, img->path, sizeof(copy->path));
+    strncpy(fill->path, path, sizeof(fill->path) - 1);
+    fill->display_width = display_width;
+    fill->display_height = display_height;
+    fill->mode = mode;
+    fill->img = copy;
+
+    char key[DECODE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "%dx%d/%d/%s", display_width, display_height, (int)mode, path);
+
+    struct decode_request request = {
+        .owner = NULL,
+        .priority = DECODE_PRIORITY_IDLE,
+        .key = key,
+        .run = cache_fill_run,
+        .discard = cache_fill_discard,
+        .arg = fill,
+    };
+    if (!decode_pool_submit(&request)) {
+        /* No workers (startup or shutdown): the copy is gone, write inline */
+        image_disk_cache_store(path, display_width, display_height, mode, img);
+    }
+}
+
+void image_disk_cache_get_stats(unsigned long *hits, unsigned long *misses) {
+    *hits = atomic_load(&cache_hits);
+    *misses = atomic_load(&cache_misses);
+}
@@ -0,0 +1,648 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "neowall.h"
+#include "constants.h"
+#include "image_scale.h"
+#include "parallel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_SCALE_SSE2 1
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define IMAGE_SCALE_AVX2 1
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define IMAGE_SCALE_NEON 1
+#endif
+
+#define SCALE_BITS  14                      /* Fixed-point weight precision */
+#define SCALE_ROUND (1 << (SCALE_BITS - 1))
+#define SCALE_PI    3.14159265358979323846
+
+/* Per-axis resampling table: output pixel i reads count[i] source pixels from
+ * start[i] with weights[i * ksize ...] (sum = 1 << SCALE_BITS) */
+struct scale_coeffs {
+    uint32_t *start;
+    uint32_t *count;
+    int16_t *weights;
+    uint32_t ksize;
+};
+
+typedef void (*hpass_fn)(const uint8_t *src_row, uint8_t *dst_row, uint32_t dst_width,
+                         const struct scale_coeffs *c);
+/* rows[k] is the source row for tap k */
+typedef void (*vpass_fn)(const uint8_t *const *rows, uint8_t *dst_row, size_t row_bytes,
+                         uint32_t count, const int16_t *weights);
+
+struct scale_backend {
+    const char *name;
+    hpass_fn hpass;
+    vpass_fn vpass;
+};
+
+/* ---------------------------------------------------------------------------
+ * Kernels and coefficient tables
+ * ------------------------------------------------------------------------- */
+
+static double kernel_box(double x) {
+    return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+}
+
+static double kernel_triangle(double x) {
+    if (x < 0.0) {
+        x = -x;
+    }
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+static double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= SCALE_PI;
+    return sin(x) / x;
+}
+
+static double kernel_lanczos3(double x) {
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+/* Safe to call again: a failed coeffs_build() leaves the table freed */
+static void coeffs_free(struct scale_coeffs *c) {
+    free(c->start);
+    free(c->count);
+    free(c->weights);
+    c->start = NULL;
+    c->count = NULL;
+    c->weights = NULL;
+}
+
+/* Table for output pixels [first, first + n) of an in_size -> out_size resize */
+static bool coeffs_build(struct scale_coeffs *c, uint32_t in_size, uint32_t out_size,
+                         uint32_t first, uint32_t n, enum image_scale_filter filter) {
+    double (*kernel)(double) = kernel_triangle;
+    double support = 1.0;
+    if (filter == IMAGE_SCALE_AREA) {
+        kernel = kernel_box;
+        support = 0.5;
+    } else if (filter == IMAGE_SCALE_LANCZOS3) {
+        kernel = kernel_lanczos3;
+        support = 3.0;
+    }
+
+    /* Widen the kernel when shrinking so it covers every source pixel */
+    double scale = (double)in_size / (double)out_size;
+    double filter_scale = scale < 1.0 ? 1.0 : scale;
+    support *= filter_scale;
+
+    c->ksize = (uint32_t)ceil(support) * 2 + 1;
+    c->start = malloc(n * sizeof(uint32_t));
+    c->count = malloc(n * sizeof(uint32_t));
+    c->weights = calloc((size_t)n * c->ksize, sizeof(int16_t));
+    double *k = malloc(c->ksize * sizeof(double));
+    if (!c->start || !c->count || !c->weights || !k) {
+        free(k);
+        coeffs_free(c);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        double center = (first + i + 0.5) * scale;
+        int64_t lo = (int64_t)(center - support + 0.5);
+        int64_t hi = (int64_t)(center + support + 0.5);
+        if (lo < 0) {
+            lo = 0;
+        }
+        if (hi > (int64_t)in_size) {
+            hi = in_size;
+        }
+        uint32_t taps = (uint32_t)(hi - lo);
+        if (taps > c->ksize) {
+            taps = c->ksize;
+        }
+
+        double total = 0.0;
+        for (uint32_t x = 0; x < taps; x++) {
+            k[x] = kernel(((double)(lo + x) - center + 0.5) / filter_scale);
+            total += k[x];
+        }
+
+        int16_t *w = c->weights + (size_t)i * c->ksize;
+        for (uint32_t x = 0; x < taps; x++) {
+            double v = (total != 0.0 ? k[x] / total : 0.0) * (1 << SCALE_BITS);
+            w[x] = (int16_t)(v < 0.0 ? v - 0.5 : v + 0.5);
+        }
+        c->start[i] = (uint32_t)lo;
+        c->count[i] = taps;
+    }
+
+    free(k);
+    return true;
+}
+
+static inline uint8_t clamp_fixed(int32_t v) {
+    v >>= SCALE_BITS;
+    return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)v);
+}
+
+/* ---------------------------------------------------------------------------
+ * Portable C
+ * ------------------------------------------------------------------------- */
+
+static void hpass_c(const uint8_t *src_row, uint8_t *dst_row, uint32_t dst_width,
+                    const struct scale_coeffs *c) {
+    for (uint32_t x = 0; x < dst_width; x++) {
+        const uint8_t *p = src_row + (size_t)c->start[x] * 4;
+        const int16_t *w = c->weights + (size_t)x * c->ksize;
+        int32_t r = SCALE_ROUND, g = SCALE_ROUND, b = SCALE_ROUND, a = SCALE_ROUND;
+        for (uint32_t k = 0; k < c->count[x]; k++) {
+            r += p[k * 4 + 0] * w[k];
+            g += p[k * 4 + 1] * w[k];
+            b += p[k * 4 + 2] * w[k];
+            a += p[k * 4 + 3] * w[k];
+        }
+        dst_row[x * 4 + 0] = clamp_fixed(r);
+        dst_row[x * 4 + 1] = clamp_fixed(g);
+        dst_row[x * 4 + 2] = clamp_fixed(b);
+        dst_row[x * 4 + 3] = clamp_fixed(a);
+    }
+}
+
+/* Bytes [from, row_bytes) of a vertical pass */
+static void vpass_c_range(const uint8_t *const *rows, uint8_t *dst_row, size_t from,
+                          size_t row_bytes, uint32_t count, const int16_t *weights) {
+    for (size_t i = from; i < row_bytes; i += 16) {
+        size_t n = row_bytes - i < 16 ? row_bytes - i : 16;
+        int32_t acc[16];
+        for (size_t j = 0; j < n; j++) {
+            acc[j] = SCALE_ROUND;
+        }
+        for (uint32_t k = 0; k < count; k++) {
+            const uint8_t *p = rows[k] + i;
+            for (size_t j = 0; j < n; j++) {
+                acc[j] += p[j] * weights[k];
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            dst_row[i + j] = clamp_fixed(acc[j]);
+        }
+    }
+}
+
+static void vpass_c(const uint8_t *const *rows, uint8_t *dst_row, size_t row_bytes,
+                    uint32_t count, const int16_t *weights) {
+    vpass_c_range(rows, dst_row, 0, row_bytes, count, weights);
+}
+
+/* ---------------------------------------------------------------------------
+ * SSE2 / AVX2
+ *
+ * Taps are processed in pairs: pixels of two taps are interleaved as 16-bit
+ * values and multiplied by the interleaved weight pair with pmaddwd, giving
+ * 32-bit sums per channel in one instruction.
+ * ------------------------------------------------------------------------- */
+
+#ifdef IMAGE_SCALE_SSE2
+static inline int32_t weight_pair(int16_t w0, int16_t w1) {
+    return (int32_t)(((uint32_t)(uint16_t)w1 << 16) | (uint16_t)w0);
+}
+
+static void hpass_sse2(const uint8_t *src_row, uint8_t *dst_row, uint32_t dst_width,
+                       const struct scale_coeffs *c) {
+    const __m128i zero = _mm_setzero_si128();
+    for (uint32_t x = 0; x < dst_width; x++) {
+        const uint8_t *p = src_row + (size_t)c->start[x] * 4;
+        const int16_t *w = c->weights + (size_t)x * c->ksize;
+        uint32_t count = c->count[x];
+        __m128i acc = _mm_set1_epi32(SCALE_ROUND);
+        uint32_t k = 0;
+        for (; k + 3 < count; k += 4) {
+            __m128i px = _mm_loadu_si128((const __m128i *)(p + k * 4));
+            __m128i lo = _mm_unpacklo_epi8(px, zero), hi = _mm_unpackhi_epi8(px, zero);
+            lo = _mm_unpacklo_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_unpacklo_epi16(hi, _mm_srli_si128(hi, 8));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, _mm_set1_epi32(weight_pair(w[k], w[k + 1]))));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, _mm_set1_epi32(weight_pair(w[k + 2], w[k + 3]))));
+        }
+        for (; k + 1 < count; k += 2) {
+            /* r0 g0 b0 a0 r1 g1 b1 a1 -> r0 r1 g0 g1 b0 b1 a0 a1 */
+            __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p + k * 4)), zero);
+            px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(weight_pair(w[k], w[k + 1]))));
+        }
+        if (k < count) {
+            int32_t word;
+            memcpy(&word, p + k * 4, 4);
+            __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(word), zero);
+            px = _mm_unpacklo_epi16(px, zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(weight_pair(w[k], 0))));
+        }
+        acc = _mm_srai_epi32(acc, SCALE_BITS);
+        acc = _mm_packs_epi32(acc, acc);
+        int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+        memcpy(dst_row + (size_t)x * 4, &out, 4);
+    }
+}
+
+/* Bytes [from, row_bytes) of a vertical pass */
+static void vpass_sse2_from(const uint8_t *const *rows, uint8_t *dst_row, size_t from,
+                            size_t row_bytes, uint32_t count, const int16_t *weights) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = from;
+    for (; i + 16 <= row_bytes; i += 16) {
+        __m128i acc0 = _mm_set1_epi32(SCALE_ROUND), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (uint32_t k = 0; k < count; k += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i b = zero;
+            int16_t w1 = 0;
+            if (k + 1 < count) {
+                b = _mm_loadu_si128((const __m128i *)(rows[k + 1] + i));
+                w1 = weights[k + 1];
+            }
+            __m128i w = _mm_set1_epi32(weight_pair(weights[k], w1));
+            __m128i a_lo = _mm_unpacklo_epi8(a, zero), a_hi = _mm_unpackhi_epi8(a, zero);
+            __m128i b_lo = _mm_unpacklo_epi8(b, zero), b_hi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), w));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), w));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), w));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), w));
+        }
+        __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, SCALE_BITS), _mm_srai_epi32(acc1, SCALE_BITS));
+        __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, SCALE_BITS), _mm_srai_epi32(acc3, SCALE_BITS));
+        _mm_storeu_si128((__m128i *)(dst_row + i), _mm_packus_epi16(lo, hi));
+    }
+    vpass_c_range(rows, dst_row, i, row_bytes, count, weights);
+}
+
+static void vpass_sse2(const uint8_t *const *rows, uint8_t *dst_row, size_t row_bytes,
+                       uint32_t count, const int16_t *weights) {
+    vpass_sse2_from(rows, dst_row, 0, row_bytes, count, weights);
+}
+#endif /* IMAGE_SCALE_SSE2 */
+
+#if defined(IMAGE_SCALE_SSE2) && defined(IMAGE_SCALE_AVX2)
+/* Same as vpass_sse2 on 32 bytes; unpack and pack both work per 128-bit lane,
+ * so the byte order comes back unchanged */
+__attribute__((target("avx2")))
+static void vpass_avx2(const uint8_t *const *rows, uint8_t *dst_row, size_t row_bytes,
+                       uint32_t count, const int16_t *weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= row_bytes; i += 32) {
+        __m256i acc0 = _mm256_set1_epi32(SCALE_ROUND), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (uint32_t k = 0; k < count; k += 2) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(rows[k] + i));
+            __m256i b = zero;
+            int16_t w1 = 0;
+            if (k + 1 < count) {
+                b = _mm256_loadu_si256((const __m256i *)(rows[k + 1] + i));
+                w1 = weights[k + 1];
+            }
+            __m256i w = _mm256_set1_epi32(weight_pair(weights[k], w1));
+            __m256i a_lo = _mm256_unpacklo_epi8(a, zero), a_hi = _mm256_unpackhi_epi8(a, zero);
+            __m256i b_lo = _mm256_unpacklo_epi8(b, zero), b_hi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_lo, b_lo), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_lo, b_lo), w));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(a_hi, b_hi), w));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(a_hi, b_hi), w));
+        }
+        __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(acc0, SCALE_BITS), _mm256_srai_epi32(acc1, SCALE_BITS));
+        __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(acc2, SCALE_BITS), _mm256_srai_epi32(acc3, SCALE_BITS));
+        _mm256_storeu_si256((__m256i *)(dst_row + i), _mm256_packus_epi16(lo, hi));
+    }
+    if (i < row_bytes) {
+        vpass_sse2_from(rows, dst_row, i, row_bytes, count, weights);
+    }
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+ * NEON
+ * ------------------------------------------------------------------------- */
+
+#ifdef IMAGE_SCALE_NEON
+static void hpass_neon(const uint8_t *src_row, uint8_t *dst_row, uint32_t dst_width,
+                       const struct scale_coeffs *c) {
+    for (uint32_t x = 0; x < dst_width; x++) {
+        const uint8_t *p = src_row + (size_t)c->start[x] * 4;
+        const int16_t *w = c->weights + (size_t)x * c->ksize;
+        int32x4_t acc = vdupq_n_s32(SCALE_ROUND);
+        for (uint32_t k = 0; k < c->count[x]; k++) {
+            uint32_t word;
+            memcpy(&word, p + k * 4, 4);
+            int16x4_t px = vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(word)))));
+            acc = vmlal_n_s16(acc, px, w[k]);
+        }
+        int16x4_t narrow = vqshrn_n_s32(acc, SCALE_BITS);
+        uint8x8_t out = vqmovun_s16(vcombine_s16(narrow, narrow));
+        vst1_lane_u32((uint32_t *)(void *)(dst_row + (size_t)x * 4), vreinterpret_u32_u8(out), 0);
+    }
+}
+
+static void vpass_neon(const uint8_t *const *rows, uint8_t *dst_row, size_t row_bytes,
+                       uint32_t count, const int16_t *weights) {
+    size_t i = 0;
+    for (; i + 16 <= row_bytes; i += 16) {
+        int32x4_t acc0 = vdupq_n_s32(SCALE_ROUND), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (uint32_t k = 0; k < count; k++) {
+            uint8x16_t px = vld1q_u8(rows[k] + i);
+            int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px)));
+            int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px)));
+            acc0 = vmlal_n_s16(acc0, vget_low_s16(lo), weights[k]);
+            acc1 = vmlal_n_s16(acc1, vget_high_s16(lo), weights[k]);
+            acc2 = vmlal_n_s16(acc2, vget_low_s16(hi), weights[k]);
+            acc3 = vmlal_n_s16(acc3, vget_high_s16(hi), weights[k]);
+        }
+        int16x8_t lo = vcombine_s16(vqshrn_n_s32(acc0, SCALE_BITS), vqshrn_n_s32(acc1, SCALE_BITS));
+        int16x8_t hi = vcombine_s16(vqshrn_n_s32(acc2, SCALE_BITS), vqshrn_n_s32(acc3, SCALE_BITS));
+        vst1q_u8(dst_row + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    vpass_c_range(rows, dst_row, i, row_bytes, count, weights);
+}
+#endif /* IMAGE_SCALE_NEON */
+
+/* ---------------------------------------------------------------------------
+ * Dispatch
+ * ------------------------------------------------------------------------- */
+
+static struct scale_backend backend = { "c", hpass_c, vpass_c };
+static pthread_once_t backend_once = PTHREAD_ONCE_INIT;
+
+static void backend_select(void) {
+#ifdef IMAGE_SCALE_NEON
+    backend = (struct scale_backend){ "neon", hpass_neon, vpass_neon };
+#endif
+#ifdef IMAGE_SCALE_SSE2
+    backend = (struct scale_backend){ "sse2", hpass_sse2, vpass_sse2 };
+#ifdef IMAGE_SCALE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        backend = (struct scale_backend){ "avx2", hpass_sse2, vpass_avx2 };
+    }
+#endif
+#endif
+}
+
+const char *image_scale_backend(void) {
+    pthread_once(&backend_once, backend_select);
+    return backend.name;
+}
+
+enum image_scale_filter image_scale_pick_filter(uint32_t src_width, uint32_t src_height,
+                                                uint32_t dst_width, uint32_t dst_height) {
+    if (dst_width >= src_width && dst_height >= src_height) {
+        return IMAGE_SCALE_BILINEAR;
+    }
+    if ((uint64_t)src_width >= (uint64_t)dst_width * 2 && (uint64_t)src_height >= (uint64_t)dst_height * 2) {
+        return IMAGE_SCALE_AREA;
+    }
+    return IMAGE_SCALE_LANCZOS3;
+}
+
+struct scale_job {
+    const uint8_t *src;
+    size_t src_stride;
+    uint8_t *dst;
+    ptrdiff_t dst_stride;       /* Negative for bottom-up output */
+    uint32_t width;             /* Output pixels per row */
+    uint32_t crop_x;            /* Region origin in the scaled image */
+    uint32_t crop_y;
+    bool scale_x;
+    bool scale_y;
+    struct scale_coeffs cx;     /* Indexed by region column */
+    struct scale_coeffs cy;     /* Indexed by region row */
+    atomic_bool_t failed;
+};
+
+/* Output rows [row_begin, row_end) of the region */
+static void scale_band(void *ctx, uint32_t row_begin, uint32_t row_end) {
+    struct scale_job *job = ctx;
+    size_t row_bytes = (size_t)job->width * 4;
+
+    if (!job->scale_y) {
+        for (uint32_t y = row_begin; y < row_end; y++) {
+            const uint8_t *src_row = job->src + (size_t)(job->crop_y + y) * job->src_stride;
+            uint8_t *dst_row = job->dst + (ptrdiff_t)y * job->dst_stride;
+            if (job->scale_x) {
+                backend.hpass(src_row, dst_row, job->width, &job->cx);
+            } else {
+                memcpy(dst_row, src_row + (size_t)job->crop_x * 4, row_bytes);
+            }
+        }
+        return;
+    }
+
+    /* Horizontal pass over only the source rows this band reads */
+    const uint8_t *rows = job->src + (size_t)job->crop_x * 4;
+    size_t rows_stride = job->src_stride;
+    uint32_t first_row = 0;
+    uint8_t *tmp = NULL;
+    if (job->scale_x) {
+        first_row = job->cy.start[row_begin];
+        uint32_t last_row = first_row;
+        for (uint32_t y = row_begin; y < row_end; y++) {
+            uint32_t end = job->cy.start[y] + job->cy.count[y];
+            last_row = end > last_row ? end : last_row;
+        }
+        tmp = malloc((size_t)(last_row - first_row) * row_bytes);
+        if (!tmp) {
+            atomic_store(&job->failed, true);
+            return;
+        }
+        for (uint32_t y = first_row; y < last_row; y++) {
+            backend.hpass(job->src + (size_t)y * job->src_stride,
+                          tmp + (size_t)(y - first_row) * row_bytes, job->width, &job->cx);
+        }
+        rows = tmp;
+        rows_stride = row_bytes;
+    }
+
+    const uint8_t **taps = malloc(job->cy.ksize * sizeof(*taps));
+    if (!taps) {
+        atomic_store(&job->failed, true);
+        free(tmp);
+        return;
+    }
+    for (uint32_t y = row_begin; y < row_end; y++) {
+        for (uint32_t k = 0; k < job->cy.count[y]; k++) {
+            taps[k] = rows + (size_t)(job->cy.start[y] + k - first_row) * rows_stride;
+        }
+        backend.vpass(taps, job->dst + (ptrdiff_t)y * job->dst_stride, row_bytes,
+                      job->cy.count[y], job->cy.weights + (size_t)y * job->cy.ksize);
+    }
+    free(taps);
+    free(tmp);
+}
+
+bool image_scale_rgba_region(const uint8_t *src, uint32_t src_width, uint32_t src_height,
+                             uint32_t scaled_width, uint32_t scaled_height,
+                             uint32_t crop_x, uint32_t crop_y, uint32_t width, uint32_t height,
+                             uint8_t *dst, ptrdiff_t dst_stride, enum image_scale_filter filter) {
+    if (width == 0 || height == 0 ||
+        crop_x + width > scaled_width || crop_y + height > scaled_height) {
+        return false;
+    }
+
+    pthread_once(&backend_once, backend_select);
+
+    struct scale_job job = {
+        .src = src,
+        .src_stride = (size_t)src_width * 4,
+        .dst = dst,
+        .dst_stride = dst_stride,
+        .width = width,
+        .crop_x = crop_x,
+        .crop_y = crop_y,
+        .scale_x = scaled_width != src_width,
+        .scale_y = scaled_height != src_height,
+    };
+    atomic_init(&job.failed, false);
+
+    if ((job.scale_x && !coeffs_build(&job.cx, src_width, scaled_width, crop_x, width, filter)) ||
+        (job.scale_y && !coeffs_build(&job.cy, src_height, scaled_height, crop_y, height, filter))) {
+        coeffs_free(&job.cx);
+        coeffs_free(&job.cy);
+        return false;
+    }
+
+    parallel_bands(height, IMAGE_BAND_MIN_ROWS, scale_band, &job);
+
+    coeffs_free(&job.cx);
+    coeffs_free(&job.cy);
+    return !atomic_load(&job.failed);
+}
+
+bool image_scale_rgba(const uint8_t *src, uint32_t src_width, uint32_t src_height,
+                      uint8_t *dst, uint32_t dst_width, uint32_t dst_height,
+                      enum image_scale_filter filter) {
+    return image_scale_rgba_region(src, src_width, src_height, dst_width, dst_height,
+                                   0, 0, dst_width, dst_height, dst, (ptrdiff_t)dst_width * 4, filter);
+}
+
+struct image_scale_stream {
+    uint8_t *dst;
+    ptrdiff_t dst_stride;
+    uint32_t width;             /* Output pixels per row */
+    uint32_t height;            /* Output rows */
+    uint32_t crop_x;
+    uint32_t crop_y;
+    bool scale_x;
+    bool scale_y;
+    struct scale_coeffs cx;
+    struct scale_coeffs cy;
+    uint8_t *ring;              /* Horizontally resampled source rows, ring_rows slots */
+    uint32_t ring_rows;
+    const uint8_t **taps;
+    uint32_t src_row;           /* Source rows pushed so far */
+    uint32_t dst_row;           /* Output rows written so far */
+};
+
+struct image_scale_stream *image_scale_stream_create(uint32_t src_width, uint32_t src_height,
+                                                     uint32_t scaled_width, uint32_t scaled_height,
+                                                     uint32_t crop_x, uint32_t crop_y,
+                                                     uint32_t width, uint32_t height,
+                                                     uint8_t *dst, ptrdiff_t dst_stride,
+                                                     enum image_scale_filter filter) {
+    if (width == 0 || height == 0 ||
+        crop_x + width > scaled_width || crop_y + height > scaled_height) {
+        return NULL;
+    }
+
+    pthread_once(&backend_once, backend_select);
+
+    struct image_scale_stream *stream = calloc(1, sizeof(*stream));
+    if (!stream) {
+        return NULL;
+    }
+    stream->dst = dst;
+    stream->dst_stride = dst_stride;
+    stream->width = width;
+    stream->height = height;
+    stream->crop_x = crop_x;
+    stream->crop_y = crop_y;
+    stream->scale_x = scaled_width != src_width;
+    stream->scale_y = scaled_height != src_height;
+
+    if ((stream->scale_x && !coeffs_build(&stream->cx, src_width, scaled_width, crop_x, width, filter)) ||
+        (stream->scale_y && !coeffs_build(&stream->cy, src_height, scaled_height, crop_y, height, filter))) {
+        image_scale_stream_destroy(stream);
+        return NULL;
+    }
+
+    /* A pending output row never reaches further back than its own taps,
+     * so a ring of ksize rows is enough */
+    if (stream->scale_y) {
+        stream->ring_rows = stream->cy.ksize;
+        stream->ring = malloc((size_t)stream->ring_rows * width * 4);
+        stream->taps = malloc(stream->ring_rows * sizeof(*stream->taps));
+        if (!stream->ring || !stream->taps) {
+            image_scale_stream_destroy(stream);
+            return NULL;
+        }
+    }
+
+    return stream;
+}
+
+/* Resample or crop one source row to the output width */
+static void stream_row_h(const struct image_scale_stream *stream, const uint8_t *src_row, uint8_t *out) {
+    if (stream->scale_x) {
+        backend.hpass(src_row, out, stream->width, &stream->cx);
+    } else {
+        memcpy(out, src_row + (size_t)stream->crop_x * 4, (size_t)stream->width * 4);
+    }
+}
+
+void image_scale_stream_push(struct image_scale_stream *stream, const uint8_t *src_row) {
+    uint32_t r = stream->src_row++;
+    size_t row_bytes = (size_t)stream->width * 4;
+
+    if (!stream->scale_y) {
+        if (r >= stream->crop_y && r < stream->crop_y + stream->height) {
+            stream_row_h(stream, src_row, stream->dst + (ptrdiff_t)(r - stream->crop_y) * stream->dst_stride);
+            stream->dst_row++;
+        }
+        return;
+    }
+
+    /* Tap windows only move forward: rows before the next output's first tap
+     * are never needed again */
+    const struct scale_coeffs *cy = &stream->cy;
+    if (stream->dst_row >= stream->height || r < cy->start[stream->dst_row]) {
+        return;
+    }
+    stream_row_h(stream, src_row, stream->ring + (size_t)(r % stream->ring_rows) * row_bytes);
+
+    /* Emit every output row whose taps are now all available */
+    while (stream->dst_row < stream->height &&
+           cy->start[stream->dst_row] + cy->count[stream->dst_row] <= r + 1) {
+        uint32_t y = stream->dst_row++;
+        for (uint32_t k = 0; k < cy->count[y]; k++) {
+            stream->taps[k] = stream->ring + (size_t)((cy->start[y] + k) % stream->ring_rows) * row_bytes;
+        }
+        backend.vpass(stream->taps, stream->dst + (ptrdiff_t)y * stream->dst_stride, row_bytes,
+                      cy->count[y], cy->weights + (size_t)y * cy->ksize);
+    }
+}
+
+bool image_scale_stream_complete(const struct image_scale_stream *stream) {
+    return stream->dst_row == stream->height;
+}
+
+void image_scale_stream_destroy(struct image_scale_stream *stream) {
+    if (!stream) {
+        return;
+    }
+    coeffs_free(&stream->cx);
+    coeffs_free(&stream->cy);
+    free(stream->ring);
+    free(stream->taps);
+    free(stream);
+}
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "neowall.h"
+#include "constants.h"
+#include "decode_pool.h"
+#include "texture_compress.h"
+#include "lookahead.h"
+
+struct lookahead_entry {
+    char path[MAX_PATH_LENGTH];
+    int32_t display_width;
+    int32_t display_height;
+    enum wallpaper_mode mode;
+    struct image_data *image;       /* NULL while decoding */
+    bool failed;                    /* Decode failed; not retried while in the window */
+    size_t bytes;                   /* Estimate until decoded, then the image's size */
+    struct lookahead_entry *next;
+};
+
+/* Decode job for one window entry */
+struct lookahead_job {
+    struct output_state *output;
+    char path[MAX_PATH_LENGTH];
+    int32_t width;
+    int32_t height;
+    enum wallpaper_mode mode;
+    enum texture_compression compression;
+};
+
+static atomic_ulong lookahead_hits;
+
+/* Called with preload_mutex held */
+static struct lookahead_entry *find_entry(struct output_state *output, const char *path,
+                                          int32_t display_width, int32_t display_height,
+                                          enum wallpaper_mode mode) {
+    for (struct lookahead_entry *e = output->lookahead; e; e = e->next) {
+        if (e->display_width == display_width && e->display_height == display_height &&
+            e->mode == mode && strcmp(e->path, path) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Called with preload_mutex held */
+static void remove_entry(struct output_state *output, struct lookahead_entry *entry) {
+    for (struct lookahead_entry **link = &output->lookahead; *link; link = &(*link)->next) {
+        if (*link == entry) {
+            *link = entry->next;
+            break;
+        }
+    }
+    output->lookahead_bytes -= entry->bytes;
+    if (entry->image) {
+        image_free(entry->image);
+    }
+    free(entry);
+}
+
+static size_t image_bytes(const struct image_data *img) {
+    if (img->compressed) {
+        return img->compressed_size;
+    }
+    return (size_t)img->width * img->height * img->channels;
+}
+
+/* Upper bound for a display-ready image before it is decoded */
+static size_t estimate_bytes(int32_t width, int32_t height, enum texture_compression compression) {
+    size_t rgba = (size_t)width * (size_t)height * 4;
+    return compression != TEXTURE_COMPRESSION_NONE ? rgba / 8 : rgba;
+}
+
+static void lookahead_job_run(void *arg, const atomic_bool_t *cancelled) {
+    struct lookahead_job *job = arg;
+    struct output_state *output = job->output;
+
+    /* The cycle may have moved past the entry while the job was queued */
+    pthread_mutex_lock(&output->preload_mutex);
+    struct lookahead_entry *entry = find_entry(output, job->path, job->width, job->height,
+                                               job->mode);
+    bool wanted = entry && !entry->image && !entry->failed;
+    pthread_mutex_unlock(&output->preload_mutex);
+    if (!wanted || atomic_load(cancelled)) {
+        free(job);
+        return;
+    }
+
+    struct image_data *img = image_load(job->path, job->width, job->height, job->mode);
+    if (img && job->compression != TEXTURE_COMPRESSION_NONE && !atomic_load(cancelled)) {
+        texture_compress_etc2(img, job->compression);
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    entry = find_entry(output, job->path, job->width, job->height, job->mode);
+    if (entry && !entry->image && !atomic_load(cancelled)) {
+        if (img) {
+            output->lookahead_bytes -= entry->bytes;
+            entry->bytes = image_bytes(img);
+            output->lookahead_bytes += entry->bytes;
+            entry->image = img;
+            img = NULL;
+            log_debug("Lookahead: decoded %s (%zu KB in window)", job->path,
+                      output->lookahead_bytes / 1024);
+        } else {
+            log_error("Lookahead: failed to decode image: %s", job->path);
+            entry->failed = true;
+        }
+    }
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    if (img) {
+        image_free(img);
+    }
+    free(job);
+}
+
+/* Start reading an entry that doesn't fit the budget into the page cache */
+static void readahead_job_run(void *arg, const atomic_bool_t *cancelled) {
+    char *path = arg;
+    if (!atomic_load(cancelled)) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+    }
+    free(path);
+}
+
+static void submit_decode(struct output_state *output, const char *path,
+                          enum texture_compression compression) {
+    struct lookahead_job *job = malloc(sizeof(*job));
+    if (!job) {
+        log_error("Failed to allocate lookahead job");
+        return;
+    }
+    job->output = output;
+    memcpy(job->path, path, sizeof(job->path));
+    job->width = output->width;
+    job->height = output->height;
+    job->mode = output->config->mode;
+    job->compression = compression;
+
+    char key[DECODE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "%dx%d/%d/%s", job->width, job->height, (int)job->mode, job->path);
+
+    struct decode_request request = {
+        .owner = output,
+        .priority = DECODE_PRIORITY_LOOKAHEAD,
+        .key = key,
+        .run = lookahead_job_run,
+        .discard = free,
+        .arg = job,
+    };
+    decode_pool_submit(&request);
+}
+
+static void submit_readahead(struct output_state *output, const char *path) {
+    char *copy = strdup(path);
+    if (!copy) {
+        return;
+    }
+
+    char key[DECODE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "readahead/%s", path);
+
+    struct decode_request request = {
+        .owner = output,
+        .priority = DECODE_PRIORITY_LOOKAHEAD,
+        .key = key,
+        .run = readahead_job_run,
+        .discard = free,
+        .arg = copy,
+    };
+    decode_pool_submit(&request);
+}
+
+void lookahead_update(struct output_state *output) {
+    if (!output || !output->config || !output->state) {
+        return;
+    }
+
+    struct wallpaper_config *config = output->config;
+    size_t depth = config->preload_count > 1 ? (size_t)config->preload_count : 0;
+    if (config->type != WALLPAPER_IMAGE || !config->cycle || config->cycle_count <= 2 ||
+        output->width <= 0 || output->height <= 0) {
+        depth = 0;
+    }
+    /* Each entry at most once, never the one on screen */
+    if (depth > config->cycle_count - 1) {
+        depth = config->cycle_count - 1;
+    }
+    if (depth == 0) {
+        lookahead_clear(output);
+        return;
+    }
+
+    /* window[0] is the next entry: kept if decoded (the preload takes it) but
+     * not scheduled here, the regular preload handles it */
+    char (*window)[MAX_PATH_LENGTH] = calloc(depth, MAX_PATH_LENGTH);
+    if (!window) {
+        log_error("Failed to allocate lookahead window");
+        return;
+    }
+    pthread_mutex_lock(&output->state->state_mutex);
+    if (!config->cycle_paths) {
+        pthread_mutex_unlock(&output->state->state_mutex);
+        free(window);
+        return;
+    }
+    for (size_t k = 0; k < depth; k++) {
+        size_t index = (config->current_cycle_index + 1 + k) % config->cycle_count;
+        strncpy(window[k], config->cycle_paths[index], MAX_PATH_LENGTH - 1);
+    }
+    pthread_mutex_unlock(&output->state->state_mutex);
+
+    int32_t width = output->width;
+    int32_t height = output->height;
+    enum wallpaper_mode mode = config->mode;
+    /* ETC2 sampling is only guaranteed from ES 3.0 */
+    enum texture_compression compression =
+        output->state->gl_caps.gles_version >= GLES_VERSION_3_0 ?
+        config->texture_compression : TEXTURE_COMPRESSION_NONE;
+    size_t budget = (size_t)config->preload_budget_mb * 1024 * 1024;
+
+    bool *decode = calloc(depth, sizeof(bool));
+    bool *readahead = calloc(depth, sizeof(bool));
+    if (!decode || !readahead) {
+        log_error("Failed to allocate lookahead window");
+        free(decode);
+        free(readahead);
+        free(window);
+        return;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+
+    /* Drop entries the cycle moved past or prepared for another size or mode */
+    struct lookahead_entry *entry = output->lookahead;
+    while (entry) {
+        struct lookahead_entry *next = entry->next;
+        bool in_window = false;
+        if (entry->display_width == width && entry->display_height == height &&
+            entry->mode == mode) {
+            for (size_t k = 0; k < depth && !in_window; k++) {
+                in_window = strcmp(entry->path, window[k]) == 0;
+            }
+        }
+        if (!in_window) {
+            remove_entry(output, entry);
+        }
+        entry = next;
+    }
+
+    /* Reserve the budget nearest first; what doesn't fit is only read ahead */
+    for (size_t k = 1; k < depth; k++) {
+        if (find_entry(output, window[k], width, height, mode)) {
+            continue;
+        }
+        size_t bytes = estimate_bytes(width, height, compression);
+        if (output->lookahead_bytes + bytes > budget) {
+            readahead[k] = true;
+            continue;
+        }
+        struct lookahead_entry *added = calloc(1, sizeof(*added));
+        if (!added) {
+            break;
+        }
+        memcpy(added->path, window[k], sizeof(added->path));
+        added->display_width = width;
+        added->display_height = height;
+        added->mode = mode;
+        added->bytes = bytes;
+        added->next = output->lookahead;
+        output->lookahead = added;
+        output->lookahead_bytes += bytes;
+        decode[k] = true;
+    }
+
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    /* Queued in window order: nearer entries are decoded first */
+    for (size_t k = 1; k < depth; k++) {
+        if (decode[k]) {
+            submit_decode(output, window[k], compression);
+        } else if (readahead[k]) {
+            submit_readahead(output, window[k]);
+        }
+    }
+
+    free(decode);
+    free(readahead);
+    free(window);
+}
+
+struct image_data *lookahead_take(struct output_state *output, const char *path,
+                                  int32_t display_width, int32_t display_height,
+                                  enum wallpaper_mode mode) {
+    if (!output || !path) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    struct lookahead_entry *entry = find_entry(output, path, display_width, display_height, mode);
+    struct image_data *img = NULL;
+    if (entry && entry->image) {
+        img = entry->image;
+        entry->image = NULL;
+        remove_entry(output, entry);
+    }
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    if (img) {
+        atomic_fetch_add(&lookahead_hits, 1);
+        log_debug("Lookahead: using decoded %s", path);
+    }
+    return img;
+}
+
+void lookahead_clear(struct output_state *output) {
+    if (!output) {
+        return;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    while (output->lookahead) {
+        remove_entry(output, output->lookahead);
+    }
+    pthread_mutex_unlock(&output->preload_mutex);
+}
+
+void lookahead_get_stats(unsigned long *hits) {
+    *hits = atomic_load(&lookahead_hits);
+}
@@ -14,6 +14,12 @@
 #include "config_access.h"
 #include "constants.h"
 #include "egl/egl_core.h"
+#include "gl_debug.h"
+#include "shader.h"
+#include "shader_compiler.h"
+#include "texture_uploader.h"
+#include "parallel.h"
+#include "decode_pool.h"
 
 static struct neowall_state *global_state = NULL;
 
@@ -307,6 +313,8 @@ static void print_usage(const char *program_name) {
     printf("  -c, --config PATH     Path to configuration file\n");
     printf("  -f, --foreground      Run in foreground (for debugging)\n");
     printf("  -w, --watch           Watch config file for changes and reload\n");
+    printf("  -t, --threaded-render Render each output on its own thread\n");
+    printf("  -g, --gl-debug        Check GL errors every frame (slower)\n");
     printf("  -v, --verbose         Enable verbose logging\n");
     printf("  -h, --help            Show this help message\n");
     printf("  -V, --version         Show version information\n");
@@ -672,6 +680,8 @@ int main(int argc, char *argv[]) {
     char config_path[MAX_PATH_LENGTH] = {0};
     bool daemon_mode = true;  /* Default to daemon mode */
     bool watch_config = false;  /* Only enable when -w flag is provided */
+    bool threaded_render = false;  /* One render thread per output (-t) */
+    bool gl_debug = false;         /* Per-frame GL error checks (-g) */
     bool verbose = false;
     int opt;
 
@@ -718,6 +728,8 @@ int main(int argc, char *argv[]) {
         {"config",     required_argument, 0, 'c'},
         {"foreground", no_argument,       0, 'f'},
         {"watch",      no_argument,       0, 'w'},
+        {"threaded-render", no_argument,  0, 't'},
+        {"gl-debug",   no_argument,       0, 'g'},
         {"verbose",    no_argument,       0, 'v'},
         {"help",       no_argument,       0, 'h'},
         {"version",    no_argument,       0, 'V'},
@@ -725,7 +737,7 @@ int main(int argc, char *argv[]) {
     };
 
     /* Parse command line arguments */
-    while ((opt = getopt_long(argc, argv, "c:fwvhV", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:fwtgvhV", long_options, NULL)) != -1) {
         switch (opt) {
             case 'c':
                 strncpy(config_path, optarg, sizeof(config_path) - 1);
@@ -736,6 +748,12 @@ int main(int argc, char *argv[]) {
             case 'w':
                 watch_config = true;
                 break;
+            case 't':
+                threaded_render = true;
+                break;
+            case 'g':
+                gl_debug = true;
+                break;
             case 'v':
                 /* Verbose mode - enable debug logging */
                 verbose = true;
@@ -819,6 +837,12 @@ int main(int argc, char *argv[]) {
     atomic_init(&state.outputs_need_init, false);
     atomic_init(&state.next_requested, 0);
     state.watch_config = watch_config;
+    state.threaded_render = threaded_render;
+    if (gl_debug) {
+        gl_debug_set_enabled(true);
+    }
+    /* Render threads set uniforms concurrently - each output keeps its own programs */
+    shader_cache_set_enabled(!threaded_render);
     state.timer_fd = -1;
     state.wakeup_fd = -1;
     strncpy(state.config_path, config_path, sizeof(state.config_path) - 1);
@@ -852,9 +876,22 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
+    /* Shader cycling compiles on a worker context; without one it compiles inline */
+    shader_compiler_start(&state);
+
+    /* Preloaded wallpapers upload on a worker context; without one they upload inline */
+    texture_uploader_start(&state);
+
+    /* Preloads and cache fills decode on low-priority workers shared by all outputs */
+    decode_pool_start();
+
     /* Load configuration and apply to outputs */
     if (!config_load(&state, config_path)) {
         log_error("Failed to load configuration");
+        decode_pool_stop();
+        texture_uploader_stop();
+        shader_compiler_stop();
+        parallel_shutdown();
         egl_core_cleanup(&state);
         wayland_cleanup(&state);
         return EXIT_FAILURE;
@@ -887,6 +924,10 @@ int main(int argc, char *argv[]) {
     }
 
     /* Quick cleanup - don't spend too much time on this during shutdown */
+    decode_pool_stop();
+    texture_uploader_stop();
+    shader_compiler_stop();
+    parallel_shutdown();
     egl_core_cleanup(&state);
     wayland_cleanup(&state);
     
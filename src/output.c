@@ -5,9 +5,18 @@
 #include <sys/stat.h>
 #include "neowall.h"
 #include "compositor.h"
+#include "render_thread.h"
 #include "config_access.h"
 #include "constants.h"
 #include "shader.h"
+#include "shader_compiler.h"
+#include "texture_uploader.h"
+#include "texture_stream.h"
+#include "texture_compress.h"
+#include "decode_pool.h"
+#include "texture_cache.h"
+#include "lookahead.h"
+#include "viewporter-client-protocol.h"
 
 /* Helper function to get the preferred output identifier
  * Prefers connector_name (e.g., "HDMI-A-2", "DP-1") over model name
@@ -46,6 +55,7 @@ struct output_state *output_create(struct neowall_state *state,
     out->pixel_height = 0;
     out->scale = 1;
     out->transform = WL_OUTPUT_TRANSFORM_NORMAL;
+    out->render_scale = 1.0f;
     out->current_shader_path[0] = '\0';
     out->configured = false;
     out->needs_redraw = true;
@@ -58,11 +68,21 @@ struct output_state *output_create(struct neowall_state *state,
     out->preload_path[0] = '\0';
     atomic_store(&out->preload_ready, false);
     
-    /* Initialize background preload thread state */
+    /* Initialize background preload hand-off state */
     pthread_mutex_init(&out->preload_mutex, NULL);
     out->preload_decoded_image = NULL;
-    atomic_store(&out->preload_thread_active, false);
+    out->preload_decoded_texture = 0;
+    out->preload_stream = NULL;
     atomic_store(&out->preload_upload_pending, false);
+    out->lookahead = NULL;
+    out->lookahead_bytes = 0;
+    out->channel_preload_path[0] = '\0';
+    out->channel_preload_image = NULL;
+    out->channel_uploaded_texture = 0;
+    atomic_store(&out->channel_upload_pending, false);
+    out->channel_preload_texture = 0;
+    out->channel_texture_path[0] = '\0';
+    out->channel_switch_pending = false;
 
     /* Compositor surface will be created later in output_configure_compositor_surface() */
     out->compositor_surface = NULL;
@@ -98,6 +118,11 @@ struct output_state *output_create(struct neowall_state *state,
     
     out->shader_fade_start_time = 0;
     out->pending_shader_path[0] = '\0';
+    out->pending_shader_program = 0;
+    atomic_store(&out->shader_compile_ready, false);
+    out->shader_preload_path[0] = '\0';
+    out->shader_preload_program = 0;
+    atomic_store(&out->shader_preload_ready, false);
 
     /* Initialize FPS tracking */
     out->fps_last_log_time = 0;
@@ -123,6 +148,12 @@ void output_destroy(struct output_state *output) {
     log_debug("Destroying output %s (name=%u)",
               output->model[0] ? output->model : "unknown", output->name);
 
+    /* Join the output's render thread before tearing down what it renders */
+    render_thread_stop(output);
+
+    /* Wait out a background compile that would publish into this output */
+    shader_compiler_cancel(output);
+
     /* Clean up rendering resources */
     render_cleanup_output(output);
 
@@ -153,12 +184,13 @@ void output_destroy(struct output_state *output) {
         output->next_image = NULL;
     }
     
-    /* Cancel and wait for background preload thread if active */
-    if (atomic_load(&output->preload_thread_active)) {
-        pthread_cancel(output->preload_thread);
-        pthread_join(output->preload_thread, NULL);
-        atomic_store(&output->preload_thread_active, false);
-    }
+    /* Drop queued decodes and wait out a running one publishing into this output */
+    decode_pool_cancel(output);
+    texture_cache_cancel(output);
+    lookahead_clear(output);
+
+    /* The upload thread publishes into the preload fields below */
+    texture_uploader_cancel(output);
     
     /* Free preload data */
     pthread_mutex_lock(&output->preload_mutex);
@@ -176,12 +208,42 @@ void output_destroy(struct output_state *output) {
         image_free(output->preload_decoded_image);
         output->preload_decoded_image = NULL;
     }
+
+    if (output->preload_decoded_texture) {
+        render_destroy_texture(output->preload_decoded_texture);
+        output->preload_decoded_texture = 0;
+    }
+
+    if (output->channel_preload_image) {
+        image_free(output->channel_preload_image);
+        output->channel_preload_image = NULL;
+    }
+
+    if (output->channel_uploaded_texture) {
+        glDeleteTextures(1, &output->channel_uploaded_texture);
+        output->channel_uploaded_texture = 0;
+    }
+
+    texture_stream_abort(output->preload_stream);
+    output->preload_stream = NULL;
     pthread_mutex_unlock(&output->preload_mutex);
     pthread_mutex_destroy(&output->preload_mutex);
 
     log_debug("Destroying output %s (name=%u)",
               output->model[0] ? output->model : "unknown", output->name);
 
+    /* Drop outstanding frame callback before its surface goes away */
+    if (output->frame_callback) {
+        wl_callback_destroy(output->frame_callback);
+        output->frame_callback = NULL;
+    }
+
+    /* Viewport is an extension of the surface, destroy it first */
+    if (output->viewport) {
+        wp_viewport_destroy(output->viewport);
+        output->viewport = NULL;
+    }
+
     /* Destroy compositor surface (handles all surface cleanup) */
     if (output->compositor_surface) {
         if (output->compositor_surface->egl_surface != EGL_NO_SURFACE && output->state) {
@@ -253,59 +315,134 @@ bool output_create_egl_surface(struct output_state *output) {
     return true;
 }
 
-/* Background thread function for async image decoding */
-struct preload_thread_args {
+/* Decode job for the next cycle entry, run on the shared decode pool */
+struct preload_job {
     struct output_state *output;
     char path[MAX_PATH_LENGTH];
     int32_t width;
     int32_t height;
     enum wallpaper_mode mode;
+    enum texture_compression compression;
 };
 
-static void *preload_thread_func(void *arg) {
-    struct preload_thread_args *args = (struct preload_thread_args *)arg;
-    struct output_state *output = args->output;
-    
-    /* Enable thread cancellation at any time */
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-    pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
-    
-    log_debug("Background thread: decoding image %s (%dx%d, mode=%d)",
-              args->path, args->width, args->height, args->mode);
-    
-    /* Decode image in background (CPU-bound, no GL context needed) */
-    struct image_data *decoded_image = image_load(args->path, args->width, args->height, args->mode);
-    
+static void preload_job_run(void *arg, const atomic_bool_t *cancelled) {
+    struct preload_job *job = arg;
+    struct output_state *output = job->output;
+
+    /* Another output of the same size may already have it or be decoding it */
+    if (texture_cache_claim(output, job->path, job->width, job->height, job->mode) !=
+        TEXTURE_CLAIM_DECODE) {
+        free(job);
+        return;
+    }
+
+    log_debug("Background preload: decoding image %s (%dx%d, mode=%d)",
+              job->path, job->width, job->height, job->mode);
+
+    /* Decode image in background (CPU-bound, no GL context needed), unless the
+     * lookahead already did */
+    struct image_data *decoded_image = lookahead_take(output, job->path, job->width,
+                                                      job->height, job->mode);
     if (!decoded_image) {
-        log_error("Background thread: failed to decode image: %s", args->path);
-        atomic_store(&output->preload_thread_active, false);
-        free(args);
-        return NULL;
+        decoded_image = image_load(job->path, job->width, job->height, job->mode);
     }
-    
-    log_info("Background thread: decoded image %s (%ux%u) - ready for GPU upload",
-             args->path, decoded_image->width, decoded_image->height);
-    
+
+    if (!decoded_image) {
+        log_error("Background preload: failed to decode image: %s", job->path);
+        texture_cache_abandon(output, job->path, job->width, job->height, job->mode);
+        free(job);
+        return;
+    }
+
+    /* Superseded by a newer lookahead or the output is going away */
+    if (atomic_load(cancelled)) {
+        texture_cache_abandon(output, job->path, job->width, job->height, job->mode);
+        image_free(decoded_image);
+        free(job);
+        return;
+    }
+
+    log_info("Background preload: decoded image %s (%ux%u) - ready for GPU upload",
+             job->path, decoded_image->width, decoded_image->height);
+
+    if (job->compression != TEXTURE_COMPRESSION_NONE && !decoded_image->compressed) {
+        texture_compress_etc2(decoded_image, job->compression);
+        if (atomic_load(cancelled)) {
+            texture_cache_abandon(output, job->path, job->width, job->height, job->mode);
+            image_free(decoded_image);
+            free(job);
+            return;
+        }
+    }
+
+    /* Upload thread available: it creates the texture and hands both over */
+    if (texture_uploader_submit(output, decoded_image, job->path)) {
+        free(job);
+        return;
+    }
+
     /* Hand off decoded image to main thread for GPU upload */
     pthread_mutex_lock(&output->preload_mutex);
-    
+
     /* Clean up old decoded image if exists */
     if (output->preload_decoded_image) {
         image_free(output->preload_decoded_image);
     }
-    
+
     output->preload_decoded_image = decoded_image;
-    strncpy(output->preload_path, args->path, sizeof(output->preload_path) - 1);
+    strncpy(output->preload_path, job->path, sizeof(output->preload_path) - 1);
     output->preload_path[sizeof(output->preload_path) - 1] = '\0';
-    
+
     pthread_mutex_unlock(&output->preload_mutex);
-    
-    /* Signal main thread that upload is pending */
+
+    /* Signal main thread that upload is pending - a preload completion is a
+     * scheduler deadline, wake the loop instead of waiting for the next redraw */
     atomic_store(&output->preload_upload_pending, true);
-    atomic_store(&output->preload_thread_active, false);
-    
-    free(args);
-    return NULL;
+    event_loop_wake_output(output);
+
+    free(job);
+}
+
+/* Whether a cycle entry is an image (shader + image cycling feeds these to iChannel0) */
+static bool cycle_path_is_image(const char *path) {
+    const char *ext = strrchr(path, '.');
+    return ext && (strcmp(ext, ".png") == 0 || strcmp(ext, ".jpg") == 0 ||
+                   strcmp(ext, ".jpeg") == 0 || strcmp(ext, ".PNG") == 0 ||
+                   strcmp(ext, ".JPG") == 0 || strcmp(ext, ".JPEG") == 0);
+}
+
+/* Compile the next playlist shader on the background compiler so the cycle
+ * only has to fade to it. Channel textures are per output, not per entry, and
+ * stay loaded across the switch. */
+static void output_preload_next_shader(struct output_state *output) {
+    size_t next_index = (output->config->current_cycle_index + 1) % output->config->cycle_count;
+
+    char next_path[MAX_PATH_LENGTH];
+    pthread_mutex_lock(&output->state->state_mutex);
+    if (!output->config->cycle_paths || next_index >= output->config->cycle_count) {
+        pthread_mutex_unlock(&output->state->state_mutex);
+        return;
+    }
+    strncpy(next_path, output->config->cycle_paths[next_index], sizeof(next_path) - 1);
+    next_path[sizeof(next_path) - 1] = '\0';
+    pthread_mutex_unlock(&output->state->state_mutex);
+
+    if (cycle_path_is_image(next_path)) {
+        return;
+    }
+
+    if (strcmp(output->shader_preload_path, next_path) == 0) {
+        log_debug("Next shader already preloading: %s", next_path);
+        return;
+    }
+
+    if (!shader_compiler_preload(output, next_path, output->channel_count)) {
+        output->shader_preload_path[0] = '\0';
+        return;
+    }
+    memcpy(output->shader_preload_path, next_path, sizeof(output->shader_preload_path));
+    log_debug("Preloading next shader for output %s: %s",
+              output->model[0] ? output->model : "unknown", next_path);
 }
 
 /* Start background preload of next wallpaper (non-blocking) */
@@ -314,15 +451,17 @@ void output_preload_next_wallpaper(struct output_state *output) {
         return;
     }
     
-    /* Only preload for cycling image wallpapers */
-    if (!output->config->cycle || output->config->cycle_count <= 1 || 
-        output->config->type != WALLPAPER_IMAGE) {
+    if (!output->config->cycle || output->config->cycle_count <= 1) {
         return;
     }
-    
-    /* Don't start new preload if thread is already running */
-    if (atomic_load(&output->preload_thread_active)) {
-        log_debug("Preload thread already active, skipping");
+
+    if (output->config->type == WALLPAPER_SHADER) {
+        output_preload_next_shader(output);
+        return;
+    }
+
+    /* Only preload for cycling image wallpapers */
+    if (output->config->type != WALLPAPER_IMAGE) {
         return;
     }
     
@@ -342,42 +481,263 @@ void output_preload_next_wallpaper(struct output_state *output) {
     if (atomic_load(&output->preload_ready) && strcmp(output->preload_path, next_path) == 0) {
         pthread_mutex_unlock(&output->state->state_mutex);
         log_debug("Next wallpaper already preloaded: %s", next_path);
+        lookahead_update(output);
         return;
     }
     
-    /* Prepare thread arguments */
-    struct preload_thread_args *args = malloc(sizeof(struct preload_thread_args));
-    if (!args) {
+    /* Prepare the decode job */
+    struct preload_job *job = malloc(sizeof(struct preload_job));
+    if (!job) {
         pthread_mutex_unlock(&output->state->state_mutex);
-        log_error("Failed to allocate preload thread args");
+        log_error("Failed to allocate preload job");
         return;
     }
-    
-    args->output = output;
-    strncpy(args->path, next_path, sizeof(args->path) - 1);
-    args->path[sizeof(args->path) - 1] = '\0';
-    args->width = output->width;
-    args->height = output->height;
-    args->mode = output->config->mode;
-    
+
+    job->output = output;
+    strncpy(job->path, next_path, sizeof(job->path) - 1);
+    job->path[sizeof(job->path) - 1] = '\0';
+    job->width = output->width;
+    job->height = output->height;
+    job->mode = output->config->mode;
+    /* ETC2 sampling is only guaranteed from ES 3.0 */
+    job->compression = output->state->gl_caps.gles_version >= GLES_VERSION_3_0 ?
+                       output->config->texture_compression : TEXTURE_COMPRESSION_NONE;
+
     pthread_mutex_unlock(&output->state->state_mutex);
-    
+
+    /* Same target already decoding: keep it. A different one replaces any
+     * older lookahead still queued or running for this output. */
+    char key[DECODE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "%dx%d/%d/%s", job->width, job->height, (int)job->mode, job->path);
+
     log_debug("Starting background preload for output %s: %s",
-              output->model[0] ? output->model : "unknown", args->path);
-    
-    /* Launch background thread */
-    atomic_store(&output->preload_thread_active, true);
-    if (pthread_create(&output->preload_thread, NULL, preload_thread_func, args) != 0) {
-        log_error("Failed to create preload thread");
-        atomic_store(&output->preload_thread_active, false);
-        free(args);
+              output->model[0] ? output->model : "unknown", job->path);
+
+    struct decode_request request = {
+        .owner = output,
+        .priority = DECODE_PRIORITY_PRELOAD,
+        .key = key,
+        .supersede = true,
+        .run = preload_job_run,
+        .discard = free,
+        .arg = job,
+    };
+    if (!decode_pool_submit(&request)) {
+        log_error("Failed to queue preload for output %s",
+                  output->model[0] ? output->model : "unknown");
+    }
+
+    /* Queued after the next entry, so it is decoded first */
+    lookahead_update(output);
+}
+
+/* Decode job for an iChannel0 image of a shader + image cycle */
+struct channel_job {
+    struct output_state *output;
+    char path[MAX_PATH_LENGTH];
+    uint32_t max_size;
+};
+
+static void channel_job_run(void *arg, const atomic_bool_t *cancelled) {
+    struct channel_job *job = arg;
+    struct output_state *output = job->output;
+
+    struct image_data *img = image_load_bounded(job->path, job->max_size);
+    if (!img) {
+        log_error("Failed to load image for iChannel0: %s", job->path);
+        free(job);
         return;
     }
-    
-    /* Detach thread so it cleans up automatically when done */
-    pthread_detach(output->preload_thread);
-    
-    log_info("Background preload thread started for: %s", args->path);
+
+    /* Upload thread available: it creates the texture and mipmaps and hands both over */
+    if (!atomic_load(cancelled) && texture_uploader_submit_channel(output, img)) {
+        free(job);
+        return;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    if (!atomic_load(cancelled) && strcmp(output->channel_preload_path, job->path) == 0) {
+        if (output->channel_preload_image) {
+            image_free(output->channel_preload_image);
+        }
+        output->channel_preload_image = img;
+        img = NULL;
+    }
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    if (img) {
+        /* The cycle moved on while decoding */
+        image_free(img);
+    } else {
+        atomic_store(&output->channel_upload_pending, true);
+        atomic_store(&output->preload_upload_pending, true);
+        event_loop_wake_output(output);
+    }
+    free(job);
+}
+
+/* Start preparing an iChannel0 image unless it is uploaded or on its way */
+static void output_prepare_channel_image(struct output_state *output, const char *path) {
+    if (output->channel_preload_texture && strcmp(output->channel_texture_path, path) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    if (strcmp(output->channel_preload_path, path) == 0 && output->channel_preload_image) {
+        pthread_mutex_unlock(&output->preload_mutex);
+        return;
+    }
+    if (strcmp(output->channel_preload_path, path) != 0) {
+        strncpy(output->channel_preload_path, path, sizeof(output->channel_preload_path) - 1);
+        output->channel_preload_path[sizeof(output->channel_preload_path) - 1] = '\0';
+        /* An uploaded texture stays with its image until a context is current to delete it */
+        if (output->channel_preload_image && !output->channel_uploaded_texture) {
+            image_free(output->channel_preload_image);
+            output->channel_preload_image = NULL;
+        }
+    }
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    struct channel_job *job = malloc(sizeof(*job));
+    if (!job) {
+        log_error("Failed to allocate iChannel preload job");
+        return;
+    }
+    job->output = output;
+    strncpy(job->path, path, sizeof(job->path) - 1);
+    job->path[sizeof(job->path) - 1] = '\0';
+    job->max_size = render_channel_max_size(output);
+
+    char key[DECODE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "channel/%u/%s", job->max_size, job->path);
+
+    struct decode_request request = {
+        .owner = output,
+        .priority = DECODE_PRIORITY_VISIBLE,
+        .key = key,
+        .supersede = true,
+        .run = channel_job_run,
+        .discard = free,
+        .arg = job,
+    };
+    if (!decode_pool_submit(&request)) {
+        log_error("Failed to queue iChannel0 image for output %s",
+                  output->model[0] ? output->model : "unknown");
+    }
+}
+
+/* Prepare the image after the current one before the cycle asks for it */
+static void output_preload_next_channel_image(struct output_state *output) {
+    if (!output->config->cycle || output->config->cycle_count <= 1) {
+        return;
+    }
+
+    char next_path[MAX_PATH_LENGTH];
+    pthread_mutex_lock(&output->state->state_mutex);
+    if (!output->config->cycle_paths) {
+        pthread_mutex_unlock(&output->state->state_mutex);
+        return;
+    }
+    size_t next_index = (output->config->current_cycle_index + 1) % output->config->cycle_count;
+    strncpy(next_path, output->config->cycle_paths[next_index], sizeof(next_path) - 1);
+    next_path[sizeof(next_path) - 1] = '\0';
+    pthread_mutex_unlock(&output->state->state_mutex);
+
+    if (cycle_path_is_image(next_path)) {
+        output_prepare_channel_image(output, next_path);
+    }
+}
+
+/* Make the uploaded image iChannel0; one texture name swap, never a partial image */
+static void output_apply_channel_image(struct output_state *output) {
+    output->channel_switch_pending = false;
+    if (!output->channel_textures || output->channel_count == 0) {
+        return;
+    }
+
+    GLuint old_texture = output->channel_textures[0];
+    output->channel_textures[0] = output->channel_preload_texture;
+    output->channel_preload_texture = 0;
+    output->channel_generation++;
+    if (old_texture != 0) {
+        glDeleteTextures(1, &old_texture);
+    }
+    output->gl_state.bound_texture = 0;
+    output->needs_redraw = true;
+
+    log_info("Updated iChannel0 with image: %s -> texture ID %u",
+             output->channel_texture_path, output->channel_textures[0]);
+
+    const char *mode_str = wallpaper_mode_to_string(output->config->mode);
+    write_wallpaper_state(output_get_identifier(output), output->config->shader_path, mode_str,
+                         output->config->current_cycle_index,
+                         output->config->cycle_count,
+                         "active");
+
+    output_preload_next_channel_image(output);
+}
+
+void output_upload_channel_image(struct output_state *output) {
+    if (!output || !atomic_exchange(&output->channel_upload_pending, false)) {
+        return;
+    }
+
+    pthread_mutex_lock(&output->preload_mutex);
+    struct image_data *img = output->channel_preload_image;
+    GLuint texture = output->channel_uploaded_texture;
+    output->channel_preload_image = NULL;
+    output->channel_uploaded_texture = 0;
+    pthread_mutex_unlock(&output->preload_mutex);
+    if (!img) {
+        return;
+    }
+
+    if (!output->compositor_surface ||
+        !eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
+                        output->compositor_surface->egl_surface, render_thread_context_for(output))) {
+        log_error("Failed to make EGL context current for iChannel0 upload");
+        image_free(img);
+        return;
+    }
+
+    /* Without the upload thread, or if its upload failed, upload here */
+    if (texture == 0) {
+        texture = render_create_channel_texture(output, 0, img);
+        output->gl_state.bound_texture = 0;
+    }
+    if (texture == 0) {
+        log_error("Failed to create texture for iChannel0 from: %s", img->path);
+        image_free(img);
+        return;
+    }
+
+    if (output->channel_preload_texture != 0) {
+        glDeleteTextures(1, &output->channel_preload_texture);
+    }
+    output->channel_preload_texture = texture;
+    memcpy(output->channel_texture_path, img->path, sizeof(output->channel_texture_path));
+    log_debug("iChannel0 image uploaded ahead: %s (%ux%u)", img->path, img->width, img->height);
+    image_free(img);
+
+    if (output->channel_switch_pending) {
+        output_apply_channel_image(output);
+    }
+}
+
+/* Cycle iChannel0 to an image: switch now if it was prepared, otherwise as
+ * soon as its background decode and upload finish */
+static void output_cycle_channel_image(struct output_state *output, const char *path) {
+    /* A decode may have finished without its upload having run yet */
+    output_upload_channel_image(output);
+
+    if (output->channel_preload_texture && strcmp(output->channel_texture_path, path) == 0) {
+        output_apply_channel_image(output);
+        return;
+    }
+
+    output->channel_switch_pending = true;
+    output_prepare_channel_image(output, path);
+    log_info("iChannel0 image %s not prepared yet, switching once it is decoded", path);
 }
 
 void output_set_wallpaper(struct output_state *output, const char *path) {
@@ -412,11 +772,22 @@ void output_set_wallpaper(struct output_state *output, const char *path) {
             log_debug("Preloaded texture mismatch: wanted '%s', have '%s'", path, output->preload_path);
         }
         
-        /* Load new image with display-aware scaling */
-        new_image = image_load(path, output->width, output->height, output->config->mode);
-        if (!new_image) {
-            log_error("Failed to load wallpaper image: %s", path);
-            return;
+        /* Another output of the same size may already show it */
+        new_texture = texture_cache_acquire(path, output->width, output->height,
+                                            output->config->mode, &new_image);
+        if (new_texture != 0) {
+            used_preload = true;
+        } else {
+            /* Decoded further ahead, or load new image with display-aware scaling */
+            new_image = lookahead_take(output, path, output->width, output->height,
+                                       output->config->mode);
+            if (!new_image) {
+                new_image = image_load(path, output->width, output->height, output->config->mode);
+            }
+            if (!new_image) {
+                log_error("Failed to load wallpaper image: %s", path);
+                return;
+            }
         }
     }
 
@@ -435,7 +806,7 @@ void output_set_wallpaper(struct output_state *output, const char *path) {
 
     /* CRITICAL: Ensure EGL context is current for this thread before any GL operations */
     if (!output->compositor_surface || !eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
         log_error("Failed to make EGL context current for wallpaper set");
         image_free(new_image);
         return;
@@ -471,7 +842,7 @@ void output_set_wallpaper(struct output_state *output, const char *path) {
 
     /* Make EGL context current before creating textures */
     if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
         EGLint egl_error = eglGetError();
         log_error("Failed to make EGL context current for output %s: 0x%x (display may be disconnected)",
                   output->model[0] ? output->model : "unknown", egl_error);
@@ -506,6 +877,7 @@ void output_set_wallpaper(struct output_state *output, const char *path) {
             output->texture = new_texture;
         } else {
             output->texture = render_create_texture(new_image);
+            texture_cache_insert(output->texture, new_image);
         }
         
         log_info("Transition started: %s -> %s (type=%d '%s', duration=%.2fs)%s",
@@ -530,6 +902,7 @@ void output_set_wallpaper(struct output_state *output, const char *path) {
             output->texture = new_texture;
         } else {
             output->texture = render_create_texture(new_image);
+            texture_cache_insert(output->texture, new_image);
         }
         
         log_info("Wallpaper texture created successfully (texture=%u) for output %s%s", 
@@ -594,7 +967,7 @@ void output_set_shader(struct output_state *output, const char *shader_path) {
 
     /* CRITICAL: Ensure EGL context is current before any GL operations */
     if (!output->compositor_surface || !eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
         log_error("Failed to make EGL context current for shader set");
         return;
     }
@@ -635,7 +1008,7 @@ void output_set_shader(struct output_state *output, const char *shader_path) {
 
     /* Make EGL context current before creating shader program */
     if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
         EGLint egl_error = eglGetError();
         log_error("Failed to make EGL context current for output %s: 0x%x (display may be disconnected)",
                   output->model[0] ? output->model : "unknown", egl_error);
@@ -645,14 +1018,44 @@ void output_set_shader(struct output_state *output, const char *shader_path) {
     log_debug("EGL context made current for output %s",
               output->model[0] ? output->model : "unknown");
 
-    /* If there's an existing shader, compile new shader and switch immediately */
+    /* If there's an existing shader, compile the new one off the render path and
+     * cross-fade once it is ready; the old shader keeps running meanwhile */
     if (output->live_shader_program != 0) {
         /* Prevent re-entrant shader changes */
-        if (output->shader_fade_start_time > 0 && output->pending_shader_path[0] != '\0') {
+        if (output->shader_fade_start_time > 0 || output->pending_shader_path[0] != '\0') {
             log_debug("Shader change already in progress, ignoring new request for: %s", shader_path);
             return;
         }
-        
+
+        /* Lookahead compiled (or is compiling) this entry: the render path
+         * claims it once ready */
+        if (output->shader_preload_path[0] != '\0' &&
+            strcmp(output->shader_preload_path, shader_path) == 0) {
+            if (atomic_load(&output->shader_preload_ready)) {
+                log_info("Output %s: next shader preloaded and ready (prepared in %lums): %s",
+                         model_copy[0] ? model_copy : "unknown",
+                         (unsigned long)output->shader_preload_ms, shader_path);
+            } else {
+                log_info("Output %s: next shader still preloading, fading once ready: %s",
+                         model_copy[0] ? model_copy : "unknown", shader_path);
+            }
+            strncpy(output->pending_shader_path, shader_path, sizeof(output->pending_shader_path) - 1);
+            output->pending_shader_path[sizeof(output->pending_shader_path) - 1] = '\0';
+            output->last_cycle_time = get_time_ms();
+            output->needs_redraw = true;
+            return;
+        }
+
+        if (shader_compiler_submit(output, shader_path, output->channel_count)) {
+            strncpy(output->pending_shader_path, shader_path, sizeof(output->pending_shader_path) - 1);
+            output->pending_shader_path[sizeof(output->pending_shader_path) - 1] = '\0';
+            output->last_cycle_time = get_time_ms();
+            log_info("Output %s: no preload for next shader, compiling in background: %s",
+                     model_copy[0] ? model_copy : "unknown", shader_path);
+            return;
+        }
+
+        /* No background compiler - compile here and switch immediately */
         log_info("Compiling new shader: %s", shader_path);
         
         /* Compile new shader immediately (before switching) to avoid stutter */
@@ -720,6 +1123,7 @@ void output_set_shader(struct output_state *output, const char *shader_path) {
         output->last_cycle_time = get_time_ms();
         
         log_info("Shader switched successfully: %s", shader_path);
+        output_preload_next_wallpaper(output);
         return;
     }
     
@@ -824,6 +1228,9 @@ void output_set_shader(struct output_state *output, const char *shader_path) {
                          "active");
 
     log_info("Live shader wallpaper loaded successfully");
+
+    /* Start compiling the next playlist entry */
+    output_preload_next_wallpaper(output);
 }
 
 /* Cycle to next wallpaper in the cycle list */
@@ -861,8 +1268,8 @@ void output_cycle_wallpaper(struct output_state *output) {
 
     /* Don't cycle if a shader cross-fade is in progress */
     if (output->config->type == WALLPAPER_SHADER && 
-        output->shader_fade_start_time > 0 && 
-        output->pending_shader_path[0] != '\0') {
+        (output->shader_fade_start_time > 0 ||
+         output->pending_shader_path[0] != '\0')) {
         /* Use local copy of model to avoid race if output is being modified */
         char model_copy[64];
         strncpy(model_copy, output->model, sizeof(model_copy) - 1);
@@ -896,17 +1303,9 @@ void output_cycle_wallpaper(struct output_state *output) {
      * 
      * In this mode, we keep the same shader but cycle images through iChannel0
      */
-    bool is_shader_with_image_cycling = false;
-    if (output->config->type == WALLPAPER_SHADER && 
-        output->config->shader_path[0] != '\0') {
-        /* Check if the first cycle path looks like an image (not a .glsl shader) */
-        const char *ext = strrchr(next_path, '.');
-        if (ext && (strcmp(ext, ".png") == 0 || strcmp(ext, ".jpg") == 0 || 
-                   strcmp(ext, ".jpeg") == 0 || strcmp(ext, ".PNG") == 0 || 
-                   strcmp(ext, ".JPG") == 0 || strcmp(ext, ".JPEG") == 0)) {
-            is_shader_with_image_cycling = true;
-        }
-    }
+    bool is_shader_with_image_cycling = output->config->type == WALLPAPER_SHADER &&
+                                        output->config->shader_path[0] != '\0' &&
+                                        cycle_path_is_image(next_path);
 
     if (is_shader_with_image_cycling) {
         /* Shader + Image Cycling mode: Update iChannel0 with the next image */
@@ -918,20 +1317,9 @@ void output_cycle_wallpaper(struct output_state *output) {
                  output->config->cycle_count,
                  next_path);
         
-        /* Update iChannel0 with the new image */
-        if (!render_update_channel_texture(output, 0, next_path)) {
-            log_error("Failed to update iChannel0 with: %s", next_path);
-            return;
-        }
-        
-        /* Write state to file */
-        const char *mode_str = wallpaper_mode_to_string(output->config->mode);
-        write_wallpaper_state(output_get_identifier(output), output->config->shader_path, mode_str,
-                             output->config->current_cycle_index,
-                             output->config->cycle_count,
-                             "active");
-        
-        log_info("Image cycled through shader successfully");
+        /* Swap in iChannel0 prepared in the background; the shader keeps animating */
+        output->last_cycle_time = get_time_ms();
+        output_cycle_channel_image(output, next_path);
     } else {
         /* Normal cycling mode: change the wallpaper or shader entirely */
         const char *type_str = (output->config->type == WALLPAPER_SHADER) ? "shader" : "wallpaper";
@@ -1044,6 +1432,7 @@ bool output_apply_config(struct output_state *output, struct wallpaper_config *c
 
     /* Get inactive slot for writing new config */
     int inactive = get_inactive_slot(output);
+    bool channel_cycle_started = false;
     
     /* Lock the inactive slot */
     pthread_mutex_lock(&output->config_slots[inactive].lock);
@@ -1108,6 +1497,7 @@ bool output_apply_config(struct output_state *output, struct wallpaper_config *c
             /* Reset shader state */
             output->shader_start_time = 0;
             output->shader_time_accum_ms = 0;
+            shader_compiler_cancel(output);
             output->shader_fade_start_time = 0;
             output->pending_shader_path[0] = '\0';
             output->current_shader_path[0] = '\0';
@@ -1334,6 +1724,9 @@ bool output_apply_config(struct output_state *output, struct wallpaper_config *c
         }
     }
 
+    /* Size the render buffer for the new config before anything loads at that size */
+    output_configure_render_scale(output, &output->config_slots[inactive].config);
+
     /* Set initial wallpaper/shader based on type */
     if (config->type == WALLPAPER_SHADER) {
         /* Load shader wallpaper */
@@ -1370,6 +1763,8 @@ bool output_apply_config(struct output_state *output, struct wallpaper_config *c
                     
                     if (!render_update_channel_texture(output, 0, initial_image)) {
                         log_error("Failed to load initial image into iChannel0: %s", initial_image);
+                    } else {
+                        channel_cycle_started = true;
                     }
                 }
             } else {
@@ -1418,27 +1813,24 @@ bool output_apply_config(struct output_state *output, struct wallpaper_config *c
     log_info("Config applied and swapped for %s (now using slot %d)", 
              output->model[0] ? output->model : "unknown", inactive);
 
-    /* Configure vsync based on shader_fps setting:
-     * - shader_fps = 60 (default) → enable vsync for power efficiency
-     * - shader_fps != 60 → disable vsync to respect custom FPS target */
+    /* Decode the second image while the first one is shown */
+    if (channel_cycle_started) {
+        output_preload_next_channel_image(output);
+    }
+
+    /* Keep swap interval at 0: frame pacing comes from wl_surface.frame callbacks
+     * in the event loop (shader_fps acts as an upper cap), so eglSwapBuffers must
+     * never block waiting for vblank on its own */
     if (output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
         if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                           output->compositor_surface->egl_surface, output->state->egl_context)) {
-            log_error("Failed to make EGL context current for vsync config");
+                           output->compositor_surface->egl_surface, render_thread_context_for(output))) {
+            log_error("Failed to make EGL context current for swap interval config");
+        } else if (!eglSwapInterval(output->state->egl_display, 0)) {
+            EGLint err = eglGetError();
+            log_debug("Could not set swap interval to 0: 0x%x", err);
         } else {
-            int swap_interval = (output->config->shader_fps == 60) ? 1 : 0;
-            if (!eglSwapInterval(output->state->egl_display, swap_interval)) {
-                EGLint err = eglGetError();
-                log_debug("Could not set swap interval to %d: 0x%x", swap_interval, err);
-            } else {
-                if (swap_interval == 1) {
-                    log_info("Enabled vsync for output %s (shader_fps=60, power efficient)", 
-                             output->model[0] ? output->model : "unknown");
-                } else {
-                    log_info("Disabled vsync for output %s (shader_fps=%d, custom frame rate)", 
-                             output->model[0] ? output->model : "unknown", output->config->shader_fps);
-                }
-            }
+            log_debug("Frame-callback pacing for output %s (shader_fps cap=%d)", 
+                      output->model[0] ? output->model : "unknown", output->config->shader_fps);
         }
     }
 
@@ -1467,6 +1859,10 @@ void output_apply_deferred_config(struct output_state *output) {
         return;
     }
 
+    if (!output->viewport) {
+        output_configure_render_scale(output, output->config);
+    }
+
     /* Check if there's a deferred config to apply */
     if (output->config->type == WALLPAPER_SHADER && output->config->shader_path[0] != '\0') {
         /* Check if shader is not yet loaded */
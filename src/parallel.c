@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "neowall.h"
+#include "constants.h"
+#include "parallel.h"
+
+struct band_batch {
+    parallel_band_fn fn;
+    void *ctx;
+    uint32_t rows;
+    uint32_t band_rows;
+    uint32_t bands;
+    uint32_t next_band;     /* First band not claimed yet */
+    uint32_t done_bands;
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_t pool_threads[PARALLEL_MAX_THREADS];
+static uint32_t pool_size = 0;              /* Worker threads (caller excluded) */
+static bool pool_stop = false;
+static struct band_batch *batch = NULL;     /* Batch being worked on, one at a time */
+static _Thread_local bool thread_serial = false;
+
+/* Claim and run bands of the current batch; called and returns with pool_lock held */
+static void run_bands(struct band_batch *b) {
+    while (b->next_band < b->bands) {
+        uint32_t band = b->next_band++;
+        pthread_mutex_unlock(&pool_lock);
+
+        uint32_t begin = band * b->band_rows;
+        uint32_t end = begin + b->band_rows < b->rows ? begin + b->band_rows : b->rows;
+        b->fn(b->ctx, begin, end);
+
+        pthread_mutex_lock(&pool_lock);
+        if (++b->done_bands == b->bands) {
+            pthread_cond_broadcast(&done_cond);
+        }
+    }
+}
+
+static void *worker_func(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&pool_lock);
+    while (!pool_stop) {
+        if (batch && batch->next_band < batch->bands) {
+            run_bands(batch);
+            continue;
+        }
+        pthread_cond_wait(&work_cond, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+static void pool_start(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t wanted = cpus > 1 ? (uint32_t)cpus - 1 : 0;
+    if (wanted > PARALLEL_MAX_THREADS - 1) {
+        wanted = PARALLEL_MAX_THREADS - 1;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    for (uint32_t i = 0; i < wanted && !pool_stop; i++) {
+        if (pthread_create(&pool_threads[i], NULL, worker_func, NULL) != 0) {
+            log_error("Failed to start image worker thread %u", i);
+            break;
+        }
+        pool_size++;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    if (pool_size > 0) {
+        log_debug("Image band workers started: %u (+ caller)", pool_size);
+    }
+}
+
+void parallel_bands(uint32_t rows, uint32_t min_band_rows, parallel_band_fn fn, void *ctx) {
+    if (rows == 0) {
+        return;
+    }
+    if (min_band_rows == 0) {
+        min_band_rows = 1;
+    }
+
+    if (thread_serial) {
+        fn(ctx, 0, rows);
+        return;
+    }
+
+    pthread_once(&pool_once, pool_start);
+
+    pthread_mutex_lock(&pool_lock);
+    if (batch || pool_stop || pool_size == 0 || rows < min_band_rows * 2) {
+        /* Pool busy with another image, stopped or not worth it */
+        pthread_mutex_unlock(&pool_lock);
+        fn(ctx, 0, rows);
+        return;
+    }
+
+    /* A few bands per thread so uneven bands (padding, clipped edges) balance out */
+    uint32_t threads = pool_size + 1;
+    uint32_t band_rows = (rows + threads * 4 - 1) / (threads * 4);
+    if (band_rows < min_band_rows) {
+        band_rows = min_band_rows;
+    }
+    struct band_batch b = {
+        .fn = fn,
+        .ctx = ctx,
+        .rows = rows,
+        .band_rows = band_rows,
+        .bands = (rows + band_rows - 1) / band_rows,
+    };
+    batch = &b;
+    pthread_cond_broadcast(&work_cond);
+
+    run_bands(&b);
+    while (b.done_bands < b.bands) {
+        pthread_cond_wait(&done_cond, &pool_lock);
+    }
+    batch = NULL;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void parallel_set_thread_serial(bool serial) {
+    thread_serial = serial;
+}
+
+void parallel_shutdown(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_stop = true;
+    pthread_cond_broadcast(&work_cond);
+    uint32_t count = pool_size;
+    pthread_mutex_unlock(&pool_lock);
+
+    for (uint32_t i = 0; i < count; i++) {
+        pthread_join(pool_threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    pool_size = 0;
+    pthread_mutex_unlock(&pool_lock);
+}
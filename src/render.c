@@ -10,6 +10,11 @@
 #include "shader.h"
 #include "textures.h"
 #include "compositor.h"
+#include "render_thread.h"
+#include "egl/egl_core.h"
+#include "gl_debug.h"
+#include "texture_compress.h"
+#include "texture_cache.h"
 
 /* Helper function to get the preferred output identifier
  * Prefers connector_name (e.g., "HDMI-A-2", "DP-1") over model name
@@ -98,10 +103,36 @@ static void draw_char_at(int char_index, float x, float y, float char_width, flo
     }
 }
 
+/* FPS watermark layout in buffer pixels */
+#define WATERMARK_CHAR_WIDTH  12.0f
+#define WATERMARK_CHAR_HEIGHT 18.0f
+#define WATERMARK_MARGIN      10.0f
+
+/* Area the FPS watermark covers for the current reading, 1px shadow included.
+ * Returns false when no watermark is drawn */
+static bool fps_watermark_rect(const struct output_state *output, struct damage_rect *rect) {
+    if (!output->config->show_fps || output->fps_current <= 0.0f) {
+        return false;
+    }
+
+    char fps_text[32];
+    int len = snprintf(fps_text, sizeof(fps_text), "%.1f FPS", output->fps_current);
+    float text_width = (float)len * WATERMARK_CHAR_WIDTH;
+
+    rect->x = (int32_t)floorf((float)output->width - text_width - WATERMARK_MARGIN);
+    rect->y = (int32_t)floorf((float)output->height - WATERMARK_CHAR_HEIGHT - WATERMARK_MARGIN);
+    rect->width = (int32_t)ceilf(text_width) + 2;
+    rect->height = (int32_t)WATERMARK_CHAR_HEIGHT + 2;
+    return true;
+}
+
 /* Render FPS watermark overlay */
 static void render_fps_watermark(struct output_state *output) {
-    if (!output || !output->config->show_fps) return;
-    if (output->fps_current <= 0.0f) return;
+    if (!output) return;
+    if (!fps_watermark_rect(output, &output->watermark_rect)) {
+        memset(&output->watermark_rect, 0, sizeof(output->watermark_rect));
+        return;
+    }
     
     /* Format FPS text */
     char fps_text[32];
@@ -127,11 +158,11 @@ static void render_fps_watermark(struct output_state *output) {
     glEnableVertexAttribArray(pos_attrib);
     
     /* Position at bottom-right corner to avoid taskbar/waybar */
-    float char_width = 12.0f;
-    float char_height = 18.0f;
+    float char_width = WATERMARK_CHAR_WIDTH;
+    float char_height = WATERMARK_CHAR_HEIGHT;
     float text_width = strlen(fps_text) * char_width;
-    float text_x = output->width - text_width - 10.0f;
-    float text_y = output->height - char_height - 10.0f;
+    float text_x = output->width - text_width - WATERMARK_MARGIN;
+    float text_y = output->height - char_height - WATERMARK_MARGIN;
     
     /* Draw black shadow/outline for visibility on any background */
     glUniform4f(color_uniform, 0.0f, 0.0f, 0.0f, 1.0f);
@@ -206,6 +237,7 @@ static void render_fps_watermark(struct output_state *output) {
 /* Global cache for default iChannel textures (generated once, reused forever) */
 static GLuint cached_default_channel_textures[5] = {0, 0, 0, 0, 0};
 static bool default_channels_initialized = false;
+static pthread_mutex_t default_channels_lock = PTHREAD_MUTEX_INITIALIZER; /* Render threads may race here */
 
 /* Fullscreen quad vertices (position + texcoord) */
 static const float quad_vertices[] = {
@@ -221,6 +253,7 @@ static inline void cache_program_uniforms(struct output_state *output) {
     output->program_uniforms.position = glGetAttribLocation(output->program, "position");
     output->program_uniforms.texcoord = glGetAttribLocation(output->program, "texcoord");
     output->program_uniforms.tex_sampler = glGetUniformLocation(output->program, "texture0");
+    output->program_uniforms.alpha = glGetUniformLocation(output->program, "alpha");
 }
 
 /* Helper: Cache uniform locations for transition shaders */
@@ -288,6 +321,8 @@ bool render_init_output(struct output_state *output) {
     output->channel_textures = NULL;
     output->channel_count = 0;
     output->shader_uniforms.iChannel = NULL;
+    output->shader_uniforms.bindings = NULL;
+    output->shader_uniforms.binding_count = 0;
 
     /* Create simple color shader for overlays (once, shared across outputs) */
     if (color_overlay_program == 0) {
@@ -344,6 +379,8 @@ bool render_init_output(struct output_state *output) {
     return true;
 }
 
+static void render_share_release(struct output_state *output);
+
 void render_cleanup_output(struct output_state *output) {
     if (!output) {
         return;
@@ -353,14 +390,19 @@ void render_cleanup_output(struct output_state *output) {
 
     /* Delete textures */
     if (output->texture != 0) {
-        glDeleteTextures(1, &output->texture);
+        render_destroy_texture(output->texture);
         output->texture = 0;
     }
     if (output->next_texture != 0) {
-        glDeleteTextures(1, &output->next_texture);
+        render_destroy_texture(output->next_texture);
         output->next_texture = 0;
     }
     
+    if (output->channel_preload_texture != 0) {
+        glDeleteTextures(1, &output->channel_preload_texture);
+        output->channel_preload_texture = 0;
+    }
+
     /* Delete iChannel textures */
     if (output->channel_textures) {
         for (size_t i = 0; i < output->channel_count; i++) {
@@ -378,6 +420,14 @@ void render_cleanup_output(struct output_state *output) {
         output->shader_uniforms.iChannel = NULL;
     }
     
+    /* Release the render-once target if this output led a group */
+    render_share_release(output);
+    
+    /* Free uniform reflection table */
+    free(output->shader_uniforms.bindings);
+    output->shader_uniforms.bindings = NULL;
+    output->shader_uniforms.binding_count = 0;
+    
     output->channel_count = 0;
 
     /* Delete VBO */
@@ -412,7 +462,7 @@ void render_cleanup_output(struct output_state *output) {
  * Optimized: Set immutable texture parameters only once at creation
  * Memory optimization: Frees pixel data after GPU upload to save RAM */
 GLuint render_create_texture(struct image_data *img) {
-    if (!img || !img->pixels) {
+    if (!img || (!img->pixels && !img->compressed)) {
         log_error("Invalid image data for texture creation");
         return 0;
     }
@@ -431,10 +481,16 @@ GLuint render_create_texture(struct image_data *img) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    /* Upload texture data */
-    GLenum format = (img->channels == 4) ? GL_RGBA : GL_RGB;
-    glTexImage2D(GL_TEXTURE_2D, 0, format, img->width, img->height,
-                 0, format, GL_UNSIGNED_BYTE, img->pixels);
+    /* Upload texture data - ETC2 blocks were encoded on the preload thread,
+     * which only does so when the context is ES 3.0 */
+    if (img->compressed) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, TEXTURE_FORMAT_ETC2_RGB8, img->width, img->height,
+                               0, (GLsizei)img->compressed_size, img->compressed);
+    } else {
+        GLenum format = (img->channels == 4) ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_2D, 0, format, img->width, img->height,
+                     0, format, GL_UNSIGNED_BYTE, img->pixels);
+    }
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -446,8 +502,11 @@ GLuint render_create_texture(struct image_data *img) {
         return 0;
     }
 
-    log_debug("Created texture %u (%ux%u, %d channels)",
-              texture, img->width, img->height, img->channels);
+    log_debug("Created texture %u (%ux%u, %s)", texture, img->width, img->height,
+              img->compressed ? "ETC2" : (img->channels == 4 ? "RGBA" : "RGB"));
+    if (img->compressed) {
+        texture_compress_track(texture, img);
+    }
 
     /* Free pixel data after successful GPU upload - saves massive amounts of RAM!
      * For 4K display: 3840x2160x4 = 33MB saved per image
@@ -458,59 +517,98 @@ GLuint render_create_texture(struct image_data *img) {
     return texture;
 }
 
+/* Sampling configured for a channel (defaults past the configured ones) */
+static struct channel_sampler channel_sampler_for(const struct wallpaper_config *config,
+                                                  size_t channel) {
+    if (config && channel < MAX_CHANNEL_SAMPLERS) {
+        return config->channel_samplers[channel];
+    }
+    return (struct channel_sampler){ CHANNEL_FILTER_LINEAR, CHANNEL_WRAP_DEFAULT, true };
+}
+
 /**
- * Create texture from image for use in shaders (iChannel)
+ * Apply channel_filter/channel_wrap/channel_mipmap to the bound iChannel texture
  * 
- * This version flips the image vertically to match OpenGL texture coordinates
- * where (0,0) is at bottom-left, while image files have (0,0) at top-left.
+ * Without mipmaps every texel of a minified image is fetched each frame; with
+ * them the sampler reads a level close to the on-screen size. ES 2.0 without
+ * GL_OES_texture_npot can neither repeat nor mipmap non-power-of-two textures,
+ * those keep clamped single-level sampling.
  * 
- * @param img Image data to create texture from
- * @return OpenGL texture ID, or 0 on failure
+ * @param output Output whose config applies
+ * @param channel iChannel index
+ * @param width Texture width
+ * @param height Texture height
+ * @param builtin Built-in texture (repeats by default, mip chain already present)
  */
-GLuint render_create_texture_flipped(struct image_data *img) {
-    if (!img || !img->pixels) {
-        log_error("Invalid image data for texture creation");
-        return 0;
+static void apply_channel_sampler(const struct output_state *output, size_t channel,
+                                  uint32_t width, uint32_t height, bool builtin) {
+    struct channel_sampler sampler = channel_sampler_for(output->config, channel);
+    bool pot = (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+    bool npot_ok = output->state &&
+                   (output->state->gl_caps.gles_version >= GLES_VERSION_3_0 ||
+                    output->state->gl_caps.has_oes_texture_npot);
+
+    GLint wrap;
+    switch (sampler.wrap) {
+        case CHANNEL_WRAP_REPEAT: wrap = GL_REPEAT; break;
+        case CHANNEL_WRAP_MIRROR: wrap = GL_MIRRORED_REPEAT; break;
+        case CHANNEL_WRAP_CLAMP:  wrap = GL_CLAMP_TO_EDGE; break;
+        default:                  wrap = builtin ? GL_REPEAT : GL_CLAMP_TO_EDGE; break;
+    }
+    bool mipmap = sampler.mipmap;
+    if (!pot && !npot_ok && (mipmap || wrap != GL_CLAMP_TO_EDGE)) {
+        log_debug("iChannel%zu: %ux%u is not a power of two, sampled clamped without mipmaps",
+                  channel, width, height);
+        wrap = GL_CLAMP_TO_EDGE;
+        mipmap = false;
+    }
+
+    bool nearest = sampler.filter == CHANNEL_FILTER_NEAREST;
+    GLint min_filter = nearest ? GL_NEAREST : GL_LINEAR;
+    if (mipmap) {
+        if (!builtin) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        min_filter = nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
     }
-    
-    /* Note: Caller MUST ensure EGL context is current before calling this function */
 
-    /* Flip the image vertically for OpenGL texture coordinates */
-    size_t row_size = img->width * img->channels;
-    unsigned char *temp_row = malloc(row_size);
-    if (!temp_row) {
-        log_error("Failed to allocate memory for image flip");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+}
+
+/**
+ * Create a shader texture (iChannel) from an image
+ * 
+ * Rows must already be bottom-up, as Shadertoy expects v = 0 at the bottom
+ * for every lookup function; image_load_bounded() decodes or resamples them
+ * in that order.
+ * 
+ * @param output Output the texture is for (its config gives the sampling)
+ * @param channel iChannel index
+ * @param img Image data
+ * @return OpenGL texture ID, or 0 on failure
+ */
+GLuint render_create_channel_texture(struct output_state *output, size_t channel,
+                                     struct image_data *img) {
+    if (!output || !img || !img->pixels) {
+        log_error("Invalid image data for texture creation");
         return 0;
     }
 
-    unsigned char *pixels = img->pixels;
-    for (uint32_t y = 0; y < img->height / 2; y++) {
-        unsigned char *row_top = pixels + y * row_size;
-        unsigned char *row_bottom = pixels + (img->height - 1 - y) * row_size;
-        
-        /* Swap rows */
-        memcpy(temp_row, row_top, row_size);
-        memcpy(row_top, row_bottom, row_size);
-        memcpy(row_bottom, temp_row, row_size);
-    }
-    
-    free(temp_row);
-    log_debug("Flipped image vertically for OpenGL texture coordinates");
+    /* Note: Caller MUST ensure EGL context is current before calling this function */
 
-    /* Now create texture normally */
     GLuint texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
     GLenum format = (img->channels == 4) ? GL_RGBA : GL_RGB;
     glTexImage2D(GL_TEXTURE_2D, 0, format, img->width, img->height,
                  0, format, GL_UNSIGNED_BYTE, img->pixels);
 
+    apply_channel_sampler(output, channel, img->width, img->height, false);
+
     glBindTexture(GL_TEXTURE_2D, 0);
 
     GLenum error = glGetError();
@@ -520,8 +618,8 @@ GLuint render_create_texture_flipped(struct image_data *img) {
         return 0;
     }
 
-    log_debug("Created flipped texture %u (%ux%u, %d channels) for shader use",
-              texture, img->width, img->height, img->channels);
+    log_debug("Created iChannel%zu texture %u (%ux%u, %d channels) for shader use",
+              channel, texture, img->width, img->height, img->channels);
 
     image_free_pixels(img);
     log_debug("Freed pixel data for texture %u (memory optimization)", texture);
@@ -529,12 +627,33 @@ GLuint render_create_texture_flipped(struct image_data *img) {
     return texture;
 }
 
+/* Wallpaper textures shared with other outputs only lose a reference */
 void render_destroy_texture(GLuint texture) {
-    if (texture != 0) {
+    if (texture != 0 && !texture_cache_release(texture)) {
+        texture_compress_untrack(texture);
         glDeleteTextures(1, &texture);
     }
 }
 
+/* Identity of a config's iChannel inputs and their sampling, to tell whether
+ * loaded textures still apply */
+static uint64_t channel_config_key(const struct wallpaper_config *config) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t count = (config && config->channel_paths) ? config->channel_count : 0;
+    hash = (hash ^ count) * 1099511628211ULL;
+    for (size_t i = 0; i < count; i++) {
+        for (const char *p = config->channel_paths[i] ? config->channel_paths[i] : ""; *p; p++) {
+            hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL;
+        struct channel_sampler sampler = channel_sampler_for(config, i);
+        hash = (hash ^ (uint64_t)sampler.filter) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)sampler.wrap) * 1099511628211ULL;
+        hash = (hash ^ (uint64_t)sampler.mipmap) * 1099511628211ULL;
+    }
+    return hash;
+}
+
 /**
  * Load iChannel textures based on configuration
  * 
@@ -614,6 +733,7 @@ bool render_load_channel_textures(struct output_state *output, struct wallpaper_
         /* Try to load texture */
         if (path && !is_default) {
             /* Check if it's a named default texture */
+            bool builtin = true;
             if (strcmp(path, TEXTURE_NAME_RGBA_NOISE) == 0 || strcmp(path, "default") == 0) {
                 texture = texture_create_rgba_noise(DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE);
             } else if (strcmp(path, TEXTURE_NAME_GRAY_NOISE) == 0) {
@@ -625,19 +745,26 @@ bool render_load_channel_textures(struct output_state *output, struct wallpaper_
             } else if (strcmp(path, TEXTURE_NAME_ABSTRACT) == 0) {
                 texture = texture_create_abstract(DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE);
             } else {
-                /* Try to load as image file */
-                struct image_data *img = image_load(path, 0, 0, MODE_FILL);
+                /* Try to load as image file, reduced to the channel size limit */
+                builtin = false;
+                struct image_data *img = image_load_bounded(path, render_channel_max_size(output));
                 if (img) {
-                    /* Use flipped version for shader textures (OpenGL coordinates) */
-                    texture = render_create_texture_flipped(img);
+                    texture = render_create_channel_texture(output, i, img);
                     log_info("iChannel%zu: loaded from %s (%ux%u)", i, path, img->width, img->height);
                     image_free(img);
                 } else {
                     log_error("Failed to load iChannel%zu texture from: %s", i, path);
                 }
             }
+            /* This output's own copy, so its sampling can follow the config */
+            if (texture != 0 && builtin) {
+                glBindTexture(GL_TEXTURE_2D, texture);
+                apply_channel_sampler(output, i, DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE, true);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
         } else {
             /* Use cached default textures (generate once, reuse forever) */
+            pthread_mutex_lock(&default_channels_lock);
             if (!default_channels_initialized) {
                 cached_default_channel_textures[0] = texture_create_rgba_noise(DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE);
                 cached_default_channel_textures[1] = texture_create_gray_noise(DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE);
@@ -646,6 +773,7 @@ bool render_load_channel_textures(struct output_state *output, struct wallpaper_
                 cached_default_channel_textures[4] = texture_create_abstract(DEFAULT_TEXTURE_SIZE, DEFAULT_TEXTURE_SIZE);
                 default_channels_initialized = true;
             }
+            pthread_mutex_unlock(&default_channels_lock);
             
             /* Reuse cached texture */
             if (i < 5) {
@@ -657,15 +785,29 @@ bool render_load_channel_textures(struct output_state *output, struct wallpaper_
         }
         
         output->channel_textures[i] = texture;
+        output->channel_generation++;
         
         if (texture == 0) {
             log_error("iChannel%zu: failed to create texture, will be empty/black", i);
         }
     }
-    
+
+    output->channel_textures_key = channel_config_key(config);
     return true;
 }
 
+/* Largest side of an iChannel image: the configured limit within what the
+ * GPU can sample */
+uint32_t render_channel_max_size(const struct output_state *output) {
+    uint32_t max_size = output->config && output->config->channel_max_size > 0 ?
+                        (uint32_t)output->config->channel_max_size : DEFAULT_CHANNEL_MAX_SIZE;
+    if (output->state && output->state->gl_caps.gles_v20.max_texture_size > 0 &&
+        max_size > (uint32_t)output->state->gl_caps.gles_v20.max_texture_size) {
+        max_size = (uint32_t)output->state->gl_caps.gles_v20.max_texture_size;
+    }
+    return max_size;
+}
+
 /**
  * Update a single iChannel texture with a new image
  * 
@@ -695,13 +837,13 @@ bool render_update_channel_texture(struct output_state *output, size_t channel_i
     
     /* CRITICAL: Ensure EGL context is current before GL operations */
     if (!output->compositor_surface || !eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
         log_error("Failed to make EGL context current for texture update");
         return false;
     }
     
-    /* Load the new image */
-    struct image_data *img = image_load(image_path, 0, 0, MODE_FILL);
+    /* Load the new image, reduced to the channel size limit */
+    struct image_data *img = image_load_bounded(image_path, render_channel_max_size(output));
     if (!img) {
         log_error("Failed to load image for iChannel%zu: %s", channel_index, image_path);
         return false;
@@ -712,8 +854,7 @@ bool render_update_channel_texture(struct output_state *output, size_t channel_i
         glDeleteTextures(1, &output->channel_textures[channel_index]);
     }
     
-    /* Create new flipped texture for shader use */
-    GLuint texture = render_create_texture_flipped(img);
+    GLuint texture = render_create_channel_texture(output, channel_index, img);
     if (texture == 0) {
         log_error("Failed to create texture for iChannel%zu from: %s", channel_index, image_path);
         image_free(img);
@@ -722,6 +863,7 @@ bool render_update_channel_texture(struct output_state *output, size_t channel_i
     
     /* Update the channel texture */
     output->channel_textures[channel_index] = texture;
+    output->channel_generation++;
     
     log_info("Updated iChannel%zu with image: %s (%ux%u) -> texture ID %u", 
              channel_index, image_path, img->width, img->height, texture);
@@ -769,177 +911,109 @@ static void calculate_vertex_coords(struct output_state *output, float vertices[
 
 
 
-/* Render shader wallpaper frame
- * Optimized: Uses state tracking and eliminates redundant GL calls */
-bool render_frame_shader(struct output_state *output) {
-    if (!output || output->live_shader_program == 0) {
-        log_error("Invalid output or shader program for render_frame_shader");
-        return false;
-    }
-    
-    /* Validate EGL context is still valid */
-    if (!output->state || output->state->egl_display == EGL_NO_DISPLAY) {
-        log_error("EGL display not available for shader rendering (display may be disconnected)");
-        return false;
-    }
-    
-    if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) {
-        log_error("EGL surface not available for shader rendering (display may be disconnected)");
-        return false;
-    }
-    
-    /* CRITICAL: Ensure EGL context is current on this thread before any GL operations */
-    if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                       output->compositor_surface->egl_surface, output->state->egl_context)) {
-        log_error("Failed to make EGL context current for shader rendering");
-        return false;
-    }
-
-    /* Set viewport */
-    glViewport(0, 0, output->width, output->height);
-    
-    /* Clear any previous OpenGL errors AFTER context is current (critical for multi-monitor) */
-    while (glGetError() != GL_NO_ERROR);
-    
-    /* Verify errors are cleared */
-    GLenum err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error still present after clearing: 0x%x", err);
-        return false;
-    }
-    
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glViewport: 0x%x", err);
-        return false;
+/* Elapsed shader time in ms (preserves continuity across reloads) */
+static uint64_t render_shader_elapsed_ms(const struct output_state *output, uint64_t now) {
+    uint64_t elapsed_ms = output->shader_time_accum_ms;
+    uint64_t start_time = output->shader_start_time > 0 ? output->shader_start_time : output->last_frame_time;
+    if (start_time > 0 && now >= start_time) {
+        elapsed_ms += now - start_time;
     }
+    return elapsed_ms;
+}
 
-    /* Clear screen */
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glClear: 0x%x", err);
-        return false;
-    }
+/* Shader time in seconds with the speed multiplier applied */
+static float render_shader_time(const struct output_state *output, uint64_t now) {
+    float time = render_shader_elapsed_ms(output, now) / (float)MS_PER_SECOND;
+    float shader_speed = output->config->shader_speed > 0.0f ? output->config->shader_speed : 1.0f;
+    return time * shader_speed;
+}
 
+/* Draw one frame of output's live shader into the bound framebuffer */
+static bool render_shader_pass(struct output_state *output, float time) {
     /* CRITICAL: Always use glUseProgram for shader rendering (not cached) 
      * GL state is per-context, not per-output. When switching between outputs,
      * the cached state can be stale, causing GL_INVALID_OPERATION errors.
      * Shaders are performance-critical, so we can't afford stale state. */
     glUseProgram(output->live_shader_program);
     
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glUseProgram (program=%u): 0x%x", output->live_shader_program, err);
+    if (!GL_CHECK("after glUseProgram (program=%u)", output->live_shader_program)) {
         return false;
     }
 
-    /* Calculate elapsed time for animation (preserve continuity across reloads) */
-    uint64_t current_time = get_time_ms();
-    uint64_t elapsed_ms = output->shader_time_accum_ms;
-    uint64_t start_time = output->shader_start_time > 0 ? output->shader_start_time : output->last_frame_time;
-    if (start_time > 0 && current_time >= start_time) {
-        elapsed_ms += current_time - start_time;
-    }
-    float time = elapsed_ms / (float)MS_PER_SECOND;
-    
-    /* Apply shader speed multiplier */
-    float shader_speed = output->config->shader_speed > 0.0f ? output->config->shader_speed : 1.0f;
-    time *= shader_speed;
-
-    /* Cache shader uniform locations on first use to eliminate per-frame lookups */
+    /* Reflect the program once after it is linked - the frame path never looks up names */
     if (output->shader_uniforms.position == -2) {
         /* -2 means uninitialized, -1 means not found, >= 0 is valid location */
         output->shader_uniforms.position = glGetAttribLocation(output->live_shader_program, "position");
-        output->shader_uniforms.u_time = glGetUniformLocation(output->live_shader_program, "_neowall_time");
-        output->shader_uniforms.u_resolution = glGetUniformLocation(output->live_shader_program, "_neowall_resolution");
-        
-        /* Also get iResolution uniform location (Shadertoy vec3) */
-        GLint iResolution_loc = glGetUniformLocation(output->live_shader_program, "iResolution");
-        if (iResolution_loc >= 0) {
-            /* Set iResolution as vec3(width, height, aspect_ratio) */
-            float aspect = (float)output->width / (float)output->height;
-            glUniform3f(iResolution_loc, (float)output->width, (float)output->height, aspect);
+
+        free(output->shader_uniforms.bindings);
+        if (!shader_reflect_uniforms(output->live_shader_program,
+                                     &output->shader_uniforms.bindings,
+                                     &output->shader_uniforms.binding_count)) {
+            return false;
         }
-        
-        /* Cache iChannel sampler locations */
-        if (output->shader_uniforms.iChannel && output->channel_count > 0) {
+        output->shader_uniforms.shared = shader_cache_lookup(output->live_shader_program);
+
+        output->shader_uniforms.u_time = -1;
+        output->shader_uniforms.u_resolution = -1;
+        if (output->shader_uniforms.iChannel) {
             for (size_t i = 0; i < output->channel_count; i++) {
-                char sampler_name[32];
-                snprintf(sampler_name, sizeof(sampler_name), "iChannel%zu", i);
-                output->shader_uniforms.iChannel[i] = glGetUniformLocation(output->live_shader_program, sampler_name);
+                output->shader_uniforms.iChannel[i] = -1;
+            }
+        }
+        for (size_t i = 0; i < output->shader_uniforms.binding_count; i++) {
+            const struct shader_uniform_binding *binding = &output->shader_uniforms.bindings[i];
+            if (binding->role == SHADER_UNIFORM_TIME) {
+                output->shader_uniforms.u_time = binding->location;
+            } else if (binding->role == SHADER_UNIFORM_RESOLUTION) {
+                output->shader_uniforms.u_resolution = binding->location;
+            } else if (binding->role == SHADER_UNIFORM_CHANNEL && output->shader_uniforms.iChannel &&
+                       binding->channel < output->channel_count) {
+                output->shader_uniforms.iChannel[binding->channel] = binding->location;
             }
-            log_debug("Cached %zu iChannel uniform locations", output->channel_count);
         }
     }
 
-    /* Set uniforms using cached locations */
-    if (output->shader_uniforms.u_time >= 0) {
-        glUniform1f(output->shader_uniforms.u_time, time);
-    }
-
-    if (output->shader_uniforms.u_resolution >= 0) {
-        glUniform2f(output->shader_uniforms.u_resolution, (float)output->width, (float)output->height);
-    }
-    
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after cached uniforms: 0x%x", err);
-        return false;
-    }
-    
-    /* Also try direct uniform names for non-Shadertoy shaders */
-    GLint time_loc = glGetUniformLocation(output->live_shader_program, "time");
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glGetUniformLocation('time'): 0x%x", err);
-        return false;
-    }
-    
-    if (time_loc >= 0) {
-        glUniform1f(time_loc, time);
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            log_error("OpenGL error after glUniform1f('time'): 0x%x", err);
-            return false;
+    /* Upload only bound inputs whose value changed since the last frame. A program
+     * shared with other outputs may hold their values, so start over after them. */
+    if (!shader_cache_claim_uniforms(output->shader_uniforms.shared, output)) {
+        for (size_t i = 0; i < output->shader_uniforms.binding_count; i++) {
+            output->shader_uniforms.bindings[i].uploaded = false;
         }
     }
-    
-    GLint resolution_loc = glGetUniformLocation(output->live_shader_program, "resolution");
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glGetUniformLocation('resolution'): 0x%x", err);
-        return false;
-    }
-    
-    if (resolution_loc >= 0) {
-        glUniform2f(resolution_loc, (float)output->width, (float)output->height);
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            log_error("OpenGL error after glUniform2f('resolution'): 0x%x", err);
-            return false;
+    float aspect = (float)output->width / (float)output->height;
+    for (size_t i = 0; i < output->shader_uniforms.binding_count; i++) {
+        struct shader_uniform_binding *binding = &output->shader_uniforms.bindings[i];
+        switch (binding->role) {
+            case SHADER_UNIFORM_TIME:
+                if (!binding->uploaded || binding->value[0] != time) {
+                    glUniform1f(binding->location, time);
+                    binding->value[0] = time;
+                }
+                break;
+            case SHADER_UNIFORM_RESOLUTION:
+            case SHADER_UNIFORM_RESOLUTION3:
+                if (!binding->uploaded || binding->value[0] != (float)output->width ||
+                    binding->value[1] != (float)output->height) {
+                    binding->value[0] = (float)output->width;
+                    binding->value[1] = (float)output->height;
+                    binding->value[2] = aspect;
+                    if (binding->role == SHADER_UNIFORM_RESOLUTION) {
+                        glUniform2fv(binding->location, 1, binding->value);
+                    } else {
+                        glUniform3fv(binding->location, 1, binding->value);
+                    }
+                }
+                break;
+            case SHADER_UNIFORM_CHANNEL:
+                /* Sampler units are set once at reflection */
+                break;
         }
+        binding->uploaded = true;
     }
     
-    /* Update iResolution uniform (Shadertoy vec3) every frame in case resolution changes */
-    GLint iResolution_loc = glGetUniformLocation(output->live_shader_program, "iResolution");
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glGetUniformLocation('iResolution'): 0x%x", err);
+    if (!GL_CHECK("after uniform upload")) {
         return false;
     }
-    
-    if (iResolution_loc >= 0) {
-        float aspect = (float)output->width / (float)output->height;
-        glUniform3f(iResolution_loc, (float)output->width, (float)output->height, aspect);
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            log_error("OpenGL error after glUniform3f('iResolution'): 0x%x", err);
-            return false;
-        }
-    }
 
     /* Bind iChannel textures if they exist */
     if (output->channel_textures && output->shader_uniforms.iChannel) {
@@ -947,23 +1021,12 @@ bool render_frame_shader(struct output_state *output) {
         for (size_t i = 0; i < output->channel_count; i++) {
             if (output->channel_textures[i] != 0 && output->shader_uniforms.iChannel[i] >= 0) {
                 glActiveTexture(GL_TEXTURE0 + (GLenum)i);
-                err = glGetError();
-                if (err != GL_NO_ERROR) {
-                    log_error("OpenGL error after glActiveTexture(GL_TEXTURE%zu): 0x%x", i, err);
+                if (!GL_CHECK("after glActiveTexture(GL_TEXTURE%zu)", i)) {
                     return false;
                 }
                 
                 glBindTexture(GL_TEXTURE_2D, output->channel_textures[i]);
-                err = glGetError();
-                if (err != GL_NO_ERROR) {
-                    log_error("OpenGL error after glBindTexture(iChannel%zu, ID=%u): 0x%x", i, output->channel_textures[i], err);
-                    return false;
-                }
-                
-                glUniform1i(output->shader_uniforms.iChannel[i], (GLint)i);
-                err = glGetError();
-                if (err != GL_NO_ERROR) {
-                    log_error("OpenGL error after glUniform1i(iChannel%zu): 0x%x", i, err);
+                if (!GL_CHECK("after glBindTexture(iChannel%zu, ID=%u)", i, output->channel_textures[i])) {
                     return false;
                 }
                 
@@ -979,9 +1042,7 @@ bool render_frame_shader(struct output_state *output) {
     }
     
     /* Check for errors after uniform/texture setup */
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after uniform/texture setup: 0x%x", err);
+    if (!GL_CHECK("after uniform/texture setup")) {
         return false;
     }
 
@@ -997,26 +1058,20 @@ bool render_frame_shader(struct output_state *output) {
      * We just reinterpret it: first 2 floats of each vertex are positions. */
     glBindBuffer(GL_ARRAY_BUFFER, output->vbo);
     
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glBindBuffer (vbo=%u): 0x%x", output->vbo, err);
+    if (!GL_CHECK("after glBindBuffer (vbo=%u)", output->vbo)) {
         return false;
     }
 
     /* Set up vertex attributes - stride of 4 floats to skip texcoords */
     glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glVertexAttribPointer (attrib=%d): 0x%x", pos_attrib, err);
+    if (!GL_CHECK("after glVertexAttribPointer (attrib=%d)", pos_attrib)) {
         return false;
     }
     
     glEnableVertexAttribArray(pos_attrib);
     
-    err = glGetError();
-    if (err != GL_NO_ERROR) {
-        log_error("OpenGL error after glEnableVertexAttribArray (attrib=%d): 0x%x", pos_attrib, err);
+    if (!GL_CHECK("after glEnableVertexAttribArray (attrib=%d)", pos_attrib)) {
         return false;
     }
 
@@ -1030,9 +1085,7 @@ bool render_frame_shader(struct output_state *output) {
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     
     /* Check for GL errors */
-    GLenum gl_error = glGetError();
-    if (gl_error != GL_NO_ERROR) {
-        log_error("OpenGL error after shader draw: 0x%x (display may be disconnected)", gl_error);
+    if (!GL_CHECK("after shader draw (display may be disconnected)")) {
         return false;
     }
 
@@ -1040,6 +1093,329 @@ bool render_frame_shader(struct output_state *output) {
     glDisableVertexAttribArray(pos_attrib);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    return true;
+}
+
+/* ---------------------------------------------------------------------------
+ * Render once, present many
+ *
+ * Outputs running the same shader file at the same size, speed, inputs and
+ * time base would draw identical frames. The first such output in the list
+ * leads: the group's frame is rendered once into the leader's offscreen
+ * target, and every member (leader included) presents it with a textured
+ * quad. Whichever member is due first renders the frame; members presenting
+ * within half a refresh period reuse it. Only outputs on the main render
+ * context take part, since the target is not fenced across threads.
+ * ------------------------------------------------------------------------- */
+
+static bool render_share_eligible(const struct output_state *output) {
+    return output->render_thread == NULL &&
+           output->config->type == WALLPAPER_SHADER &&
+           output->live_shader_program != 0 &&
+           !output->shader_load_failed &&
+           output->shader_fade_start_time == 0 &&
+           output->compositor_surface &&
+           output->compositor_surface->egl_surface != EGL_NO_SURFACE;
+}
+
+/* Same iChannel inputs: configured channels with their sampling and, when images cycle through iChannel0, the current image */
+static bool render_share_inputs_match(const struct wallpaper_config *a, const struct wallpaper_config *b) {
+    if (a->channel_count != b->channel_count) {
+        return false;
+    }
+    for (size_t i = 0; i < a->channel_count; i++) {
+        const char *pa = a->channel_paths ? a->channel_paths[i] : NULL;
+        const char *pb = b->channel_paths ? b->channel_paths[i] : NULL;
+        if ((pa == NULL) != (pb == NULL) || (pa && strcmp(pa, pb) != 0)) {
+            return false;
+        }
+    }
+    if (memcmp(a->channel_samplers, b->channel_samplers, sizeof(a->channel_samplers)) != 0) {
+        return false;
+    }
+
+    if (a->cycle != b->cycle) {
+        return false;
+    }
+    if (a->cycle && a->cycle_paths && b->cycle_paths &&
+        a->current_cycle_index < a->cycle_count && b->current_cycle_index < b->cycle_count) {
+        return strcmp(a->cycle_paths[a->current_cycle_index],
+                      b->cycle_paths[b->current_cycle_index]) == 0;
+    }
+    return true;
+}
+
+static bool render_share_matches(const struct output_state *a, const struct output_state *b,
+                                 uint64_t now) {
+    if (!render_share_eligible(b) ||
+        a->width != b->width || a->height != b->height ||
+        strcmp(a->current_shader_path, b->current_shader_path) != 0 ||
+        a->config->shader_speed != b->config->shader_speed ||
+        !render_share_inputs_match(a->config, b->config)) {
+        return false;
+    }
+
+    uint64_t ta = render_shader_elapsed_ms(a, now);
+    uint64_t tb = render_shader_elapsed_ms(b, now);
+    return (ta > tb ? ta - tb : tb - ta) <= SHADER_SHARE_SYNC_MS;
+}
+
+/* Leader of the group output belongs to, NULL if no other output shows the same frame */
+static struct output_state *render_share_leader(struct output_state *output, uint64_t now) {
+    if (!render_share_eligible(output)) {
+        return NULL;
+    }
+
+    struct output_state *leader = NULL;
+    bool shared = false;
+    for (struct output_state *other = output->state->outputs; other; other = other->next) {
+        if (other != output && !render_share_matches(output, other, now)) {
+            continue;
+        }
+        if (!leader) {
+            leader = other;
+        }
+        if (other != output) {
+            shared = true;
+        }
+    }
+    return shared ? leader : NULL;
+}
+
+static void render_share_release(struct output_state *output) {
+    if (output->shared_target.fbo) {
+        glDeleteFramebuffers(1, &output->shared_target.fbo);
+    }
+    if (output->shared_target.texture) {
+        glDeleteTextures(1, &output->shared_target.texture);
+    }
+    memset(&output->shared_target, 0, sizeof(output->shared_target));
+}
+
+/* (Re)create the leader's offscreen target at the group's size */
+static bool render_share_ensure_target(struct output_state *leader) {
+    if (leader->shared_target.fbo &&
+        leader->shared_target.width == leader->width &&
+        leader->shared_target.height == leader->height) {
+        return true;
+    }
+
+    render_share_release(leader);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, leader->width, leader->height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        log_error("Shared shader target incomplete for output %s: 0x%x", leader->model, status);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &texture);
+        return false;
+    }
+
+    leader->shared_target.fbo = fbo;
+    leader->shared_target.texture = texture;
+    leader->shared_target.width = leader->width;
+    leader->shared_target.height = leader->height;
+    log_info("Output %s renders its shader once for all matching outputs (%dx%d)",
+             leader->model, leader->width, leader->height);
+    return true;
+}
+
+/* Render the group's frame into the leader's target unless a fresh one is there */
+static bool render_share_update(struct output_state *leader, struct output_state *output, uint64_t now) {
+    if (!render_share_ensure_target(leader)) {
+        return false;
+    }
+
+    bool time_independent = leader->shader_uniforms.u_time == -1;
+    double period_ms = output->refresh_mhz > 0 ? 1000000.0 / output->refresh_mhz
+                                               : (double)FRAME_TIME_MS;
+    if (leader->shared_target.rendered_at > 0 &&
+        leader->shared_target.program == leader->live_shader_program &&
+        leader->shared_target.channel_generation == leader->channel_generation &&
+        (time_independent || (double)(now - leader->shared_target.rendered_at) * 2.0 < period_ms)) {
+        return true;
+    }
+
+    /* The group's frame covers the whole target regardless of this output's damage */
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    if (scissor) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, leader->shared_target.fbo);
+    glViewport(0, 0, leader->width, leader->height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    bool ok = render_shader_pass(leader, render_shader_time(leader, now));
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, output->width, output->height);
+
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    /* Channel binding in the pass left other texture units active */
+    glActiveTexture(GL_TEXTURE0);
+    output->gl_state.bound_texture = 0;
+    output->gl_state.active_program = 0;
+
+    if (!ok) {
+        leader->shared_target.rendered_at = 0;
+        return false;
+    }
+    leader->shared_target.program = leader->live_shader_program;
+    leader->shared_target.channel_generation = leader->channel_generation;
+    leader->shared_target.rendered_at = now;
+    return true;
+}
+
+/* Present the group's frame on output's surface */
+static bool render_share_present(struct output_state *output, struct output_state *leader) {
+    /* The target is stored bottom-up: flip the quad's top-down texcoords */
+    static const float flipped_quad[] = {
+        -1.0f,  1.0f,    0.0f, 1.0f,
+         1.0f,  1.0f,    1.0f, 1.0f,
+        -1.0f, -1.0f,    0.0f, 0.0f,
+         1.0f, -1.0f,    1.0f, 0.0f
+    };
+
+    set_blend_state(output, false);
+    use_program_cached(output, output->program);
+
+    GLint pos_attrib = output->program_uniforms.position;
+    GLint tex_attrib = output->program_uniforms.texcoord;
+
+    /* Client-side vertices leave the persistent quad VBO untouched */
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), flipped_quad);
+    glEnableVertexAttribArray(pos_attrib);
+    glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), flipped_quad + 2);
+    glEnableVertexAttribArray(tex_attrib);
+
+    glActiveTexture(GL_TEXTURE0);
+    bind_texture_cached(output, leader->shared_target.texture);
+    if (output->program_uniforms.tex_sampler >= 0) {
+        glUniform1i(output->program_uniforms.tex_sampler, 0);
+    }
+    if (output->program_uniforms.alpha >= 0) {
+        glUniform1f(output->program_uniforms.alpha, 1.0f);
+    }
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(pos_attrib);
+    glDisableVertexAttribArray(tex_attrib);
+
+    return GL_CHECK("presenting shared shader frame");
+}
+
+/* Render shader wallpaper frame
+ * Optimized: Uses state tracking and eliminates redundant GL calls */
+bool render_frame_shader(struct output_state *output) {
+    if (!output || output->live_shader_program == 0) {
+        log_error("Invalid output or shader program for render_frame_shader");
+        return false;
+    }
+    
+    /* Validate EGL context is still valid */
+    if (!output->state || output->state->egl_display == EGL_NO_DISPLAY) {
+        log_error("EGL display not available for shader rendering (display may be disconnected)");
+        return false;
+    }
+    
+    if (!output->compositor_surface || output->compositor_surface->egl_surface == EGL_NO_SURFACE) {
+        log_error("EGL surface not available for shader rendering (display may be disconnected)");
+        return false;
+    }
+    
+    /* CRITICAL: Ensure EGL context is current on this thread before any GL operations */
+    if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
+                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
+        log_error("Failed to make EGL context current for shader rendering");
+        return false;
+    }
+
+    /* The cycle reached the preloaded entry: claim the lookahead once it is ready */
+    if (output->pending_shader_path[0] != '\0' && output->shader_preload_path[0] != '\0' &&
+        strcmp(output->pending_shader_path, output->shader_preload_path) == 0 &&
+        atomic_exchange(&output->shader_preload_ready, false)) {
+        output->pending_shader_program = output->shader_preload_program;
+        output->shader_preload_program = 0;
+        output->shader_preload_path[0] = '\0';
+        atomic_store(&output->shader_compile_ready, true);
+    }
+
+    /* Background compile finished: fade to the new shader, or keep the current one */
+    if (atomic_exchange(&output->shader_compile_ready, false)) {
+        if (output->pending_shader_program != 0) {
+            output->shader_fade_start_time = get_time_ms();
+        } else {
+            log_error("Failed to compile shader %s, keeping current shader", output->pending_shader_path);
+            output->pending_shader_path[0] = '\0';
+        }
+    }
+
+    /* Set viewport */
+    glViewport(0, 0, output->width, output->height);
+    
+    /* Clear any previous OpenGL errors AFTER context is current (critical for multi-monitor) */
+    GL_CLEAR_ERRORS();
+    
+    if (!GL_CHECK("after glViewport")) {
+        return false;
+    }
+
+    /* Clear screen */
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    
+    if (!GL_CHECK("after glClear")) {
+        return false;
+    }
+
+    uint64_t current_time = get_time_ms();
+
+    struct output_state *leader = render_share_leader(output, current_time);
+    if (leader) {
+        /* Keep members on the leader's clock so they show exactly its frame */
+        if (leader != output) {
+            output->shader_start_time = leader->shader_start_time;
+            output->shader_time_accum_ms = leader->shader_time_accum_ms;
+            /* Frame pacing follows the program actually drawn */
+            if (leader->shader_uniforms.position != -2) {
+                output->shader_uniforms.u_time = leader->shader_uniforms.u_time;
+            }
+        }
+        if (!render_share_update(leader, output, current_time) ||
+            !render_share_present(output, leader)) {
+            return false;
+        }
+    } else {
+        /* No longer leading a group */
+        if (output->shared_target.fbo) {
+            render_share_release(output);
+        }
+        if (!render_shader_pass(output, render_shader_time(output, current_time))) {
+            return false;
+        }
+    }
+
     /* Handle cross-fade transition when switching shaders */
     const uint64_t FADE_OUT_MS = SHADER_FADE_OUT_MS;  /* Fade to black duration */
     const uint64_t FADE_IN_MS = SHADER_FADE_IN_MS;    /* Fade from black duration */
@@ -1088,24 +1464,33 @@ bool render_frame_shader(struct output_state *output) {
                 /* Ensure EGL context is current before compiling shader */
                 if (output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE && output->state) {
                     if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                                       output->compositor_surface->egl_surface, output->state->egl_context)) {
+                                       output->compositor_surface->egl_surface, render_thread_context_for(output))) {
                         log_error("Failed to make EGL context current during shader swap: 0x%x", eglGetError());
                         output->shader_fade_start_time = 0;
                         output->pending_shader_path[0] = '\0';
+                        if (output->pending_shader_program != 0) {
+                            shader_destroy_program(output->pending_shader_program);
+                            output->pending_shader_program = 0;
+                        }
                         /* Continue with current shader */
                         return true;
                     }
                 }
                 
-                /* Reload iChannel textures for the new shader (config may have changed) */
-                if (!render_load_channel_textures(output, output->config)) {
+                /* Reload iChannel textures only if the channel config changed -
+                 * playlist entries share them */
+                if ((!output->channel_textures ||
+                     output->channel_textures_key != channel_config_key(output->config)) &&
+                    !render_load_channel_textures(output, output->config)) {
                     log_error("Failed to reload iChannel textures for new shader: %s", output->pending_shader_path);
                     /* Continue anyway - shader may work without textures */
                 }
                 
-                /* Load the new shader */
-                GLuint new_shader_program = 0;
-                if (shader_create_live_program(output->pending_shader_path, &new_shader_program, output->channel_count)) {
+                /* Swap in the background-compiled program; compile here only without one */
+                GLuint new_shader_program = output->pending_shader_program;
+                output->pending_shader_program = 0;
+                if (new_shader_program != 0 ||
+                    shader_create_live_program(output->pending_shader_path, &new_shader_program, output->channel_count)) {
                     /* Validate the new shader program before destroying old one */
                     if (new_shader_program == 0) {
                         log_error("Invalid shader program created for: %s", output->pending_shader_path);
@@ -1162,8 +1547,9 @@ bool render_frame_shader(struct output_state *output) {
                     
                     log_info("Shader switched during cross-fade: %s", output->pending_shader_path);
                     
-                    /* Clear pending path */
+                    /* Clear pending path and start compiling the entry after it */
                     output->pending_shader_path[0] = '\0';
+                    output_preload_next_wallpaper(output);
                 } else {
                     log_error("Failed to load pending shader: %s", output->pending_shader_path);
                     
@@ -1227,22 +1613,100 @@ bool render_frame_shader(struct output_state *output) {
     }
 
     /* Check for errors */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        log_error("OpenGL error during shader rendering: 0x%x", error);
+    if (!GL_CHECK("during shader rendering")) {
         return false;
     }
 
     /* Render FPS watermark if enabled */
     render_fps_watermark(output);
 
-    /* Shader wallpapers need continuous redraw for animation */
+    /* Keep redrawing until presented; time-independent shaders stop there */
     output->needs_redraw = true;
     output->frames_rendered++;
 
     return true;
 }
 
+static bool damage_rect_empty(const struct damage_rect *rect) {
+    return rect->width <= 0 || rect->height <= 0;
+}
+
+/* Grow dst to the bounding box of dst and src */
+static void damage_rect_union(struct damage_rect *dst, const struct damage_rect *src) {
+    if (damage_rect_empty(src)) {
+        return;
+    }
+    if (damage_rect_empty(dst)) {
+        *dst = *src;
+        return;
+    }
+
+    int32_t x1 = dst->x + dst->width > src->x + src->width ? dst->x + dst->width : src->x + src->width;
+    int32_t y1 = dst->y + dst->height > src->y + src->height ? dst->y + dst->height : src->y + src->height;
+    dst->x = dst->x < src->x ? dst->x : src->x;
+    dst->y = dst->y < src->y ? dst->y : src->y;
+    dst->width = x1 - dst->x;
+    dst->height = y1 - dst->y;
+}
+
+static void damage_rect_clip(struct damage_rect *rect, const struct damage_rect *bounds) {
+    int32_t x1 = rect->x + rect->width < bounds->x + bounds->width ?
+                 rect->x + rect->width : bounds->x + bounds->width;
+    int32_t y1 = rect->y + rect->height < bounds->y + bounds->height ?
+                 rect->y + rect->height : bounds->y + bounds->height;
+    rect->x = rect->x > bounds->x ? rect->x : bounds->x;
+    rect->y = rect->y > bounds->y ? rect->y : bounds->y;
+    rect->width = x1 - rect->x;
+    rect->height = y1 - rect->y;
+}
+
+/* Decide what this frame changes (frame_damage, reported to the compositor) and
+ * limit drawing to what the back buffer is missing. A requested redraw damages
+ * everything; otherwise this is a watermark-only refresh covering the old and new
+ * watermark. With a known buffer age only that damage plus whatever changed since
+ * the buffer was last shown is repainted, everything else is still valid */
+static void render_setup_damage(struct output_state *output) {
+    struct damage_rect full = { 0, 0, output->width, output->height };
+    struct damage_rect damage = full;
+
+    if (!output->needs_redraw) {
+        struct damage_rect watermark;
+        damage = output->watermark_rect;
+        if (fps_watermark_rect(output, &watermark)) {
+            damage_rect_union(&damage, &watermark);
+        }
+        damage_rect_clip(&damage, &full);
+        if (damage_rect_empty(&damage)) {
+            damage = full;
+        }
+    }
+    output->frame_damage = damage;
+
+    struct damage_rect repaint = damage;
+    EGLint age = egl_core_buffer_age(output->state, output);
+    if (age <= 0 || age > DAMAGE_HISTORY_LEN + 1) {
+        repaint = full;
+    } else {
+        for (EGLint i = 0; i < age - 1; i++) {
+            if (damage_rect_empty(&output->damage_history[i])) {
+                repaint = full;
+                break;
+            }
+            damage_rect_union(&repaint, &output->damage_history[i]);
+        }
+    }
+
+    if (repaint.x == full.x && repaint.y == full.y &&
+        repaint.width == full.width && repaint.height == full.height) {
+        glDisable(GL_SCISSOR_TEST);
+    } else {
+        /* GL window coordinates start bottom-left */
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(repaint.x, output->height - repaint.y - repaint.height,
+                  repaint.width, repaint.height);
+    }
+}
+
 /* Render a frame for an output
  * Optimized: Uses cached uniforms, state tracking, and persistent VBO */
 bool render_frame(struct output_state *output) {
@@ -1255,7 +1719,7 @@ bool render_frame(struct output_state *output) {
     if (output->state && output->state->egl_display != EGL_NO_DISPLAY &&
         output->compositor_surface && output->compositor_surface->egl_surface != EGL_NO_SURFACE) {
         if (!eglMakeCurrent(output->state->egl_display, output->compositor_surface->egl_surface,
-                           output->compositor_surface->egl_surface, output->state->egl_context)) {
+                           output->compositor_surface->egl_surface, render_thread_context_for(output))) {
             log_error("Failed to make EGL context current for rendering");
             return false;
         }
@@ -1282,6 +1746,8 @@ bool render_frame(struct output_state *output) {
         return false;
     }
 
+    render_setup_damage(output);
+
     /* Check if this is a shader wallpaper */
     if (output->config->type == WALLPAPER_SHADER) {
         /* Check if shader loading has permanently failed */
@@ -1424,9 +1890,7 @@ bool render_frame(struct output_state *output) {
     bind_texture_cached(output, output->texture);
     
     /* Check if bind succeeded */
-    GLenum bind_error = glGetError();
-    if (bind_error != GL_NO_ERROR) {
-        log_error("OpenGL error binding texture %u: 0x%x", output->texture, bind_error);
+    if (!GL_CHECK("binding texture %u", output->texture)) {
         return false;
     }
 
@@ -1435,10 +1899,9 @@ bool render_frame(struct output_state *output) {
         glUniform1i(output->program_uniforms.tex_sampler, 0);
     }
 
-    /* Set alpha uniform (for transitions) - lookup once per frame is acceptable */
-    GLint alpha_uniform = glGetUniformLocation(output->program, "alpha");
-    if (alpha_uniform >= 0) {
-        glUniform1f(alpha_uniform, 1.0f);
+    /* Set alpha uniform (for transitions) - use cached location */
+    if (output->program_uniforms.alpha >= 0) {
+        glUniform1f(output->program_uniforms.alpha, 1.0f);
     }
 
     /* Handle tile mode texture wrapping - only change when needed */
@@ -1463,9 +1926,7 @@ bool render_frame(struct output_state *output) {
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     
     /* Check for GL errors */
-    GLenum gl_error = glGetError();
-    if (gl_error != GL_NO_ERROR) {
-        log_error("OpenGL error after draw: 0x%x (display may be disconnected)", gl_error);
+    if (!GL_CHECK("after draw (display may be disconnected)")) {
         return false;
     }
 
@@ -1475,9 +1936,7 @@ bool render_frame(struct output_state *output) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     /* Check for errors */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        log_error("OpenGL error during rendering: 0x%x", error);
+    if (!GL_CHECK("during rendering")) {
         return false;
     }
 
@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "neowall.h"
+#include "constants.h"
+#include "compositor.h"
+#include "render_thread.h"
+#include "egl/egl_core.h"
+#include "gl_debug.h"
+
+/*
+ * ============================================================================
+ * PER-OUTPUT RENDER THREADS
+ * ============================================================================
+ *
+ * In the default mode the main thread renders every output in sequence and
+ * then swaps them in sequence, so a slow swap on one monitor delays all the
+ * others. With --threaded-render each output is driven by its own thread:
+ *
+ * - Private EGL context created with the main context as share_context, so
+ *   textures, programs and buffers created anywhere stay visible everywhere
+ * - Private wl_event_queue; the frame callback is requested through a
+ *   queue-bound wrapper of the output's wl_surface so only this thread
+ *   dispatches it
+ * - Cycling (timer-driven and 'next' requests forwarded by the main thread),
+ *   preload uploads, rendering and presentation for the output
+ *
+ * The main thread keeps config loading/reload, IPC and signal handling.
+ * Threads are stopped around config reload and output removal.
+ *
+ * LOCKING:
+ * Rendering holds output_list_lock (read) like the main loop does, but taken
+ * with tryrdlock so a writer that joins this thread can never deadlock it.
+ * The lock is dropped before presenting since eglSwapBuffers may block.
+ */
+
+extern atomic_bool reload_in_progress;  /* Defined in config.c */
+
+struct render_thread {
+    struct neowall_state *state;
+    struct output_state *output;
+    pthread_t thread;
+    atomic_bool_t stop;                 /* Set by owner to end the thread */
+    atomic_bool_t cycle_requested;      /* 'next' request forwarded from main thread */
+    int wakeup_fd;                      /* eventfd to interrupt poll() */
+    EGLContext context;                 /* Private context in the main share group */
+    struct wl_event_queue *queue;       /* Queue for this output's frame callbacks */
+    struct wl_surface *surface_wrapper; /* wl_surface proxy bound to queue */
+};
+
+/* Render thread owning the calling thread, NULL on the main thread */
+static _Thread_local struct render_thread *current_render_thread = NULL;
+
+/* Wake a render thread blocked in poll() */
+static void render_thread_wake(struct render_thread *rt) {
+    uint64_t value = 1;
+    if (write(rt->wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        log_debug("Failed to wake render thread: %s", strerror(errno));
+    }
+}
+
+/* Block until a Wayland event for our queue, a wakeup or the timeout */
+static void wait_for_events(struct render_thread *rt, int timeout_ms) {
+    struct wl_display *display = rt->state->display;
+
+    while (wl_display_prepare_read_queue(display, rt->queue) != 0) {
+        if (wl_display_dispatch_queue_pending(display, rt->queue) < 0) {
+            log_error("Render thread [%s]: failed to dispatch event queue", rt->output->model);
+            atomic_store(&rt->stop, true);
+            return;
+        }
+    }
+
+    wl_display_flush(display);
+
+    struct pollfd fds[2];
+    fds[0].fd = wl_display_get_fd(display);
+    fds[0].events = POLLIN;
+    fds[1].fd = rt->wakeup_fd;
+    fds[1].events = POLLIN;
+
+    int ret = poll(fds, 2, timeout_ms);
+    if (ret > 0 && (fds[0].revents & POLLIN)) {
+        if (wl_display_read_events(display) < 0) {
+            log_error("Render thread [%s]: failed to read Wayland events", rt->output->model);
+            atomic_store(&rt->stop, true);
+            return;
+        }
+    } else {
+        wl_display_cancel_read(display);
+    }
+
+    if (ret > 0 && (fds[1].revents & POLLIN)) {
+        uint64_t value;
+        ssize_t s = read(rt->wakeup_fd, &value, sizeof(value));
+        (void)s;
+    }
+
+    wl_display_dispatch_queue_pending(display, rt->queue);
+}
+
+static void *render_thread_func(void *arg) {
+    struct render_thread *rt = arg;
+    struct neowall_state *state = rt->state;
+    struct output_state *output = rt->output;
+    EGLSurface egl_surface = output->compositor_surface->egl_surface;
+
+    current_render_thread = rt;
+    eglBindAPI(EGL_OPENGL_ES_API);
+    if (!eglMakeCurrent(state->egl_display, egl_surface, egl_surface, rt->context)) {
+        log_error("Render thread [%s]: failed to make context current: 0x%x",
+                  output->model, eglGetError());
+        return NULL;
+    }
+    eglSwapInterval(state->egl_display, 0);
+    gl_debug_setup_context();
+
+    /* Fresh context: bring GL state in line with a cleared state cache */
+    glUseProgram(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_BLEND);
+    output->gl_state.active_program = 0;
+    output->gl_state.bound_texture = 0;
+    output->gl_state.blend_enabled = false;
+    output->needs_redraw = true;
+
+    log_info("Render thread started for output %s", output->model);
+
+    while (!atomic_load_explicit(&rt->stop, memory_order_acquire) &&
+           atomic_load_explicit(&state->running, memory_order_acquire)) {
+        uint64_t now = get_time_ms();
+        int timeout_ms = 1000;
+        bool rendered = false;
+        bool render_success = false;
+
+        if (pthread_rwlock_tryrdlock(&state->output_list_lock) != 0) {
+            /* Writer active (reload/hotplug) - back off briefly */
+            wait_for_events(rt, 1);
+            continue;
+        }
+
+        if (!atomic_load_explicit(&reload_in_progress, memory_order_acquire)) {
+            /* 'next' request forwarded from the main thread */
+            if (atomic_exchange(&rt->cycle_requested, false)) {
+                output_cycle_wallpaper(output);
+                now = get_time_ms();
+            }
+
+            /* Timer-driven cycling */
+            if (!atomic_load_explicit(&state->paused, memory_order_acquire) &&
+                output_should_cycle(output, now)) {
+                output_cycle_wallpaper(output);
+                now = get_time_ms();
+            }
+
+            /* Preload completion */
+            if (atomic_load(&output->preload_upload_pending)) {
+                event_loop_upload_preload(state, output);
+            }
+
+            if (event_loop_output_needs_frame(output, now) && event_loop_output_frame_due(output, now)) {
+                render_success = event_loop_render_output(state, output);
+                rendered = true;
+            }
+        }
+
+        pthread_rwlock_unlock(&state->output_list_lock);
+
+        /* Present without locks held - the swap may block on this output only */
+        if (rendered && render_success) {
+            event_loop_present_output(state, output, now, rt->surface_wrapper);
+        }
+
+        if (event_loop_output_animating(output)) {
+            output->needs_redraw = true;
+        }
+
+        /* Sleep until this output's own next deadline (frame, cycle or preload) */
+        now = get_time_ms();
+        uint64_t deadline = event_loop_output_next_deadline(state, output, now);
+        if (deadline != 0) {
+            uint64_t wait_ms = deadline > now ? deadline - now : 0;
+            if (wait_ms < (uint64_t)timeout_ms) {
+                timeout_ms = (int)wait_ms;
+            }
+        }
+
+        wait_for_events(rt, timeout_ms);
+    }
+
+    eglMakeCurrent(state->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+
+    log_info("Render thread stopped for output %s", output->model);
+    return NULL;
+}
+
+/* Start a render thread for one output */
+static bool render_thread_start(struct neowall_state *state, struct output_state *output) {
+    struct render_thread *rt = calloc(1, sizeof(struct render_thread));
+    if (!rt) {
+        log_error("Failed to allocate render thread for output %s", output->model);
+        return false;
+    }
+
+    rt->state = state;
+    rt->output = output;
+    atomic_init(&rt->stop, false);
+    atomic_init(&rt->cycle_requested, false);
+
+    rt->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (rt->wakeup_fd < 0) {
+        log_error("Failed to create render thread eventfd: %s", strerror(errno));
+        free(rt);
+        return false;
+    }
+
+    rt->context = egl_core_create_shared_context(state);
+    if (rt->context == EGL_NO_CONTEXT) {
+        log_error("Failed to create shared EGL context for output %s: 0x%x",
+                  output->model, eglGetError());
+        close(rt->wakeup_fd);
+        free(rt);
+        return false;
+    }
+
+    rt->queue = wl_display_create_queue(state->display);
+    rt->surface_wrapper = rt->queue ? wl_proxy_create_wrapper(output->compositor_surface->wl_surface) : NULL;
+    if (!rt->surface_wrapper) {
+        log_error("Failed to create Wayland event queue for output %s", output->model);
+        if (rt->queue) {
+            wl_event_queue_destroy(rt->queue);
+        }
+        eglDestroyContext(state->egl_display, rt->context);
+        close(rt->wakeup_fd);
+        free(rt);
+        return false;
+    }
+    wl_proxy_set_queue((struct wl_proxy *)rt->surface_wrapper, rt->queue);
+
+    /* A frame callback requested by the main loop lives on the default queue;
+     * drop it so the thread starts with its own */
+    if (output->frame_callback) {
+        wl_callback_destroy(output->frame_callback);
+        output->frame_callback = NULL;
+    }
+
+    /* A surface can only be current on one thread - release it from the main thread */
+    eglMakeCurrent(state->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    output->render_thread = rt;
+    if (pthread_create(&rt->thread, NULL, render_thread_func, rt) != 0) {
+        log_error("Failed to create render thread for output %s", output->model);
+        output->render_thread = NULL;
+        wl_proxy_wrapper_destroy(rt->surface_wrapper);
+        wl_event_queue_destroy(rt->queue);
+        eglDestroyContext(state->egl_display, rt->context);
+        close(rt->wakeup_fd);
+        free(rt);
+        return false;
+    }
+
+    return true;
+}
+
+void render_thread_stop(struct output_state *output) {
+    if (!output || !output->render_thread) {
+        return;
+    }
+
+    struct render_thread *rt = output->render_thread;
+    atomic_store_explicit(&rt->stop, true, memory_order_release);
+    render_thread_wake(rt);
+    pthread_join(rt->thread, NULL);
+
+    /* Callback proxy belongs to the thread's queue - destroy before the queue */
+    if (output->frame_callback) {
+        wl_callback_destroy(output->frame_callback);
+        output->frame_callback = NULL;
+    }
+    wl_proxy_wrapper_destroy(rt->surface_wrapper);
+    wl_event_queue_destroy(rt->queue);
+    eglDestroyContext(rt->state->egl_display, rt->context);
+    close(rt->wakeup_fd);
+
+    /* Main context has its own GL state - force rebinding on next use */
+    output->gl_state.active_program = 0;
+    output->gl_state.bound_texture = 0;
+    output->needs_redraw = true;
+
+    output->render_thread = NULL;
+    free(rt);
+}
+
+void render_threads_start(struct neowall_state *state) {
+    if (!state) {
+        return;
+    }
+
+    int started = 0;
+    pthread_rwlock_rdlock(&state->output_list_lock);
+    struct output_state *output = state->outputs;
+    while (output) {
+        if (!output->render_thread && output->compositor_surface &&
+            output->compositor_surface->egl_surface != EGL_NO_SURFACE &&
+            render_thread_start(state, output)) {
+            started++;
+        }
+        output = output->next;
+    }
+    pthread_rwlock_unlock(&state->output_list_lock);
+
+    if (started > 0) {
+        log_info("Threaded rendering: %d output(s) on dedicated render threads", started);
+    }
+}
+
+void render_threads_stop(struct neowall_state *state) {
+    if (!state) {
+        return;
+    }
+
+    /* Threads only take the read lock with tryrdlock, joining under it is safe */
+    pthread_rwlock_rdlock(&state->output_list_lock);
+    struct output_state *output = state->outputs;
+    while (output) {
+        render_thread_stop(output);
+        output = output->next;
+    }
+    pthread_rwlock_unlock(&state->output_list_lock);
+}
+
+void render_thread_wakeup(struct output_state *output) {
+    if (!output || !output->render_thread) {
+        return;
+    }
+
+    render_thread_wake(output->render_thread);
+}
+
+void render_thread_request_cycle(struct output_state *output) {
+    if (!output || !output->render_thread) {
+        return;
+    }
+
+    atomic_store_explicit(&output->render_thread->cycle_requested, true, memory_order_release);
+    render_thread_wake(output->render_thread);
+}
+
+EGLContext render_thread_context_for(struct output_state *output) {
+    struct render_thread *rt = current_render_thread;
+    if (rt && rt->output == output) {
+        return rt->context;
+    }
+    return output->state->egl_context;
+}
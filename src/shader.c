@@ -3,11 +3,13 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <GLES2/gl2.h>
 #include <ctype.h>
 #include "neowall.h"
 #include "constants.h"
 #include "shader.h"
+#include "shader_disk_cache.h"
 #include "shadertoy_compat.h"
 
 /**
@@ -209,11 +211,101 @@ static GLuint compile_shader(GLenum type, const char *source) {
     return shader;
 }
 
+/**
+ * Process-wide program cache
+ * 
+ * Every output renders with the same EGL context, so a program linked for one
+ * output serves them all. Entries are keyed by the exact vertex and fragment
+ * source (the live shader's final wrapped source already encodes its iChannel
+ * count) and refcounted: shader_destroy_program() drops a reference and only
+ * the last one deletes the GL object.
+ * 
+ * The first loader of a source inserts its entry marked compiling and links
+ * outside shader_cache_lock; loaders of the same source wait on that entry's
+ * condition variable, everyone else carries on.
+ */
+struct shader_cache_entry {
+    uint64_t hash;
+    char *vertex_src;
+    char *fragment_src;
+    GLuint program;             /* 0 while compiling or after a failed link */
+    unsigned int refs;
+    bool compiling;
+    pthread_cond_t ready;       /* Signalled when compiling clears */
+    _Atomic(const void *) uniform_owner; /* Last user to upload uniforms into the program */
+    struct shader_cache_entry *next;
+};
+
+static struct shader_cache_entry *shader_cache = NULL;
+static pthread_mutex_t shader_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool shader_cache_enabled = true;
+
+/* FNV-1a over both stages */
+static uint64_t shader_cache_hash(const char *vertex_src, const char *fragment_src) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = vertex_src; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ULL;
+    for (const char *p = fragment_src; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* Caller holds shader_cache_lock */
+static struct shader_cache_entry *shader_cache_find_program(GLuint program) {
+    for (struct shader_cache_entry *entry = shader_cache; entry; entry = entry->next) {
+        if (!entry->compiling && entry->program == program) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void shader_cache_set_enabled(bool enabled) {
+    shader_cache_enabled = enabled;
+}
+
+struct shader_cache_entry *shader_cache_lookup(GLuint program) {
+    pthread_mutex_lock(&shader_cache_lock);
+    struct shader_cache_entry *entry = shader_cache_find_program(program);
+    pthread_mutex_unlock(&shader_cache_lock);
+    return entry;
+}
+
+bool shader_cache_claim_uniforms(struct shader_cache_entry *entry, const void *owner) {
+    if (!entry) {
+        return true;
+    }
+    return atomic_exchange_explicit(&entry->uniform_owner, owner, memory_order_relaxed) == owner;
+}
+
+static bool shader_link_program(const char *vertex_src, const char *fragment_src, GLuint *program);
+
+static void shader_cache_entry_free(struct shader_cache_entry *entry) {
+    pthread_cond_destroy(&entry->ready);
+    free(entry->vertex_src);
+    free(entry->fragment_src);
+    free(entry);
+}
+
+/* Caller holds shader_cache_lock */
+static void shader_cache_unlink(struct shader_cache_entry *entry) {
+    for (struct shader_cache_entry **link = &shader_cache; *link; link = &(*link)->next) {
+        if (*link == entry) {
+            *link = entry->next;
+            return;
+        }
+    }
+}
+
 /**
  * Create a shader program from source code
  * 
  * Shared utility function that compiles shaders and links them into a program.
- * Called by each transition's shader_create_*_program() function.
+ * Called by each transition's shader_create_*_program() function. Identical
+ * sources return the cached program with its refcount raised.
  * 
  * @param vertex_src Vertex shader source code
  * @param fragment_src Fragment shader source code
@@ -223,11 +315,106 @@ static GLuint compile_shader(GLenum type, const char *source) {
 bool shader_create_program_from_sources(const char *vertex_src, 
                                          const char *fragment_src,
                                          GLuint *program) {
-    if (!program) {
+    if (!program || !vertex_src || !fragment_src) {
         log_error("Invalid program pointer");
         return false;
     }
 
+    if (!shader_cache_enabled) {
+        return shader_link_program(vertex_src, fragment_src, program);
+    }
+
+    uint64_t hash = shader_cache_hash(vertex_src, fragment_src);
+
+    pthread_mutex_lock(&shader_cache_lock);
+    for (struct shader_cache_entry *entry = shader_cache; entry; entry = entry->next) {
+        if (entry->hash != hash || strcmp(entry->vertex_src, vertex_src) != 0 ||
+            strcmp(entry->fragment_src, fragment_src) != 0) {
+            continue;
+        }
+
+        entry->refs++;
+        while (entry->compiling) {
+            pthread_cond_wait(&entry->ready, &shader_cache_lock);
+        }
+        if (entry->program == 0) {
+            /* The link failed; its loader already unlinked the entry */
+            bool last = --entry->refs == 0;
+            pthread_mutex_unlock(&shader_cache_lock);
+            if (last) {
+                shader_cache_entry_free(entry);
+            }
+            return false;
+        }
+        *program = entry->program;
+        unsigned int refs = entry->refs;
+        pthread_mutex_unlock(&shader_cache_lock);
+        log_debug("Reusing cached shader program %u (%u users)", *program, refs);
+        return true;
+    }
+
+    struct shader_cache_entry *entry = calloc(1, sizeof(*entry));
+    if (entry) {
+        entry->vertex_src = strdup(vertex_src);
+        entry->fragment_src = strdup(fragment_src);
+    }
+    if (!entry || !entry->vertex_src || !entry->fragment_src ||
+        pthread_cond_init(&entry->ready, NULL) != 0) {
+        /* Still usable, just not shared */
+        if (entry) {
+            free(entry->vertex_src);
+            free(entry->fragment_src);
+            free(entry);
+        }
+        pthread_mutex_unlock(&shader_cache_lock);
+        log_error("Failed to allocate shader cache entry");
+        return shader_link_program(vertex_src, fragment_src, program);
+    }
+
+    entry->hash = hash;
+    entry->refs = 1;
+    entry->compiling = true;
+    atomic_init(&entry->uniform_owner, NULL);
+    entry->next = shader_cache;
+    shader_cache = entry;
+    pthread_mutex_unlock(&shader_cache_lock);
+
+    GLuint linked = 0;
+    bool ok = shader_link_program(vertex_src, fragment_src, &linked);
+    if (ok) {
+        /* Waiters may be on another context (the background compiler's or a
+         * render thread's), which may only use the program once it is complete */
+        glFinish();
+    }
+
+    pthread_mutex_lock(&shader_cache_lock);
+    entry->compiling = false;
+    entry->program = ok ? linked : 0;
+    bool last = false;
+    if (!ok) {
+        shader_cache_unlink(entry);
+        last = --entry->refs == 0;
+    }
+    pthread_cond_broadcast(&entry->ready);
+    pthread_mutex_unlock(&shader_cache_lock);
+
+    if (!ok) {
+        if (last) {
+            shader_cache_entry_free(entry);
+        }
+        return false;
+    }
+
+    *program = linked;
+    return true;
+}
+
+/* Compile and link a program, or load its binary from the disk cache */
+static bool shader_link_program(const char *vertex_src, const char *fragment_src, GLuint *program) {
+    if (shader_disk_cache_load(vertex_src, fragment_src, program)) {
+        return true;
+    }
+
     /* Compile shaders */
     GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_src);
     if (vertex_shader == 0) {
@@ -282,6 +469,8 @@ bool shader_create_program_from_sources(const char *vertex_src,
 
     *program = prog;
     log_debug("Shader program created successfully (ID: %u)", prog);
+
+    shader_disk_cache_store(vertex_src, fragment_src, prog);
     return true;
 }
 
@@ -291,10 +480,137 @@ bool shader_create_program_from_sources(const char *vertex_src,
  * @param program The program ID to destroy
  */
 void shader_destroy_program(GLuint program) {
-    if (program != 0) {
-        glDeleteProgram(program);
-        log_debug("Destroyed shader program (ID: %u)", program);
+    if (program == 0) {
+        return;
     }
+
+    pthread_mutex_lock(&shader_cache_lock);
+    struct shader_cache_entry **link = &shader_cache;
+    while (*link && (*link)->program != program) {
+        link = &(*link)->next;
+    }
+    struct shader_cache_entry *entry = *link;
+    if (entry && --entry->refs > 0) {
+        pthread_mutex_unlock(&shader_cache_lock);
+        log_debug("Released shared shader program %u (%u users left)", program, entry->refs);
+        return;
+    }
+    if (entry) {
+        *link = entry->next;
+    }
+    pthread_mutex_unlock(&shader_cache_lock);
+    if (entry) {
+        shader_cache_entry_free(entry);
+    }
+
+    glDeleteProgram(program);
+    log_debug("Destroyed shader program (ID: %u)", program);
+}
+
+/* Map an active uniform to the input neowall feeds it, false if it is not ours */
+static bool shader_uniform_role_for(const char *name, GLenum type,
+                                    enum shader_uniform_role *role, unsigned int *channel) {
+    if (type == GL_FLOAT && (strcmp(name, "_neowall_time") == 0 ||
+                             strcmp(name, "time") == 0 || strcmp(name, "iTime") == 0)) {
+        *role = SHADER_UNIFORM_TIME;
+        return true;
+    }
+    if (type == GL_FLOAT_VEC2 && (strcmp(name, "_neowall_resolution") == 0 ||
+                                  strcmp(name, "resolution") == 0)) {
+        *role = SHADER_UNIFORM_RESOLUTION;
+        return true;
+    }
+    if (type == GL_FLOAT_VEC3 && strcmp(name, "iResolution") == 0) {
+        *role = SHADER_UNIFORM_RESOLUTION3;
+        return true;
+    }
+    if (type == GL_SAMPLER_2D && strncmp(name, "iChannel", 8) == 0 &&
+        isdigit((unsigned char)name[8])) {
+        char *end = NULL;
+        unsigned long index = strtoul(name + 8, &end, 10);
+        if (*end != '\0') {
+            return false;
+        }
+        *role = SHADER_UNIFORM_CHANNEL;
+        *channel = (unsigned int)index;
+        return true;
+    }
+    return false;
+}
+
+bool shader_reflect_uniforms(GLuint program, struct shader_uniform_binding **bindings,
+                             size_t *count) {
+    *bindings = NULL;
+    *count = 0;
+
+    GLint active = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    if (active <= 0 || max_length <= 0) {
+        return true;
+    }
+
+    char *name = malloc((size_t)max_length);
+    struct shader_uniform_binding *table = calloc((size_t)active, sizeof(*table));
+    if (!name || !table) {
+        log_error("Failed to allocate uniform reflection table");
+        free(name);
+        free(table);
+        return false;
+    }
+
+    size_t bound = 0;
+    for (GLint i = 0; i < active; i++) {
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, max_length, NULL, &size, &type, name);
+
+        /* Arrays report "name[0]"; none of ours are arrays but strip it anyway */
+        char *bracket = strchr(name, '[');
+        if (bracket) {
+            *bracket = '\0';
+        }
+
+        enum shader_uniform_role role;
+        unsigned int channel = 0;
+        if (!shader_uniform_role_for(name, type, &role, &channel)) {
+            continue;
+        }
+
+        GLint location = glGetUniformLocation(program, name);
+        if (location < 0) {
+            continue;
+        }
+
+        table[bound].location = location;
+        table[bound].role = role;
+        table[bound].channel = channel;
+        bound++;
+    }
+    free(name);
+
+    if (bound == 0) {
+        free(table);
+        return true;
+    }
+
+    /* Sampler units are constant for the program's lifetime - set them now */
+    GLint previous_program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+    glUseProgram(program);
+    for (size_t i = 0; i < bound; i++) {
+        if (table[i].role == SHADER_UNIFORM_CHANNEL) {
+            glUniform1i(table[i].location, (GLint)table[i].channel);
+            table[i].uploaded = true;
+        }
+    }
+    glUseProgram((GLuint)previous_program);
+
+    log_debug("Reflected %d active uniforms of program %u, %zu bound", active, program, bound);
+    *bindings = table;
+    *count = bound;
+    return true;
 }
 
 /**
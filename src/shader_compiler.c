@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "shader.h"
+#include "shader_compiler.h"
+#include "egl/egl_core.h"
+#include "egl/capability.h"
+#include "gl_debug.h"
+
+struct compile_job {
+    struct output_state *output;
+    char path[MAX_PATH_LENGTH];
+    size_t channel_count;
+    bool preload;                   /* Publish into the preload slot instead of the pending one */
+    uint32_t generation;            /* output->shader_preload_generation when queued */
+    struct compile_job *next;
+};
+
+static pthread_mutex_t compiler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t compiler_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t compiler_thread;
+static bool compiler_running = false;
+static bool compiler_stop = false;
+static struct compile_job *job_queue = NULL;
+static struct output_state *job_active = NULL;  /* Output of the job being compiled */
+static EGLDisplay compiler_display = EGL_NO_DISPLAY;
+static EGLContext compiler_context = EGL_NO_CONTEXT;
+
+/* Draw one 1x1 offscreen frame so the driver finishes its deferred
+ * compilation here instead of on the first visible frame */
+static void warm_program(GLuint program) {
+    static const float quad[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f,
+    };
+
+    GLuint texture = 0, fbo = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+        glViewport(0, 0, 1, 1);
+        glUseProgram(program);
+        GLint position = glGetAttribLocation(program, "position");
+        if (position >= 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glVertexAttribPointer((GLuint)position, 2, GL_FLOAT, GL_FALSE, 0, quad);
+            glEnableVertexAttribArray((GLuint)position);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            glDisableVertexAttribArray((GLuint)position);
+        }
+        glUseProgram(0);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+
+    /* Objects are shared with the render contexts only once complete */
+    glFinish();
+}
+
+static void *compiler_thread_func(void *arg) {
+    (void)arg;
+
+    if (!eglMakeCurrent(compiler_display, EGL_NO_SURFACE, EGL_NO_SURFACE, compiler_context)) {
+        log_error("Shader compiler: failed to make context current: 0x%x", eglGetError());
+        pthread_mutex_lock(&compiler_lock);
+        compiler_stop = true;  /* Submissions fall back to synchronous compilation */
+        pthread_mutex_unlock(&compiler_lock);
+        return NULL;
+    }
+    gl_debug_setup_context();
+
+    pthread_mutex_lock(&compiler_lock);
+    while (!compiler_stop) {
+        struct compile_job *job = job_queue;
+        if (!job) {
+            pthread_cond_wait(&compiler_cond, &compiler_lock);
+            continue;
+        }
+        job_queue = job->next;
+        job_active = job->output;
+        pthread_mutex_unlock(&compiler_lock);
+
+        uint64_t start = get_time_ms();
+        GLuint program = 0;
+        if (shader_create_live_program(job->path, &program, job->channel_count) && program != 0) {
+            warm_program(program);
+            log_debug("Shader compiled in background in %lums: %s",
+                      (unsigned long)(get_time_ms() - start), job->path);
+        } else {
+            program = 0;
+        }
+
+        /* Publish before clearing job_active so cancel sees the result */
+        pthread_mutex_lock(&compiler_lock);
+        if (job->preload && job->generation != job->output->shader_preload_generation) {
+            /* A newer lookahead superseded this one while it compiled */
+            if (program != 0) {
+                shader_destroy_program(program);
+            }
+        } else if (job->preload) {
+            job->output->shader_preload_ms = get_time_ms() - start;
+            job->output->shader_preload_program = program;
+            atomic_store(&job->output->shader_preload_ready, true);
+            event_loop_wake_output(job->output);
+        } else {
+            job->output->pending_shader_program = program;
+            atomic_store(&job->output->shader_compile_ready, true);
+            event_loop_wake_output(job->output);
+        }
+        job_active = NULL;
+        pthread_cond_broadcast(&compiler_cond);
+        free(job);
+    }
+    pthread_mutex_unlock(&compiler_lock);
+
+    eglMakeCurrent(compiler_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+    return NULL;
+}
+
+bool shader_compiler_start(struct neowall_state *state) {
+    if (compiler_running) {
+        return true;
+    }
+
+    if (!egl_has_extension(state->egl_display, "EGL_KHR_surfaceless_context")) {
+        log_info("EGL_KHR_surfaceless_context unavailable, shaders compile on the render thread");
+        return false;
+    }
+
+    compiler_context = egl_core_create_shared_context(state);
+    if (compiler_context == EGL_NO_CONTEXT) {
+        log_error("Failed to create shader compiler context: 0x%x", eglGetError());
+        return false;
+    }
+    compiler_display = state->egl_display;
+    compiler_stop = false;
+
+    if (pthread_create(&compiler_thread, NULL, compiler_thread_func, NULL) != 0) {
+        log_error("Failed to start shader compiler thread");
+        eglDestroyContext(compiler_display, compiler_context);
+        compiler_context = EGL_NO_CONTEXT;
+        return false;
+    }
+
+    compiler_running = true;
+    log_debug("Background shader compiler started");
+    return true;
+}
+
+void shader_compiler_stop(void) {
+    if (!compiler_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&compiler_lock);
+    compiler_stop = true;
+    pthread_cond_broadcast(&compiler_cond);
+    pthread_mutex_unlock(&compiler_lock);
+    pthread_join(compiler_thread, NULL);
+
+    while (job_queue) {
+        struct compile_job *next = job_queue->next;
+        free(job_queue);
+        job_queue = next;
+    }
+
+    eglDestroyContext(compiler_display, compiler_context);
+    compiler_context = EGL_NO_CONTEXT;
+    compiler_running = false;
+}
+
+static bool enqueue_job(struct output_state *output, const char *shader_path,
+                        size_t channel_count, bool preload) {
+    if (!compiler_running || !output || !shader_path) {
+        return false;
+    }
+
+    struct compile_job *job = calloc(1, sizeof(*job));
+    if (!job) {
+        log_error("Failed to allocate shader compile job");
+        return false;
+    }
+    job->output = output;
+    strncpy(job->path, shader_path, sizeof(job->path) - 1);
+    job->channel_count = channel_count;
+    job->preload = preload;
+
+    pthread_mutex_lock(&compiler_lock);
+    if (compiler_stop) {
+        pthread_mutex_unlock(&compiler_lock);
+        free(job);
+        return false;
+    }
+
+    /* A previous lookahead for this output is superseded: drop it if queued,
+     * free its unclaimed result, and let a running one discard its own result
+     * when it sees the newer generation - never wait for it here */
+    if (preload) {
+        job->generation = ++output->shader_preload_generation;
+        struct compile_job **link = &job_queue;
+        while (*link) {
+            if ((*link)->output == output && (*link)->preload) {
+                struct compile_job *old = *link;
+                *link = old->next;
+                free(old);
+            } else {
+                link = &(*link)->next;
+            }
+        }
+        if (atomic_exchange(&output->shader_preload_ready, false) &&
+            output->shader_preload_program != 0) {
+            shader_destroy_program(output->shader_preload_program);
+        }
+        output->shader_preload_program = 0;
+    }
+
+    struct compile_job **tail = &job_queue;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = job;
+    pthread_cond_signal(&compiler_cond);
+    pthread_mutex_unlock(&compiler_lock);
+    return true;
+}
+
+bool shader_compiler_submit(struct output_state *output, const char *shader_path,
+                            size_t channel_count) {
+    return enqueue_job(output, shader_path, channel_count, false);
+}
+
+bool shader_compiler_preload(struct output_state *output, const char *shader_path,
+                             size_t channel_count) {
+    return enqueue_job(output, shader_path, channel_count, true);
+}
+
+void shader_compiler_cancel(struct output_state *output) {
+    if (!output) {
+        return;
+    }
+
+    pthread_mutex_lock(&compiler_lock);
+    struct compile_job **link = &job_queue;
+    while (*link) {
+        if ((*link)->output == output) {
+            struct compile_job *job = *link;
+            *link = job->next;
+            free(job);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    while (job_active == output) {
+        pthread_cond_wait(&compiler_cond, &compiler_lock);
+    }
+    pthread_mutex_unlock(&compiler_lock);
+
+    /* Ready or already claimed but not yet swapped in: nobody else will free it */
+    atomic_store(&output->shader_compile_ready, false);
+    if (output->pending_shader_program != 0) {
+        shader_destroy_program(output->pending_shader_program);
+        output->pending_shader_program = 0;
+    }
+    atomic_store(&output->shader_preload_ready, false);
+    if (output->shader_preload_program != 0) {
+        shader_destroy_program(output->shader_preload_program);
+        output->shader_preload_program = 0;
+    }
+    output->shader_preload_path[0] = '\0';
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "shader_disk_cache.h"
+#include "egl/capability.h"
+
+/* GL_OES_get_program_binary tokens (same values as the ES 3.0 core names) */
+#define GL_PROGRAM_BINARY_LENGTH_OES      0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS_OES 0x87FE
+
+#define PROGRAM_CACHE_MAGIC   "NWPB"
+#define PROGRAM_CACHE_VERSION 2u
+#define PROGRAM_CACHE_MAX_BINARY (64u * 1024u * 1024u)
+
+typedef void (GL_APIENTRY *get_program_binary_fn)(GLuint program, GLsizei buf_size, GLsizei *length,
+                                                  GLenum *binary_format, void *binary);
+typedef void (GL_APIENTRY *program_binary_fn)(GLuint program, GLenum binary_format,
+                                              const void *binary, GLint length);
+
+struct program_cache_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_length;     /* Vertex plus fragment source bytes */
+    uint64_t source_check;      /* Second, independent source hash against key collisions */
+    uint64_t driver_hash;
+    uint32_t binary_format;
+    uint32_t binary_length;
+};
+
+static pthread_mutex_t disk_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool disk_cache_initialized = false;
+static bool disk_cache_available = false;
+static get_program_binary_fn get_program_binary = NULL;
+static program_binary_fn program_binary = NULL;
+static uint64_t driver_hash = 0;
+static char cache_dir[MAX_PATH_LENGTH];
+
+static atomic_ulong cache_hits;
+static atomic_ulong cache_misses;
+
+static uint64_t fnv1a(uint64_t hash, const char *str) {
+    for (const char *p = str ? str : ""; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    /* Separator so ("ab", "c") and ("a", "bc") differ */
+    return (hash ^ 0xff) * 1099511628211ULL;
+}
+
+/* djb2-style polynomial hash, unrelated to FNV-1a so one collision can't fool both */
+static uint64_t poly_hash(uint64_t hash, const char *str) {
+    for (const char *p = str ? str : ""; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    return hash * 33 + 0xff;
+}
+
+/* mkdir -p */
+static bool ensure_directory(const char *path) {
+    char tmp[MAX_PATH_LENGTH];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char *p = tmp + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(tmp, 0755) == -1 && errno != EEXIST) {
+                return false;
+            }
+            *p = '/';
+        }
+    }
+    return mkdir(tmp, 0755) == 0 || errno == EEXIST;
+}
+
+/* Delete entries written under another driver; they can never load again.
+ * Entries are named <source hash><driver hash>.bin, 16 hex digits each. */
+static void prune_other_drivers(void) {
+    DIR *dir = opendir(cache_dir);
+    if (!dir) {
+        return;
+    }
+
+    char current[17];
+    snprintf(current, sizeof(current), "%016" PRIx64, driver_hash);
+    unsigned int removed = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        if (strlen(name) != 36 || strcmp(name + 32, ".bin") != 0 ||
+            strncmp(name + 16, current, 16) == 0) {
+            continue;
+        }
+        char path[MAX_PATH_LENGTH + 64];
+        snprintf(path, sizeof(path), "%s/%s", cache_dir, name);
+        if (unlink(path) == 0) {
+            removed++;
+        }
+    }
+    closedir(dir);
+
+    if (removed > 0) {
+        log_debug("Removed %u shader cache entries from other drivers", removed);
+    }
+}
+
+/* Resolve entry points, driver identity and cache directory once (needs a current context) */
+static bool disk_cache_init(void) {
+    pthread_mutex_lock(&disk_cache_lock);
+    if (disk_cache_initialized) {
+        pthread_mutex_unlock(&disk_cache_lock);
+        return disk_cache_available;
+    }
+    disk_cache_initialized = true;
+
+    const char *version = (const char *)glGetString(GL_VERSION);
+    bool es3 = version && strstr(version, "OpenGL ES 3") != NULL;
+    if (gles_has_extension("GL_OES_get_program_binary")) {
+        get_program_binary = (get_program_binary_fn)eglGetProcAddress("glGetProgramBinaryOES");
+        program_binary = (program_binary_fn)eglGetProcAddress("glProgramBinaryOES");
+    } else if (es3) {
+        get_program_binary = (get_program_binary_fn)eglGetProcAddress("glGetProgramBinary");
+        program_binary = (program_binary_fn)eglGetProcAddress("glProgramBinary");
+    }
+
+    GLint formats = 0;
+    if (get_program_binary && program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    }
+    if (formats <= 0) {
+        log_debug("Program binaries not supported by this driver, shader disk cache disabled");
+        pthread_mutex_unlock(&disk_cache_lock);
+        return false;
+    }
+
+    driver_hash = 14695981039346656037ULL;
+    driver_hash = fnv1a(driver_hash, (const char *)glGetString(GL_VENDOR));
+    driver_hash = fnv1a(driver_hash, (const char *)glGetString(GL_RENDERER));
+    driver_hash = fnv1a(driver_hash, version);
+
+    const char *cache_home = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (cache_home && cache_home[0] != '\0') {
+        snprintf(cache_dir, sizeof(cache_dir), "%s/neowall/programs", cache_home);
+    } else if (home && home[0] != '\0') {
+        snprintf(cache_dir, sizeof(cache_dir), "%s/.cache/neowall/programs", home);
+    } else {
+        log_debug("No cache directory (XDG_CACHE_HOME and HOME unset), shader disk cache disabled");
+        pthread_mutex_unlock(&disk_cache_lock);
+        return false;
+    }
+
+    if (!ensure_directory(cache_dir)) {
+        log_error("Failed to create shader cache directory %s: %s", cache_dir, strerror(errno));
+        pthread_mutex_unlock(&disk_cache_lock);
+        return false;
+    }
+
+    prune_other_drivers();
+
+    disk_cache_available = true;
+    log_debug("Shader disk cache: %s (%d binary formats)", cache_dir, formats);
+    pthread_mutex_unlock(&disk_cache_lock);
+    return true;
+}
+
+static uint64_t source_hash(const char *vertex_src, const char *fragment_src) {
+    return fnv1a(fnv1a(14695981039346656037ULL, vertex_src), fragment_src);
+}
+
+static uint64_t source_check(const char *vertex_src, const char *fragment_src) {
+    return poly_hash(poly_hash(5381, vertex_src), fragment_src);
+}
+
+static uint64_t source_length(const char *vertex_src, const char *fragment_src) {
+    return (uint64_t)strlen(vertex_src) + strlen(fragment_src);
+}
+
+static void entry_path(char *path, size_t size, uint64_t src_hash) {
+    snprintf(path, size, "%s/%016" PRIx64 "%016" PRIx64 ".bin", cache_dir, src_hash, driver_hash);
+}
+
+bool shader_disk_cache_load(const char *vertex_src, const char *fragment_src, GLuint *program) {
+    if (!disk_cache_init()) {
+        return false;
+    }
+
+    uint64_t src_hash = source_hash(vertex_src, fragment_src);
+    char path[MAX_PATH_LENGTH + 64];
+    entry_path(path, sizeof(path), src_hash);
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        atomic_fetch_add(&cache_misses, 1);
+        return false;
+    }
+
+    struct program_cache_header header;
+    void *binary = NULL;
+    bool valid = fread(&header, sizeof(header), 1, fp) == 1 &&
+                 memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == PROGRAM_CACHE_VERSION &&
+                 header.source_hash == src_hash &&
+                 header.source_length == source_length(vertex_src, fragment_src) &&
+                 header.source_check == source_check(vertex_src, fragment_src) &&
+                 header.driver_hash == driver_hash &&
+                 header.binary_length > 0 && header.binary_length <= PROGRAM_CACHE_MAX_BINARY;
+    if (valid) {
+        binary = malloc(header.binary_length);
+        valid = binary && fread(binary, header.binary_length, 1, fp) == 1;
+    }
+    fclose(fp);
+
+    GLuint prog = 0;
+    if (valid) {
+        prog = glCreateProgram();
+        program_binary(prog, header.binary_format, binary, (GLint)header.binary_length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            /* Driver changed in a way its version string does not show */
+            glDeleteProgram(prog);
+            valid = false;
+        }
+    }
+    free(binary);
+
+    if (!valid) {
+        log_debug("Discarding unusable shader cache entry %s", path);
+        unlink(path);
+        atomic_fetch_add(&cache_misses, 1);
+        return false;
+    }
+
+    atomic_fetch_add(&cache_hits, 1);
+    log_debug("Loaded shader program %u from disk cache", prog);
+    *program = prog;
+    return true;
+}
+
+void shader_disk_cache_store(const char *vertex_src, const char *fragment_src, GLuint program) {
+    if (!disk_cache_init()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0 || (uint32_t)length > PROGRAM_CACHE_MAX_BINARY) {
+        return;
+    }
+
+    void *binary = malloc((size_t)length);
+    if (!binary) {
+        return;
+    }
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    get_program_binary(program, length, &written, &format, binary);
+    if (written <= 0) {
+        free(binary);
+        return;
+    }
+
+    struct program_cache_header header;
+    memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+    header.version = PROGRAM_CACHE_VERSION;
+    header.source_hash = source_hash(vertex_src, fragment_src);
+    header.source_length = source_length(vertex_src, fragment_src);
+    header.source_check = source_check(vertex_src, fragment_src);
+    header.driver_hash = driver_hash;
+    header.binary_format = format;
+    header.binary_length = (uint32_t)written;
+
+    char path[MAX_PATH_LENGTH + 64];
+    char tmp_path[MAX_PATH_LENGTH + 16];
+    entry_path(path, sizeof(path), header.source_hash);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/.tmp-XXXXXX", cache_dir);
+
+    /* Write to a temp file and rename so readers never see a partial entry */
+    int fd = mkstemp(tmp_path);
+    FILE *fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!fp) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        free(binary);
+        return;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(binary, (size_t)written, 1, fp) == 1;
+    ok = (fclose(fp) == 0) && ok;
+    free(binary);
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        log_debug("Failed to write shader cache entry %s", path);
+        unlink(tmp_path);
+        return;
+    }
+    log_debug("Stored shader program binary (%d bytes) in %s", (int)written, path);
+}
+
+void shader_disk_cache_get_stats(unsigned long *hits, unsigned long *misses) {
+    *hits = atomic_load(&cache_hits);
+    *misses = atomic_load(&cache_misses);
+}
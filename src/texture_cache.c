@@ -0,0 +1,352 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "constants.h"
+#include "texture_cache.h"
+#include "texture_compress.h"
+
+struct cache_waiter {
+    struct output_state *output;
+    struct cache_waiter *next;
+};
+
+struct texture_entry {
+    char path[MAX_PATH_LENGTH];
+    int32_t display_width;
+    int32_t display_height;
+    enum wallpaper_mode mode;
+    GLuint texture;                 /* 0 while claimed for decoding */
+    unsigned long refs;
+    struct image_data image;        /* Description handed to sharers, no pixels */
+    struct output_state *owner;     /* Output decoding a claim (NULL = up for grabs) */
+    uint64_t claimed_at;
+    struct cache_waiter *waiters;
+    struct texture_entry *next;
+};
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t handoff_cond = PTHREAD_COND_INITIALIZER;
+static struct texture_entry *entries = NULL;
+static unsigned handoffs_running = 0;   /* Hand-offs in progress outside cache_lock */
+static unsigned long shared_refs = 0;
+
+static struct texture_entry *find_entry(const char *path, int32_t display_width,
+                                        int32_t display_height, enum wallpaper_mode mode) {
+    for (struct texture_entry *e = entries; e; e = e->next) {
+        if (e->display_width == display_width && e->display_height == display_height &&
+            e->mode == mode && strcmp(e->path, path) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void unlink_entry(struct texture_entry *entry) {
+    for (struct texture_entry **link = &entries; *link; link = &(*link)->next) {
+        if (*link == entry) {
+            *link = entry->next;
+            break;
+        }
+    }
+    while (entry->waiters) {
+        struct cache_waiter *next = entry->waiters->next;
+        free(entry->waiters);
+        entry->waiters = next;
+    }
+    free(entry);
+}
+
+/* Remove an output from every wait list; called with cache_lock held */
+static void drop_waiter(struct output_state *output) {
+    for (struct texture_entry *e = entries; e; e = e->next) {
+        struct cache_waiter **link = &e->waiters;
+        while (*link) {
+            if ((*link)->output == output) {
+                struct cache_waiter *w = *link;
+                *link = w->next;
+                free(w);
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+}
+
+/* Put a pixel-less image in the output's preload slot; its GL thread acquires
+ * the texture on upload. Called without cache_lock (takes preload_mutex). */
+static void hand_off(struct output_state *output, const struct image_data *description) {
+    struct image_data *image = malloc(sizeof(*image));
+    if (!image) {
+        log_error("Failed to allocate shared wallpaper description");
+        return;
+    }
+    *image = *description;
+
+    pthread_mutex_lock(&output->preload_mutex);
+    if (output->preload_decoded_texture) {
+        /* An uploaded preload is still unclaimed and owns a texture; keep it */
+        pthread_mutex_unlock(&output->preload_mutex);
+        free(image);
+        return;
+    }
+    if (output->preload_decoded_image) {
+        image_free(output->preload_decoded_image);
+    }
+    output->preload_decoded_image = image;
+    strncpy(output->preload_path, image->path, sizeof(output->preload_path) - 1);
+    output->preload_path[sizeof(output->preload_path) - 1] = '\0';
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    atomic_store(&output->preload_upload_pending, true);
+    event_loop_wake_output(output);
+}
+
+enum texture_claim texture_cache_claim(struct output_state *output, const char *path,
+                                       int32_t display_width, int32_t display_height,
+                                       enum wallpaper_mode mode) {
+    uint64_t now = get_time_ms();
+
+    pthread_mutex_lock(&cache_lock);
+
+    /* An output waits for one preload at a time */
+    drop_waiter(output);
+
+    struct texture_entry *entry = find_entry(path, display_width, display_height, mode);
+    if (entry && entry->texture) {
+        struct image_data description = entry->image;
+        GLuint texture = entry->texture;
+        handoffs_running++;
+        pthread_mutex_unlock(&cache_lock);
+
+        log_debug("Next wallpaper %s is already on the GPU (texture %u)", path, texture);
+        hand_off(output, &description);
+
+        pthread_mutex_lock(&cache_lock);
+        handoffs_running--;
+        pthread_cond_broadcast(&handoff_cond);
+        pthread_mutex_unlock(&cache_lock);
+        return TEXTURE_CLAIM_SHARED;
+    }
+
+    if (entry && entry->owner && entry->owner != output &&
+        now - entry->claimed_at < TEXTURE_CLAIM_TIMEOUT_MS) {
+        struct cache_waiter *waiter = malloc(sizeof(*waiter));
+        if (waiter) {
+            waiter->output = output;
+            waiter->next = entry->waiters;
+            entry->waiters = waiter;
+            pthread_mutex_unlock(&cache_lock);
+            log_debug("Waiting for another output to decode %s", path);
+            return TEXTURE_CLAIM_WAIT;
+        }
+    }
+
+    if (!entry) {
+        entry = calloc(1, sizeof(*entry));
+        if (!entry) {
+            pthread_mutex_unlock(&cache_lock);
+            return TEXTURE_CLAIM_DECODE;    /* Decode without sharing */
+        }
+        strncpy(entry->path, path, sizeof(entry->path) - 1);
+        entry->display_width = display_width;
+        entry->display_height = display_height;
+        entry->mode = mode;
+        entry->next = entries;
+        entries = entry;
+    }
+    entry->owner = output;
+    entry->claimed_at = now;
+    pthread_mutex_unlock(&cache_lock);
+    return TEXTURE_CLAIM_DECODE;
+}
+
+void texture_cache_abandon(struct output_state *output, const char *path,
+                           int32_t display_width, int32_t display_height,
+                           enum wallpaper_mode mode) {
+    pthread_mutex_lock(&cache_lock);
+    struct texture_entry *entry = find_entry(path, display_width, display_height, mode);
+    if (entry && !entry->texture && entry->owner == output) {
+        if (entry->waiters) {
+            entry->owner = NULL;    /* Next claimer decodes for the waiters */
+        } else {
+            unlink_entry(entry);
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+GLuint texture_cache_acquire(const char *path, int32_t display_width, int32_t display_height,
+                             enum wallpaper_mode mode, struct image_data **image) {
+    if (!path || display_width <= 0 || display_height <= 0) {
+        return 0;
+    }
+
+    struct image_data *copy = NULL;
+    if (image) {
+        *image = NULL;
+        copy = malloc(sizeof(*copy));
+        if (!copy) {
+            return 0;
+        }
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    struct texture_entry *entry = find_entry(path, display_width, display_height, mode);
+    if (!entry || !entry->texture) {
+        pthread_mutex_unlock(&cache_lock);
+        free(copy);
+        return 0;
+    }
+    entry->refs++;
+    shared_refs++;
+    GLuint texture = entry->texture;
+    if (copy) {
+        *copy = entry->image;
+        *image = copy;
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    log_debug("Shared wallpaper texture %u for %s (%dx%d)", texture, path,
+              display_width, display_height);
+    return texture;
+}
+
+bool texture_cache_insert(GLuint texture, const struct image_data *image) {
+    if (!texture || !image || image->display_width <= 0 || image->display_height <= 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    struct texture_entry *entry = find_entry(image->path, image->display_width,
+                                             image->display_height, image->display_mode);
+    if (entry && entry->texture) {
+        /* Another output registered the same image first */
+        pthread_mutex_unlock(&cache_lock);
+        return false;
+    }
+    if (!entry) {
+        entry = calloc(1, sizeof(*entry));
+        if (!entry) {
+            pthread_mutex_unlock(&cache_lock);
+            return false;
+        }
+        memcpy(entry->path, image->path, sizeof(entry->path));
+        entry->display_width = image->display_width;
+        entry->display_height = image->display_height;
+        entry->mode = image->display_mode;
+        entry->next = entries;
+        entries = entry;
+    }
+
+    entry->texture = texture;
+    entry->refs = 1;
+    entry->owner = NULL;
+    entry->image = (struct image_data){
+        .width = image->width,
+        .height = image->height,
+        .channels = image->channels,
+        .format = image->format,
+        .display_width = image->display_width,
+        .display_height = image->display_height,
+        .display_mode = image->display_mode,
+    };
+    memcpy(entry->image.path, image->path, sizeof(entry->image.path));
+
+    struct image_data description = entry->image;
+    struct cache_waiter *waiters = entry->waiters;
+    entry->waiters = NULL;
+    if (!waiters) {
+        pthread_mutex_unlock(&cache_lock);
+        glFlush();
+        return true;
+    }
+    handoffs_running++;
+    pthread_mutex_unlock(&cache_lock);
+
+    /* Waiters sample it from their own contexts as soon as they pick it up */
+    glFinish();
+
+    while (waiters) {
+        struct cache_waiter *next = waiters->next;
+        hand_off(waiters->output, &description);
+        free(waiters);
+        waiters = next;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    handoffs_running--;
+    pthread_cond_broadcast(&handoff_cond);
+    pthread_mutex_unlock(&cache_lock);
+    return true;
+}
+
+bool texture_cache_release(GLuint texture) {
+    if (!texture) {
+        return false;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    struct texture_entry *entry = entries;
+    while (entry && entry->texture != texture) {
+        entry = entry->next;
+    }
+    if (!entry) {
+        pthread_mutex_unlock(&cache_lock);
+        return false;
+    }
+
+    bool last = --entry->refs == 0;
+    if (last) {
+        /* Waiters arriving now would otherwise wait for a texture that is gone */
+        if (entry->waiters) {
+            entry->texture = 0;
+            entry->owner = NULL;
+        } else {
+            unlink_entry(entry);
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    if (last) {
+        texture_compress_untrack(texture);
+        glDeleteTextures(1, &texture);
+    }
+    return true;
+}
+
+void texture_cache_cancel(struct output_state *output) {
+    pthread_mutex_lock(&cache_lock);
+    drop_waiter(output);
+    struct texture_entry *entry = entries;
+    while (entry) {
+        struct texture_entry *next = entry->next;
+        if (!entry->texture && entry->owner == output) {
+            if (entry->waiters) {
+                entry->owner = NULL;
+            } else {
+                unlink_entry(entry);
+            }
+        }
+        entry = next;
+    }
+    /* A hand-off may still be writing into this output's preload slot */
+    while (handoffs_running > 0) {
+        pthread_cond_wait(&handoff_cond, &cache_lock);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void texture_cache_get_stats(unsigned long *textures, unsigned long *shared) {
+    pthread_mutex_lock(&cache_lock);
+    unsigned long count = 0;
+    for (struct texture_entry *e = entries; e; e = e->next) {
+        if (e->texture) {
+            count++;
+        }
+    }
+    *textures = count;
+    *shared = shared_refs;
+    pthread_mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,403 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "constants.h"
+#include "parallel.h"
+#include "texture_compress.h"
+
+#define ETC_BLOCK_BYTES 8
+
+/* Intensity modifiers {small, large}; a selector picks +small, +large, -small, -large */
+static const int etc_modifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183},
+};
+
+/* Pixels of each sub-block as indices into a block stored column-major
+ * (index x * 4 + y, the order of the selector bits) */
+static const uint8_t etc_subblocks[2][2][8] = {
+    { {0, 1, 2, 3, 4, 5, 6, 7}, {8, 9, 10, 11, 12, 13, 14, 15} },     /* flip 0: 2x4 side by side */
+    { {0, 1, 4, 5, 8, 9, 12, 13}, {2, 3, 6, 7, 10, 11, 14, 15} },     /* flip 1: 4x2 stacked */
+};
+
+struct subblock_fit {
+    uint32_t error;
+    uint8_t table;
+    uint8_t selectors[8];
+};
+
+struct block_fit {
+    uint32_t error;
+    bool differential;
+    bool flip;
+    int base[2][3];                 /* Quantized base colors (4 or 5 bits) */
+    struct subblock_fit sub[2];
+};
+
+struct compress_job {
+    const struct image_data *img;
+    uint8_t *blocks;
+    uint32_t blocks_x;
+    bool thorough;
+};
+
+/* ETC2 textures alive on the GPU, so the stats show what is saved right now */
+struct tracked_texture {
+    GLuint texture;
+    uint64_t compressed_size;
+    uint64_t rgba_size;
+    struct tracked_texture *next;
+};
+
+static pthread_mutex_t tracked_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct tracked_texture *tracked;
+static unsigned long compressed_textures;
+static uint64_t compressed_total;
+static uint64_t rgba_total;
+
+static inline int clamp_u8(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int modifier(int table, int selector) {
+    int m = etc_modifiers[table][selector & 1];
+    return (selector & 2) ? -m : m;
+}
+
+static inline uint32_t pixel_error(const uint8_t px[3], const int base[3], int m) {
+    int dr = clamp_u8(base[0] + m) - px[0];
+    int dg = clamp_u8(base[1] + m) - px[1];
+    int db = clamp_u8(base[2] + m) - px[2];
+    return (uint32_t)(dr * dr + dg * dg + db * db);
+}
+
+/* Pick the table and selectors for one sub-block around an expanded base color.
+ * The fast path takes the selector nearest the mean channel offset, which is
+ * exact unless the modified color clips; the thorough path tries all four. */
+static void fit_subblock(const uint8_t px[16][3], const uint8_t *members, const int base[3],
+                         bool thorough, struct subblock_fit *best) {
+    best->error = UINT32_MAX;
+
+    for (int t = 0; t < 8; t++) {
+        struct subblock_fit fit = { .error = 0, .table = (uint8_t)t };
+        int threshold = 3 * (etc_modifiers[t][0] + etc_modifiers[t][1]);
+
+        for (int i = 0; i < 8 && fit.error < best->error; i++) {
+            const uint8_t *p = px[members[i]];
+            uint32_t err;
+            int sel;
+
+            if (thorough) {
+                sel = 0;
+                err = pixel_error(p, base, modifier(t, 0));
+                for (int s = 1; s < 4; s++) {
+                    uint32_t e = pixel_error(p, base, modifier(t, s));
+                    if (e < err) {
+                        err = e;
+                        sel = s;
+                    }
+                }
+            } else {
+                int d = (p[0] - base[0]) + (p[1] - base[1]) + (p[2] - base[2]);
+                int ad = d < 0 ? -d : d;
+                sel = (ad * 2 < threshold ? 0 : 1) | (d < 0 ? 2 : 0);
+                err = pixel_error(p, base, modifier(t, sel));
+            }
+
+            fit.selectors[i] = (uint8_t)sel;
+            fit.error += err;
+        }
+
+        if (fit.error < best->error) {
+            *best = fit;
+        }
+    }
+}
+
+static inline int expand4(int q) {
+    return q * 17;
+}
+
+static inline int expand5(int q) {
+    return (q << 3) | (q >> 2);
+}
+
+/* Mean color of a sub-block quantized to 4 or 5 bits per channel */
+static void quantize_mean(const uint8_t px[16][3], const uint8_t *members, int bits, int q[3]) {
+    int levels = (1 << bits) - 1;
+    for (int c = 0; c < 3; c++) {
+        int sum = 0;
+        for (int i = 0; i < 8; i++) {
+            sum += px[members[i]][c];
+        }
+        q[c] = (sum * levels + 1020) / 2040;
+    }
+}
+
+/* Fit a sub-block around a quantized base, also trying the base one step
+ * darker and lighter when thorough (the modifier tables are symmetric, so a
+ * skewed sub-block often fits better off its mean). Candidates failing
+ * accept() are skipped; returns false if none is accepted. */
+static bool fit_base(const uint8_t px[16][3], const uint8_t *members, const int mean[3],
+                     int bits, bool thorough, const int *other, int out[3],
+                     struct subblock_fit *best) {
+    int levels = (1 << bits) - 1;
+    bool found = false;
+    best->error = UINT32_MAX;
+
+    for (int shift = thorough ? -1 : 0; shift <= (thorough ? 1 : 0); shift++) {
+        int q[3], base[3];
+        bool valid = true;
+        for (int c = 0; c < 3; c++) {
+            q[c] = mean[c] + shift;
+            if (q[c] < 0 || q[c] > levels) {
+                valid = false;
+            }
+            /* Differential mode stores the second base as a 3-bit delta */
+            if (other && (q[c] - other[c] < -4 || q[c] - other[c] > 3)) {
+                valid = false;
+            }
+            base[c] = bits == 5 ? expand5(q[c]) : expand4(q[c]);
+        }
+        if (!valid) {
+            continue;
+        }
+
+        struct subblock_fit fit;
+        fit_subblock(px, members, base, thorough, &fit);
+        if (fit.error < best->error) {
+            *best = fit;
+            memcpy(out, q, sizeof(q));
+            found = true;
+        }
+    }
+    return found;
+}
+
+static void fit_mode(const uint8_t px[16][3], bool flip, bool differential, bool thorough,
+                     struct block_fit *best) {
+    const uint8_t *members0 = etc_subblocks[flip][0];
+    const uint8_t *members1 = etc_subblocks[flip][1];
+    int bits = differential ? 5 : 4;
+    int mean0[3], mean1[3];
+    struct block_fit fit = { .differential = differential, .flip = flip };
+
+    quantize_mean(px, members0, bits, mean0);
+    quantize_mean(px, members1, bits, mean1);
+
+    if (differential) {
+        for (int c = 0; c < 3; c++) {
+            if (mean1[c] - mean0[c] < -4 || mean1[c] - mean0[c] > 3) {
+                return;     /* Sub-blocks too far apart for a delta */
+            }
+        }
+    }
+
+    fit_base(px, members0, mean0, bits, thorough, NULL, fit.base[0], &fit.sub[0]);
+    if (!fit_base(px, members1, mean1, bits, thorough, differential ? fit.base[0] : NULL,
+                  fit.base[1], &fit.sub[1])) {
+        return;
+    }
+
+    fit.error = fit.sub[0].error + fit.sub[1].error;
+    if (fit.error < best->error) {
+        *best = fit;
+    }
+}
+
+static void pack_block(const struct block_fit *fit, uint8_t out[ETC_BLOCK_BYTES]) {
+    uint64_t v = 0;
+
+    if (fit->differential) {
+        for (int c = 0; c < 3; c++) {
+            int shift = 59 - c * 8;
+            v |= (uint64_t)fit->base[0][c] << shift;
+            v |= (uint64_t)((fit->base[1][c] - fit->base[0][c]) & 7) << (shift - 3);
+        }
+    } else {
+        for (int c = 0; c < 3; c++) {
+            int shift = 60 - c * 8;
+            v |= (uint64_t)fit->base[0][c] << shift;
+            v |= (uint64_t)fit->base[1][c] << (shift - 4);
+        }
+    }
+    v |= (uint64_t)fit->sub[0].table << 37;
+    v |= (uint64_t)fit->sub[1].table << 34;
+    v |= (uint64_t)fit->differential << 33;
+    v |= (uint64_t)fit->flip << 32;
+
+    for (int s = 0; s < 2; s++) {
+        const uint8_t *members = etc_subblocks[fit->flip][s];
+        for (int i = 0; i < 8; i++) {
+            int sel = fit->sub[s].selectors[i];
+            v |= (uint64_t)(sel >> 1) << (16 + members[i]);
+            v |= (uint64_t)(sel & 1) << members[i];
+        }
+    }
+
+    for (int i = 0; i < ETC_BLOCK_BYTES; i++) {
+        out[i] = (uint8_t)(v >> (56 - i * 8));
+    }
+}
+
+/* Sum of squared distances from the mean over one sub-block */
+static uint32_t subblock_spread(const uint8_t px[16][3], const uint8_t *members) {
+    uint32_t spread = 0;
+    for (int c = 0; c < 3; c++) {
+        int sum = 0, sum_sq = 0;
+        for (int i = 0; i < 8; i++) {
+            int v = px[members[i]][c];
+            sum += v;
+            sum_sq += v * v;
+        }
+        spread += (uint32_t)(sum_sq - sum * sum / 8);
+    }
+    return spread;
+}
+
+static void encode_block(const uint8_t px[16][3], bool thorough, uint8_t out[ETC_BLOCK_BYTES]) {
+    struct block_fit best = { .error = UINT32_MAX };
+
+    if (thorough) {
+        for (int flip = 0; flip < 2; flip++) {
+            fit_mode(px, flip, true, true, &best);
+            fit_mode(px, flip, false, true, &best);
+        }
+    } else {
+        /* Split along the axis that leaves the sub-blocks most uniform */
+        uint32_t vertical = subblock_spread(px, etc_subblocks[0][0]) +
+                            subblock_spread(px, etc_subblocks[0][1]);
+        uint32_t horizontal = subblock_spread(px, etc_subblocks[1][0]) +
+                              subblock_spread(px, etc_subblocks[1][1]);
+        bool flip = horizontal < vertical;
+        fit_mode(px, flip, true, false, &best);
+        if (best.error == UINT32_MAX) {
+            fit_mode(px, flip, false, false, &best);
+        }
+    }
+
+    pack_block(&best, out);
+}
+
+static void compress_band(void *ctx, uint32_t row_begin, uint32_t row_end) {
+    const struct compress_job *job = ctx;
+    const struct image_data *img = job->img;
+    size_t stride = (size_t)img->width * img->channels;
+
+    for (uint32_t by = row_begin; by < row_end; by++) {
+        for (uint32_t bx = 0; bx < job->blocks_x; bx++) {
+            uint8_t px[16][3];
+
+            /* Edge blocks repeat the last row and column */
+            for (uint32_t x = 0; x < 4; x++) {
+                uint32_t sx = bx * 4 + x < img->width ? bx * 4 + x : img->width - 1;
+                for (uint32_t y = 0; y < 4; y++) {
+                    uint32_t sy = by * 4 + y < img->height ? by * 4 + y : img->height - 1;
+                    memcpy(px[x * 4 + y], img->pixels + sy * stride + sx * img->channels, 3);
+                }
+            }
+
+            encode_block((const uint8_t (*)[3])px, job->thorough,
+                         job->blocks + ((size_t)by * job->blocks_x + bx) * ETC_BLOCK_BYTES);
+        }
+    }
+}
+
+static bool has_transparency(const struct image_data *img) {
+    if (img->channels != 4) {
+        return false;
+    }
+    size_t count = (size_t)img->width * img->height;
+    for (size_t i = 0; i < count; i++) {
+        if (img->pixels[i * 4 + 3] != ALPHA_OPAQUE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool texture_compress_etc2(struct image_data *img, enum texture_compression quality) {
+    if (!img || !img->pixels || img->width == 0 || img->height == 0 ||
+        quality == TEXTURE_COMPRESSION_NONE) {
+        return false;
+    }
+
+    if (has_transparency(img)) {
+        log_debug("Not compressing %s: ETC2 RGB8 has no alpha", img->path);
+        return false;
+    }
+
+    uint32_t blocks_x = (img->width + 3) / 4;
+    uint32_t blocks_y = (img->height + 3) / 4;
+    size_t size = (size_t)blocks_x * blocks_y * ETC_BLOCK_BYTES;
+    uint8_t *blocks = malloc(size);
+    if (!blocks) {
+        log_error("Failed to allocate %zu bytes for ETC2 data", size);
+        return false;
+    }
+
+    uint64_t start = get_time_ms();
+    struct compress_job job = {
+        .img = img,
+        .blocks = blocks,
+        .blocks_x = blocks_x,
+        .thorough = quality == TEXTURE_COMPRESSION_QUALITY,
+    };
+    parallel_bands(blocks_y, IMAGE_BAND_MIN_ROWS / 4, compress_band, &job);
+
+    uint64_t rgba_size = (uint64_t)img->width * img->height * 4;
+    log_debug("ETC2 encoded %ux%u (%s) in %lums: %zu KB instead of %lu KB",
+              img->width, img->height, job.thorough ? "quality" : "fast",
+              (unsigned long)(get_time_ms() - start), size / 1024,
+              (unsigned long)(rgba_size / 1024));
+
+    image_free_pixels(img);
+    img->compressed = blocks;
+    img->compressed_size = size;
+    return true;
+}
+
+void texture_compress_track(GLuint texture, const struct image_data *img) {
+    struct tracked_texture *entry = malloc(sizeof(*entry));
+    if (!entry) {
+        return;
+    }
+    entry->texture = texture;
+    entry->compressed_size = img->compressed_size;
+    entry->rgba_size = (uint64_t)img->width * img->height * 4;
+
+    pthread_mutex_lock(&tracked_lock);
+    entry->next = tracked;
+    tracked = entry;
+    compressed_textures++;
+    compressed_total += entry->compressed_size;
+    rgba_total += entry->rgba_size;
+    pthread_mutex_unlock(&tracked_lock);
+}
+
+void texture_compress_untrack(GLuint texture) {
+    pthread_mutex_lock(&tracked_lock);
+    for (struct tracked_texture **link = &tracked; *link; link = &(*link)->next) {
+        struct tracked_texture *entry = *link;
+        if (entry->texture == texture) {
+            *link = entry->next;
+            compressed_textures--;
+            compressed_total -= entry->compressed_size;
+            rgba_total -= entry->rgba_size;
+            free(entry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tracked_lock);
+}
+
+void texture_compress_get_stats(unsigned long *textures, uint64_t *compressed_bytes,
+                                uint64_t *rgba_bytes) {
+    pthread_mutex_lock(&tracked_lock);
+    *textures = compressed_textures;
+    *compressed_bytes = compressed_total;
+    *rgba_bytes = rgba_total;
+    pthread_mutex_unlock(&tracked_lock);
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_GLES30
+#include <GLES3/gl3.h>
+#endif
+#include "neowall.h"
+#include "constants.h"
+#include "texture_stream.h"
+#include "gl_debug.h"
+
+#ifdef HAVE_GLES30
+
+struct texture_stream {
+    struct image_data *img;
+    GLuint texture;
+    GLuint pbo;
+    GLenum format;
+    size_t row_bytes;
+    uint32_t band_rows;     /* Rows per band (the PBO holds one band) */
+    uint32_t next_row;      /* First row not uploaded yet */
+};
+
+struct texture_stream *texture_stream_begin(struct image_data *img) {
+    /* ETC2 images carry no pixels - at an eighth of the size they go up in one call */
+    if (!img || !img->pixels || img->width == 0 || img->height == 0) {
+        return NULL;
+    }
+
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (!version || !strstr(version, "OpenGL ES 3")) {
+        return NULL;
+    }
+
+    struct texture_stream *stream = calloc(1, sizeof(*stream));
+    if (!stream) {
+        return NULL;
+    }
+    gl_debug_clear();
+    stream->img = img;
+    stream->format = (img->channels == 4) ? GL_RGBA : GL_RGB;
+    stream->row_bytes = (size_t)img->width * img->channels;
+    stream->band_rows = (uint32_t)(TEXTURE_UPLOAD_BAND_BYTES / stream->row_bytes);
+    if (stream->band_rows == 0) {
+        stream->band_rows = 1;
+    }
+    if (stream->band_rows > img->height) {
+        stream->band_rows = img->height;
+    }
+
+    /* Allocate storage only - no pixel transfer yet */
+    glGenTextures(1, &stream->texture);
+    glBindTexture(GL_TEXTURE_2D, stream->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)stream->format, (GLsizei)img->width, (GLsizei)img->height,
+                 0, stream->format, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(1, &stream->pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)(stream->row_bytes * stream->band_rows),
+                 NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        stream->img = NULL;  /* Still the caller's */
+        texture_stream_abort(stream);
+        return NULL;
+    }
+
+    log_debug("Streaming texture %u (%ux%u) in bands of %u rows",
+              stream->texture, img->width, img->height, stream->band_rows);
+    return stream;
+}
+
+bool texture_stream_step(struct texture_stream *stream, size_t budget_bytes, uint64_t budget_ms) {
+    struct image_data *img = stream->img;
+    uint64_t start = get_time_ms();
+    size_t uploaded = 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->pbo);
+    glBindTexture(GL_TEXTURE_2D, stream->texture);
+    /* RGB rows are not 4-byte aligned in general */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    while (stream->next_row < img->height) {
+        uint32_t rows = stream->band_rows;
+        if (rows > img->height - stream->next_row) {
+            rows = img->height - stream->next_row;
+        }
+        size_t bytes = stream->row_bytes * rows;
+
+        /* Invalidating lets the driver hand out fresh storage while the
+         * previous band is still being copied */
+        void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!dst) {
+            /* Mapping failed - upload this band from client memory instead */
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)stream->next_row, (GLsizei)img->width,
+                            (GLsizei)rows, stream->format, GL_UNSIGNED_BYTE,
+                            img->pixels + stream->row_bytes * stream->next_row);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->pbo);
+        } else {
+            memcpy(dst, img->pixels + stream->row_bytes * stream->next_row, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)stream->next_row, (GLsizei)img->width,
+                            (GLsizei)rows, stream->format, GL_UNSIGNED_BYTE, (const void *)0);
+        }
+
+        stream->next_row += rows;
+        uploaded += bytes;
+        if (uploaded >= budget_bytes || get_time_ms() - start >= budget_ms) {
+            break;
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return stream->next_row >= img->height;
+}
+
+GLuint texture_stream_finish(struct texture_stream *stream, struct image_data **img) {
+    GLuint texture = stream->texture;
+    glDeleteBuffers(1, &stream->pbo);
+
+    log_debug("Streamed texture %u complete (%ux%u)", texture, stream->img->width, stream->img->height);
+    image_free_pixels(stream->img);
+    *img = stream->img;
+    free(stream);
+    return texture;
+}
+
+void texture_stream_abort(struct texture_stream *stream) {
+    if (!stream) {
+        return;
+    }
+    if (stream->pbo) {
+        glDeleteBuffers(1, &stream->pbo);
+    }
+    if (stream->texture) {
+        glDeleteTextures(1, &stream->texture);
+    }
+    if (stream->img) {
+        image_free(stream->img);
+    }
+    free(stream);
+}
+
+#else /* !HAVE_GLES30 */
+
+struct texture_stream *texture_stream_begin(struct image_data *img) {
+    (void)img;
+    return NULL;
+}
+
+bool texture_stream_step(struct texture_stream *stream, size_t budget_bytes, uint64_t budget_ms) {
+    (void)stream;
+    (void)budget_bytes;
+    (void)budget_ms;
+    return true;
+}
+
+GLuint texture_stream_finish(struct texture_stream *stream, struct image_data **img) {
+    (void)stream;
+    *img = NULL;
+    return 0;
+}
+
+void texture_stream_abort(struct texture_stream *stream) {
+    (void)stream;
+}
+
+#endif /* HAVE_GLES30 */
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include "neowall.h"
+#include "texture_uploader.h"
+#include "texture_stream.h"
+#include "texture_cache.h"
+#include "constants.h"
+#include "egl/egl_core.h"
+#include "egl/capability.h"
+#include "gl_debug.h"
+
+struct upload_job {
+    struct output_state *output;
+    struct image_data *image;
+    char path[MAX_PATH_LENGTH];
+    bool channel;                   /* iChannel0 image rather than a wallpaper */
+    struct upload_job *next;
+};
+
+static pthread_mutex_t uploader_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t uploader_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t uploader_thread;
+static bool uploader_running = false;
+static bool uploader_stop = false;
+static struct upload_job *job_queue = NULL;
+static struct output_state *job_active = NULL;  /* Output of the upload in progress */
+static EGLDisplay uploader_display = EGL_NO_DISPLAY;
+static EGLContext uploader_context = EGL_NO_CONTEXT;
+
+static PFNEGLCREATESYNCKHRPROC create_sync = NULL;
+static PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync = NULL;
+static PFNEGLDESTROYSYNCKHRPROC destroy_sync = NULL;
+
+/* Block this thread until the upload has completed on the GPU */
+static void wait_for_upload(void) {
+    EGLSyncKHR fence = create_sync(uploader_display, EGL_SYNC_FENCE_KHR, NULL);
+    if (fence == EGL_NO_SYNC_KHR) {
+        glFinish();
+        return;
+    }
+    client_wait_sync(uploader_display, fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+    destroy_sync(uploader_display, fence);
+}
+
+/* Hand the image and its texture to the output's preload slot */
+static void publish_upload(struct output_state *output, struct image_data *image,
+                           GLuint texture, const char *path) {
+    /* Outputs waiting on the same image get it too (before taking our lock) */
+    texture_cache_insert(texture, image);
+
+    pthread_mutex_lock(&output->preload_mutex);
+    if (output->preload_decoded_image) {
+        image_free(output->preload_decoded_image);
+    }
+    if (output->preload_decoded_texture) {
+        render_destroy_texture(output->preload_decoded_texture);
+    }
+    output->preload_decoded_image = image;
+    output->preload_decoded_texture = texture;
+    strncpy(output->preload_path, path, sizeof(output->preload_path) - 1);
+    output->preload_path[sizeof(output->preload_path) - 1] = '\0';
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    atomic_store(&output->preload_upload_pending, true);
+    event_loop_wake_output(output);
+}
+
+/* Hand the iChannel0 image and its texture to the render thread, which swaps
+ * the texture in at the cycle deadline */
+static void publish_channel_upload(struct output_state *output, struct image_data *image,
+                                   GLuint texture) {
+    pthread_mutex_lock(&output->preload_mutex);
+    if (strcmp(output->channel_preload_path, image->path) != 0) {
+        /* The cycle moved on while uploading */
+        pthread_mutex_unlock(&output->preload_mutex);
+        if (texture != 0) {
+            glDeleteTextures(1, &texture);
+        }
+        image_free(image);
+        return;
+    }
+    if (output->channel_preload_image) {
+        image_free(output->channel_preload_image);
+    }
+    if (output->channel_uploaded_texture) {
+        glDeleteTextures(1, &output->channel_uploaded_texture);
+    }
+    output->channel_preload_image = image;
+    output->channel_uploaded_texture = texture;
+    pthread_mutex_unlock(&output->preload_mutex);
+
+    atomic_store(&output->channel_upload_pending, true);
+    atomic_store(&output->preload_upload_pending, true);
+    event_loop_wake_output(output);
+}
+
+static void *uploader_thread_func(void *arg) {
+    (void)arg;
+
+    if (!eglMakeCurrent(uploader_display, EGL_NO_SURFACE, EGL_NO_SURFACE, uploader_context)) {
+        log_error("Texture uploader: failed to make context current: 0x%x", eglGetError());
+        pthread_mutex_lock(&uploader_lock);
+        uploader_stop = true;  /* Submissions fall back to render-thread uploads */
+        pthread_mutex_unlock(&uploader_lock);
+        return NULL;
+    }
+    gl_debug_setup_context();
+
+    pthread_mutex_lock(&uploader_lock);
+    while (!uploader_stop) {
+        struct upload_job *job = job_queue;
+        if (!job) {
+            pthread_cond_wait(&uploader_cond, &uploader_lock);
+            continue;
+        }
+        job_queue = job->next;
+        job_active = job->output;
+        pthread_mutex_unlock(&uploader_lock);
+
+        uint64_t start = get_time_ms();
+        uint32_t width = job->image->width, height = job->image->height;
+        GLuint texture = 0;
+        struct texture_stream *stream = job->channel ? NULL : texture_stream_begin(job->image);
+        if (job->channel) {
+            texture = render_create_channel_texture(job->output, 0, job->image);
+        } else if (stream) {
+            /* Flush band by band so render contexts' work interleaves with the copy */
+            while (!texture_stream_step(stream, TEXTURE_UPLOAD_BAND_BYTES, TEXTURE_UPLOAD_BUDGET_MS)) {
+                glFlush();
+            }
+            texture = texture_stream_finish(stream, &job->image);
+        } else {
+            texture = render_create_texture(job->image);
+        }
+        if (texture != 0) {
+            wait_for_upload();
+            log_debug("Texture uploader: %s (%ux%u) uploaded in %lums",
+                      job->path, width, height, (unsigned long)(get_time_ms() - start));
+        } else {
+            /* Pixels are kept on failure - the render thread retries the upload */
+            log_error("Texture uploader: failed to upload %s", job->path);
+        }
+        if (job->channel) {
+            publish_channel_upload(job->output, job->image, texture);
+        } else {
+            publish_upload(job->output, job->image, texture, job->path);
+        }
+
+        pthread_mutex_lock(&uploader_lock);
+        job_active = NULL;
+        pthread_cond_broadcast(&uploader_cond);
+        free(job);
+    }
+    pthread_mutex_unlock(&uploader_lock);
+
+    eglMakeCurrent(uploader_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+    return NULL;
+}
+
+bool texture_uploader_start(struct neowall_state *state) {
+    if (uploader_running) {
+        return true;
+    }
+
+    if (!state->gl_caps.has_egl_khr_fence_sync ||
+        !egl_has_extension(state->egl_display, "EGL_KHR_surfaceless_context")) {
+        log_info("EGL fence sync or surfaceless contexts unavailable, textures upload on the render thread");
+        return false;
+    }
+
+    create_sync = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    client_wait_sync = (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+    destroy_sync = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    if (!create_sync || !client_wait_sync || !destroy_sync) {
+        log_error("EGL_KHR_fence_sync advertised but its entry points are missing");
+        return false;
+    }
+
+    uploader_context = egl_core_create_shared_context(state);
+    if (uploader_context == EGL_NO_CONTEXT) {
+        log_error("Failed to create texture uploader context: 0x%x", eglGetError());
+        return false;
+    }
+    uploader_display = state->egl_display;
+    uploader_stop = false;
+
+    if (pthread_create(&uploader_thread, NULL, uploader_thread_func, NULL) != 0) {
+        log_error("Failed to start texture uploader thread");
+        eglDestroyContext(uploader_display, uploader_context);
+        uploader_context = EGL_NO_CONTEXT;
+        return false;
+    }
+
+    uploader_running = true;
+    log_debug("Background texture uploader started");
+    return true;
+}
+
+void texture_uploader_stop(void) {
+    if (!uploader_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&uploader_lock);
+    uploader_stop = true;
+    pthread_cond_broadcast(&uploader_cond);
+    pthread_mutex_unlock(&uploader_lock);
+    pthread_join(uploader_thread, NULL);
+
+    while (job_queue) {
+        struct upload_job *next = job_queue->next;
+        image_free(job_queue->image);
+        free(job_queue);
+        job_queue = next;
+    }
+
+    eglDestroyContext(uploader_display, uploader_context);
+    uploader_context = EGL_NO_CONTEXT;
+    uploader_running = false;
+}
+
+static bool submit_job(struct output_state *output, struct image_data *image,
+                       const char *path, bool channel) {
+    if (!uploader_running || !output || !image || !path) {
+        return false;
+    }
+
+    struct upload_job *job = calloc(1, sizeof(*job));
+    if (!job) {
+        log_error("Failed to allocate texture upload job");
+        return false;
+    }
+    job->output = output;
+    job->image = image;
+    job->channel = channel;
+    strncpy(job->path, path, sizeof(job->path) - 1);
+
+    pthread_mutex_lock(&uploader_lock);
+    if (uploader_stop) {
+        pthread_mutex_unlock(&uploader_lock);
+        free(job);
+        return false;
+    }
+    struct upload_job **tail = &job_queue;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = job;
+    pthread_cond_signal(&uploader_cond);
+    pthread_mutex_unlock(&uploader_lock);
+    return true;
+}
+
+bool texture_uploader_submit(struct output_state *output, struct image_data *image,
+                             const char *path) {
+    return submit_job(output, image, path, false);
+}
+
+bool texture_uploader_submit_channel(struct output_state *output, struct image_data *image) {
+    return submit_job(output, image, image ? image->path : NULL, true);
+}
+
+void texture_uploader_cancel(struct output_state *output) {
+    if (!output) {
+        return;
+    }
+
+    pthread_mutex_lock(&uploader_lock);
+    struct upload_job **link = &job_queue;
+    while (*link) {
+        if ((*link)->output == output) {
+            struct upload_job *job = *link;
+            *link = job->next;
+            image_free(job->image);
+            free(job);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    while (job_active == output) {
+        pthread_cond_wait(&uploader_cond, &uploader_lock);
+    }
+    pthread_mutex_unlock(&uploader_lock);
+}
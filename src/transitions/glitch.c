@@ -4,6 +4,7 @@
 #include "neowall.h"
 #include "constants.h"
 #include "transitions.h"
+#include "gl_debug.h"
 #include "shader.h"
 
 /* External functions from render.c */
@@ -130,7 +131,7 @@ bool transition_glitch_render(struct output_state *output, float progress) {
              progress, output->glitch_program);
 
     /* Clear any previous OpenGL errors */
-    while (glGetError() != GL_NO_ERROR);
+    GL_CLEAR_ERRORS();
 
     /* Set viewport */
     glViewport(0, 0, output->width, output->height);
@@ -209,9 +210,7 @@ bool transition_glitch_render(struct output_state *output, float progress) {
     glUseProgram(0);
 
     /* Check for errors */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        log_error("OpenGL error during glitch transition: 0x%x", error);
+    if (!GL_CHECK("during glitch transition")) {
         return false;
     }
 
@@ -4,6 +4,7 @@
 #include "neowall.h"
 #include "constants.h"
 #include "transitions.h"
+#include "gl_debug.h"
 #include "shader.h"
 
 /* External functions from render.c */
@@ -142,7 +143,7 @@ bool transition_pixelate_render(struct output_state *output, float progress) {
              progress, output->pixelate_program);
 
     /* Clear any previous OpenGL errors */
-    while (glGetError() != GL_NO_ERROR);
+    GL_CLEAR_ERRORS();
 
     /* Set viewport */
     glViewport(0, 0, output->width, output->height);
@@ -223,9 +224,7 @@ bool transition_pixelate_render(struct output_state *output, float progress) {
     glUseProgram(0);
 
     /* Check for errors */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        log_error("OpenGL error during pixelate transition: 0x%x", error);
+    if (!GL_CHECK("during pixelate transition")) {
         return false;
     }
 
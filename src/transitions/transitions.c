@@ -4,6 +4,7 @@
 #include "neowall.h"
 #include "constants.h"
 #include "transitions.h"
+#include "gl_debug.h"
 
 /**
  * Transition Registry
@@ -193,7 +194,7 @@ bool transition_begin(transition_context_t *ctx, struct output_state *output, GL
     ctx->error_occurred = false;
     
     /* Clear any previous OpenGL errors (critical for multi-monitor) */
-    while (glGetError() != GL_NO_ERROR);
+    GL_CLEAR_ERRORS();
     
     /* Set viewport */
     glViewport(0, 0, output->width, output->height);
@@ -289,9 +290,7 @@ bool transition_draw_textured_quad(transition_context_t *ctx, GLuint texture,
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     
     /* Check for errors */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        log_error("OpenGL error during transition draw: 0x%x", error);
+    if (!GL_CHECK("during transition draw")) {
         ctx->error_occurred = true;
         return false;
     }
@@ -337,9 +336,8 @@ void transition_end(transition_context_t *ctx) {
     glUseProgram(0);
     
     /* Final error check */
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR && !ctx->error_occurred) {
-        log_error("OpenGL error during transition cleanup: 0x%x", error);
+    if (!ctx->error_occurred) {
+        (void)GL_CHECK("during transition cleanup");
     }
     
     /* Update output state */
@@ -248,6 +248,69 @@ const char *get_state_file_path(void) {
     return state_path;
 }
 
+/* Ensure the directory holding a state file exists */
+static void ensure_state_dir(const char *state_path) {
+    char dir_path[MAX_PATH_LENGTH];
+    strncpy(dir_path, state_path, sizeof(dir_path) - 1);
+    dir_path[sizeof(dir_path) - 1] = '\0';
+    char *last_slash = strrchr(dir_path, '/');
+    if (last_slash) {
+        *last_slash = '\0';
+        /* Create directory recursively - simple approach for at most 2 levels */
+        struct stat st = {0};
+        if (stat(dir_path, &st) == -1) {
+            /* Try to create parent first */
+            char parent_path[MAX_PATH_LENGTH];
+            strncpy(parent_path, dir_path, sizeof(parent_path) - 1);
+            parent_path[sizeof(parent_path) - 1] = '\0';
+            char *parent_slash = strrchr(parent_path, '/');
+            if (parent_slash) {
+                *parent_slash = '\0';
+                mkdir(parent_path, 0755);
+            }
+            /* Now create the target directory */
+            mkdir(dir_path, 0755);
+        }
+    }
+}
+
+/* Seed of the shuffled cycle order, created on first use next to the state
+ * file so the order (and the saved cycle index into it) survives restarts */
+uint32_t get_shuffle_seed(void) {
+    static pthread_mutex_t seed_mutex = PTHREAD_MUTEX_INITIALIZER;
+    char seed_path[MAX_PATH_LENGTH + 16];
+    snprintf(seed_path, sizeof(seed_path), "%s.shuffle", get_state_file_path());
+
+    pthread_mutex_lock(&seed_mutex);
+
+    unsigned long value = 0;
+    FILE *fp = fopen(seed_path, "r");
+    if (fp) {
+        bool valid = fscanf(fp, "%lu", &value) == 1;
+        fclose(fp);
+        if (valid) {
+            pthread_mutex_unlock(&seed_mutex);
+            return (uint32_t)value;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint32_t seed = (uint32_t)ts.tv_sec ^ (uint32_t)ts.tv_nsec ^ ((uint32_t)getpid() << 16);
+
+    ensure_state_dir(seed_path);
+    fp = fopen(seed_path, "w");
+    if (fp) {
+        fprintf(fp, "%lu\n", (unsigned long)seed);
+        fclose(fp);
+    } else {
+        log_error("Failed to save shuffle seed %s: %s", seed_path, strerror(errno));
+    }
+
+    pthread_mutex_unlock(&seed_mutex);
+    return seed;
+}
+
 /* Structure to hold output state data */
 typedef struct {
     char output_name[256];
@@ -275,29 +338,7 @@ bool write_wallpaper_state(const char *output_name, const char *wallpaper_path,
     /* Acquire lock before file operations */
     pthread_mutex_lock(&state_file_mutex);
     
-    /* Ensure state directory exists */
-    char dir_path[MAX_PATH_LENGTH];
-    strncpy(dir_path, state_path, sizeof(dir_path) - 1);
-    dir_path[sizeof(dir_path) - 1] = '\0';
-    char *last_slash = strrchr(dir_path, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-        /* Create directory recursively - simple approach for at most 2 levels */
-        struct stat st = {0};
-        if (stat(dir_path, &st) == -1) {
-            /* Try to create parent first */
-            char parent_path[MAX_PATH_LENGTH];
-            strncpy(parent_path, dir_path, sizeof(parent_path) - 1);
-            parent_path[sizeof(parent_path) - 1] = '\0';
-            char *parent_slash = strrchr(parent_path, '/');
-            if (parent_slash) {
-                *parent_slash = '\0';
-                mkdir(parent_path, 0755);
-            }
-            /* Now create the target directory */
-            mkdir(dir_path, 0755);
-        }
-    }
+    ensure_state_dir(state_path);
     
     /* Read existing states from file */
     output_state_entry_t states[MAX_OUTPUTS];